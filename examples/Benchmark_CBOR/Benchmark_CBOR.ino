@@ -0,0 +1,145 @@
+/********************************************************************************
+ * Benchmark of the encoding of the records in CBOR and JSON (no module needed) *
+ *                                                                              *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM800L.h"
+#include "SIM800LCbor.h"
+
+#define ITERATIONS 500
+
+// Typical record of a sensor
+struct Record {
+  const char* id;
+  uint32_t timestamp;
+  float temperature;
+  float humidity;
+  float pressure;
+  float battery;
+  int16_t rssi;
+  bool door;
+};
+
+Record record = {"dev-042", 1700000000UL, 21.5, 48.25, 1013.2, 3.71, -71, true};
+
+// Encode the record in CBOR
+void encodeCbor(SIM800LCborEncoder* encoder, void* context) {
+  Record* r = (Record*) context;
+  encoder->beginMap(8);
+  encoder->addString("id", r->id);
+  encoder->addUInt("ts", r->timestamp);
+  encoder->addFloat("t", r->temperature);
+  encoder->addFloat("h", r->humidity);
+  encoder->addFloat("p", r->pressure);
+  encoder->addFloat("bat", r->battery);
+  encoder->addInt("rssi", r->rssi);
+  encoder->addBool("door", r->door);
+}
+
+// Encode the record in CBOR as an array (the fields are identified by their position)
+void encodeCborArray(SIM800LCborEncoder* encoder, void* context) {
+  Record* r = (Record*) context;
+  encoder->beginArray(8);
+  encoder->writeString(r->id);
+  encoder->writeUInt(r->timestamp);
+  encoder->writeFloat(r->temperature);
+  encoder->writeFloat(r->humidity);
+  encoder->writeFloat(r->pressure);
+  encoder->writeFloat(r->battery);
+  encoder->writeInt(r->rssi);
+  encoder->writeBool(r->door);
+}
+
+// Encode the same record in JSON, as usually done for doPost()
+uint16_t encodeJson(Record* r, char* buffer, uint16_t size) {
+  char temperature[10], humidity[10], pressure[10], battery[10];
+  dtostrf(r->temperature, 1, 2, temperature);
+  dtostrf(r->humidity, 1, 2, humidity);
+  dtostrf(r->pressure, 1, 2, pressure);
+  dtostrf(r->battery, 1, 2, battery);
+  return snprintf_P(buffer, size, PSTR("{\"id\":\"%s\",\"ts\":%lu,\"t\":%s,\"h\":%s,\"p\":%s,\"bat\":%s,\"rssi\":%d,\"door\":%s}"),
+    r->id, (unsigned long)r->timestamp, temperature, humidity, pressure, battery, r->rssi, r->door ? "true" : "false");
+}
+
+void setup() {
+  // Initialize Serial Monitor for the results
+  Serial.begin(115200);
+  while(!Serial);
+
+  Serial.println(F("Benchmark of the encoding of a record (size on the wire and time)"));
+
+  // JSON built with snprintf()
+  char json[128];
+  uint16_t jsonLength = 0;
+  uint32_t start = micros();
+  for(uint16_t i = 0; i < ITERATIONS; i++) {
+    jsonLength = encodeJson(&record, json, sizeof(json));
+  }
+  printResult(F("JSON"), jsonLength, micros() - start, jsonLength);
+
+  // CBOR in a buffer
+  uint8_t cbor[64];
+  uint16_t cborLength = 0;
+  start = micros();
+  for(uint16_t i = 0; i < ITERATIONS; i++) {
+    SIM800LCborEncoder encoder(cbor, sizeof(cbor));
+    encodeCbor(&encoder, &record);
+    cborLength = encoder.getLength();
+  }
+  printResult(F("CBOR map"), cborLength, micros() - start, jsonLength);
+
+  // CBOR array in a buffer
+  start = micros();
+  for(uint16_t i = 0; i < ITERATIONS; i++) {
+    SIM800LCborEncoder encoder(cbor, sizeof(cbor));
+    encodeCborArray(&encoder, &record);
+    cborLength = encoder.getLength();
+  }
+  printResult(F("CBOR array"), cborLength, micros() - start, jsonLength);
+
+  // CBOR length counted before being written straight to the module by SIM800LCborPayload
+  SIM800LCborPayload payload(encodeCbor, &record);
+  start = micros();
+  for(uint16_t i = 0; i < ITERATIONS; i++) {
+    cborLength = payload.getLength();
+  }
+  printResult(F("CBOR map (length only)"), cborLength, micros() - start, jsonLength);
+}
+
+void loop() {
+}
+
+// Print the size (and the ratio to JSON) and the encoding time of a record
+void printResult(const __FlashStringHelper* name, uint16_t length, uint32_t elapsedUs, uint16_t jsonLength) {
+  Serial.print(name);
+  Serial.print(F(" : "));
+  Serial.print(length);
+  Serial.print(F(" bytes (x"));
+  Serial.print((float)jsonLength / length);
+  Serial.print(F(" smaller than JSON), "));
+  Serial.print(elapsedUs / ITERATIONS);
+  Serial.println(F(" us per record"));
+}
@@ -0,0 +1,122 @@
+/********************************************************************************
+ * Benchmark of the parsing of the answers of the module (no module required)   *
+ *                                                                              *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM800L.h"
+#include "SIM800LRing.h"
+
+#define ITERATIONS 500
+
+// Typical answer of the module parsed by the driver
+const char ANSWER[] PROGMEM = "\r\n+HTTPACTION: 0,200,1024\r\n";
+#define ANSWER_LENGTH (sizeof(ANSWER) - 1)
+
+// Stream replaying the answer from the flash endlessly once enabled (the bytes sent are ignored)
+class ReplayStream : public Stream {
+  public:
+    int available() { return replay ? 1 : 0; }
+    int read() { uint8_t c = pgm_read_byte(ANSWER + position); position = (position + 1) % ANSWER_LENGTH; return c; }
+    int peek() { return pgm_read_byte(ANSWER + position); }
+    size_t write(uint8_t c) { return 1; }
+    bool replay = false;
+    uint16_t position = 0;
+};
+
+// Access to the parsing methods of the driver
+class BenchSIM800L : public SIM800L {
+  public:
+    BenchSIM800L(Stream* stream) : SIM800L(stream, RESET_PIN_NOT_USED, 200, 64) {}
+    BenchSIM800L(SIM800LRing* ring) : SIM800L(ring, RESET_PIN_NOT_USED, 200, 64) {}
+    using SIM800L::readResponse;
+    using SIM800L::strIndex;
+};
+
+ReplayStream replayStream;
+ReplayStream silentStream;
+
+void setup() {
+  // Initialize Serial Monitor for the results
+  Serial.begin(115200);
+  while(!Serial);
+
+  Serial.println(F("Benchmark of the parsing (CPU cycles per byte)"));
+
+  // Answers read byte by byte through the Stream interface
+  BenchSIM800L* byStream = new BenchSIM800L(&replayStream);
+  replayStream.replay = true;
+  uint32_t start = micros();
+  for(uint16_t i = 0; i < ITERATIONS; i++) {
+    byStream->readResponse(DEFAULT_TIMEOUT);
+  }
+  printResult(F("readResponse() by stream"), micros() - start, (uint32_t)ITERATIONS * ANSWER_LENGTH);
+  delete byStream;
+
+  // Answers stored in the ring buffer (as by the interrupt of the UART) and parsed by spans
+  SIM800LRing* ring = new SIM800LRing(&silentStream, 64);
+  ring->setPushMode(true);
+  BenchSIM800L* byRing = new BenchSIM800L(ring);
+  uint32_t elapsed = 0;
+  for(uint16_t i = 0; i < ITERATIONS; i++) {
+    for(uint16_t j = 0; j < ANSWER_LENGTH; j++) {
+      ring->push(pgm_read_byte(ANSWER + j));
+    }
+    start = micros();
+    byRing->readResponse(DEFAULT_TIMEOUT);
+    elapsed += micros() - start;
+  }
+  printResult(F("readResponse() by ring"), elapsed, (uint32_t)ITERATIONS * ANSWER_LENGTH);
+
+  // Search of the answer in the internal buffer (the results are accumulated in a volatile
+  // sink and printed, so that the calls are not removed by the optimizer)
+  char answer[ANSWER_LENGTH + 1];
+  strcpy_P(answer, ANSWER);
+  volatile int32_t sink = 0;
+  start = micros();
+  for(uint16_t i = 0; i < ITERATIONS; i++) {
+    sink = sink + byRing->strIndex(answer, "1024");
+  }
+  printResult(F("strIndex()"), micros() - start, (uint32_t)ITERATIONS * ANSWER_LENGTH);
+  Serial.print(F("strIndex() checksum : "));
+  Serial.println(sink);
+  delete byRing;
+  delete ring;
+}
+
+void loop() {
+}
+
+// Print the CPU cycles per byte of a benchmark
+void printResult(const __FlashStringHelper* name, uint32_t elapsedUs, uint32_t bytes) {
+  Serial.print(name);
+  Serial.print(F(" : "));
+  Serial.print(elapsedUs * (F_CPU / 1000000UL) / bytes);
+  Serial.print(F(" cycles/byte ("));
+  Serial.print(elapsedUs);
+  Serial.print(F(" us for "));
+  Serial.print(bytes);
+  Serial.println(F(" bytes)"));
+}
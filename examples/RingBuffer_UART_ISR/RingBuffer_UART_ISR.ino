@@ -0,0 +1,142 @@
+/********************************************************************************
+ * HTTP GET with the bytes received stored by the interrupt of the UART (Mega)  *
+ *                                                                              *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM800L.h"
+#include "SIM800LRing.h"
+
+#if !defined(__AVR_ATmega2560__)
+#error "This example drives the USART1 of the ATmega2560 (Arduino Mega) directly"
+#endif
+
+#define SIM800_RST_PIN 6
+#define SIM800_BAUD 57600
+
+const char APN[] = "Internet.be";
+const char URL[] = "https://postman-echo.com/get?foo1=bar1&foo2=bar2";
+
+// Transmission on the USART1 (TX1/RX1 pins). The reception is done by the interrupt below,
+// so Serial1 must not be used in this sketch (its interrupt would be defined twice).
+class Usart1 : public Stream {
+  public:
+    void begin(uint32_t baud) {
+      // Double speed, 8 bits, no parity, 1 stop bit, interrupt on reception
+      uint16_t ubrr = (F_CPU / 8 / baud) - 1;
+      UCSR1A = _BV(U2X1);
+      UBRR1H = ubrr >> 8;
+      UBRR1L = ubrr;
+      UCSR1C = _BV(UCSZ11) | _BV(UCSZ10);
+      UCSR1B = _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+    }
+
+    size_t write(uint8_t c) {
+      while(!(UCSR1A & _BV(UDRE1)));
+      UDR1 = c;
+      return 1;
+    }
+
+    // The bytes received are read through the ring buffer
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+};
+
+Usart1 usart1;
+SIM800LRing* ring;
+SIM800L* sim800l;
+
+// Each byte received by the UART is stored in the ring buffer (the only producer)
+ISR(USART1_RX_vect) {
+  ring->push(UDR1);
+}
+
+void setup() {
+  // Initialize Serial Monitor for debugging
+  Serial.begin(115200);
+  while(!Serial);
+
+  // Ring buffer of 1024 bytes filled by the interrupt only (pump() disabled), created
+  // before the interrupt is enabled
+  ring = new SIM800LRing(&usart1, 1024);
+  ring->setPushMode(true);
+  usart1.begin(SIM800_BAUD);
+  delay(1000);
+
+  // Initialize SIM800L driver on the ring buffer with an internal buffer of 200 bytes and a reception buffer of 512 bytes
+  sim800l = new SIM800L(ring, SIM800_RST_PIN, 200, 512);
+
+  // Wait until the module is ready to accept AT commands
+  while(!sim800l->isReady()) {
+    Serial.println(F("Problem to initialize AT command, retry in 1 sec"));
+    delay(1000);
+  }
+
+  // Wait for the operator network registration and setup the GPRS
+  NetworkRegistration network = sim800l->getRegistrationStatus();
+  while(network != REGISTERED_HOME && network != REGISTERED_ROAMING) {
+    delay(1000);
+    network = sim800l->getRegistrationStatus();
+  }
+  while(!sim800l->setupGPRS(APN)) {
+    delay(5000);
+  }
+  Serial.println(F("Setup Complete!"));
+}
+
+void loop() {
+  // Establish GPRS connectivity (5 trials)
+  bool connected = false;
+  for(uint8_t i = 0; i < 5 && !connected; i++) {
+    delay(1000);
+    connected = sim800l->connectGPRS();
+  }
+  if(!connected) {
+    Serial.println(F("GPRS not connected !"));
+    return;
+  }
+
+  // Do HTTP GET communication with 10s for the timeout (read)
+  uint16_t rc = sim800l->doGet(URL, 10000);
+  if(rc == 200) {
+    Serial.print(F("HTTP GET successful ("));
+    Serial.print(sim800l->getDataSizeReceived());
+    Serial.println(F(" bytes)"));
+    Serial.println(sim800l->getDataReceived());
+  } else {
+    Serial.print(F("HTTP GET error "));
+    Serial.println(rc);
+  }
+
+  // Bytes lost because the ring buffer was full (increase its size if not 0)
+  Serial.print(F("Bytes lost: "));
+  Serial.println(ring->getOverflowCount());
+
+  sim800l->disconnectGPRS();
+
+  // End of program... wait...
+  while(1);
+}
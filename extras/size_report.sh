@@ -0,0 +1,103 @@
+#!/bin/sh
+################################################################################
+# Size report of the Arduino-SIM800L-driver per feature                        #
+#                                                                              #
+# Compile a sketch for each feature of the library with avr-gcc (through       #
+# arduino-cli) and print the flash and the static RAM used, with the delta     #
+# against the sketch using only the core of the driver. The largest stack      #
+# frames of the library are given by -fstack-usage.                            #
+#                                                                              #
+# Usage: extras/size_report.sh [fqbn]       (default: arduino:avr:uno)         #
+# Requirements: arduino-cli with the core of the board installed               #
+################################################################################
+
+fqbn=${1:-arduino:avr:uno}
+repo=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+if ! command -v arduino-cli > /dev/null; then
+  echo "arduino-cli is required (https://arduino.github.io/arduino-cli/)"
+  exit 1
+fi
+
+coreFlash=0
+coreRam=0
+
+# Compile a sketch with the feature and print its size
+# Parameters: name, global declarations, body of setup()
+feature() {
+  name=$1
+  mkdir -p "$work/$name"
+  cat > "$work/$name/$name.ino" <<SKETCH
+#include "SIM800L.h"
+$2
+
+SIM800L* sim800l;
+
+void setup() {
+  Serial.begin(9600);
+  sim800l = new SIM800L((Stream *)&Serial, 6, 200, 512);
+  $3
+}
+
+void loop() {
+}
+SKETCH
+
+  if ! output=$(arduino-cli compile --fqbn "$fqbn" --library "$repo" --build-path "$work/$name/build" \
+      --build-property "compiler.cpp.extra_flags=-fstack-usage" "$work/$name" 2>&1); then
+    echo "$name : compilation failed"
+    echo "$output"
+    exit 1
+  fi
+
+  flash=$(echo "$output" | sed -n 's/^Sketch uses \([0-9]*\) bytes.*/\1/p')
+  ram=$(echo "$output" | sed -n 's/^Global variables use \([0-9]*\) bytes.*/\1/p')
+  if [ "$name" = "core" ]; then
+    coreFlash=$flash
+    coreRam=$ram
+  fi
+  printf "%-16s %8s %8s %8s %8s\n" "$name" "$flash" "$ram" "+$((flash - coreFlash))" "+$((ram - coreRam))"
+}
+
+echo "Board: $fqbn"
+printf "%-16s %8s %8s %8s %8s\n" "Feature" "Flash" "RAM" "dFlash" "dRAM"
+
+feature core "" \
+  "sim800l->isReady();"
+feature http_get "" \
+  "sim800l->doGet(\"http://example.com\", 10000);"
+feature http_post "" \
+  "sim800l->doPost(\"http://example.com\", \"text/plain\", \"data\", 10000, 10000);"
+feature http_flash "" \
+  "sim800l->doGet(F(\"http://example.com\"), 10000);"
+feature http_retry "" \
+  "sim800l->setRetryPolicy(3); sim800l->doGet(\"http://example.com\", 10000); sim800l->getLastError();"
+feature gprs "" \
+  "sim800l->setupGPRS(\"apn\"); sim800l->connectGPRS(); sim800l->disconnectGPRS();"
+feature download "struct Sink : SIM800LSink { bool write(uint32_t o, const uint8_t* d, uint16_t l) { return true; } } sink; SIM800LDownload state;" \
+  "sim800l->doDownload(\"http://example.com\", &sink, &state, 256, 10000);"
+feature ftp "struct Sink : SIM800LSink { bool write(uint32_t o, const uint8_t* d, uint16_t l) { return true; } } sink;" \
+  "sim800l->setupFTP(\"example.com\", 21, \"user\", \"pwd\"); sim800l->ftpGet(\"/\", \"file\", &sink, 128, 10000);"
+feature sms "" \
+  "sim800l->setupSMS(); sim800l->sendSMS(\"+32470000000\", \"Hello\");"
+feature sleep "" \
+  "sim800l->enableSleep(); sim800l->sleep(); sim800l->getEstimatedCharge();"
+feature json "#include \"SIM800LJson.h\"
+SIM800LJsonScanner scanner; char value[16];" \
+  "scanner.addPath(\"a.b\", value, sizeof(value)); sim800l->setResponseSink(&scanner); sim800l->doGet(\"http://example.com\", 10000);"
+feature cbor "#include \"SIM800LCbor.h\"
+void encode(SIM800LCborEncoder* e, void* c) { e->beginMap(2); e->addFloat(\"t\", 21.5); e->addInt(\"rssi\", -71); }
+SIM800LCborPayload payload(encode);" \
+  "sim800l->doPost(\"http://example.com\", NULL, &payload, 10000, 10000);"
+feature ring "#include \"SIM800LRing.h\"" \
+  "sim800l = new SIM800L(new SIM800LRing((Stream *)&Serial, 256), 6, 200, 512); sim800l->doGet(\"http://example.com\", 10000);"
+feature transcript "#include \"SIM800LTranscript.h\"" \
+  "sim800l = new SIM800L((Stream *)new SIM800LTranscript((Stream *)&Serial, &Serial), 6, 200, 512); sim800l->isReady();"
+
+# Largest stack frames of the library (bytes, static or dynamic)
+echo
+echo "Largest stack frames of the library:"
+find "$work" -path '*libraries*' -name '*.su' -exec cat {} + | sort -u | sort -t "$(printf '\t')" -k2 -n -r | head -10 \
+  | awk -F '\t' '{ sub(/^[^:]*:[0-9]+:[0-9]+:/, "", $1); printf "%6s  %s\n", $2, $1 }'
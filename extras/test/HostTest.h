@@ -0,0 +1,159 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Helpers of the host tests: a scripted SIM800L module and the check macro
+#ifndef _SIM800L_HOST_TEST_H_
+#define _SIM800L_HOST_TEST_H_
+
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+#include <string>
+#include <utility>
+
+// Stop the test with the location of the first failed check
+#define CHECK(condition) do { \
+    if(!(condition)) { \
+      printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #condition); \
+      exit(1); \
+    } \
+  } while(0)
+
+// Emulated module: each command line (or raw block after a prompt) written by the driver
+// is given to a handler which returns the answer. Answers can also be scheduled later on
+// the simulated clock, like the URC of the module.
+class FakeModem : public Stream {
+  public:
+    // Answer to a command line (without CR LF)
+    std::function<std::string(const std::string&)> onLine;
+    // Answer to a raw block (rawExpected bytes, or data terminated by Ctrl-Z)
+    std::function<std::string(const std::string&)> onRaw;
+    size_t rawExpected = 0;
+
+    // Echo the commands (ATE1)
+    bool echo = false;
+
+    // Everything written by the driver
+    std::string log;
+
+    // Schedule an answer after a delay in millisec (kept ordered by time)
+    void answer(const std::string& s, unsigned long after = 2) {
+      if(s.empty()) {
+        return;
+      }
+      std::deque<std::pair<unsigned long, std::string> >::iterator it = pending.end();
+      while(it != pending.begin() && (it - 1)->first > fakeNow + after) {
+        --it;
+      }
+      pending.insert(it, std::make_pair(fakeNow + after, s));
+    }
+
+    // Check if an answer is still scheduled
+    bool isPending() {
+      return !pending.empty();
+    }
+
+    size_t write(uint8_t c) {
+      log += (char)c;
+      if(rawExpected > 0) {
+        raw += (char)c;
+        if(--rawExpected == 0) {
+          answer(onRaw(raw));
+          raw.clear();
+        }
+        return 1;
+      }
+
+      line += (char)c;
+      if(line.size() >= 2 && line.compare(line.size() - 2, 2, "\r\n") == 0) {
+        std::string command = line.substr(0, line.size() - 2);
+        line.clear();
+        answer((echo ? command + "\r\r\n" : std::string()) + onLine(command));
+      } else if(line[line.size() - 1] == 0x1A) {
+        std::string block = line.substr(0, line.size() - 1);
+        line.clear();
+        answer(onRaw(block));
+      }
+      return 1;
+    }
+
+    int available() {
+      deliver();
+      return rx.size();
+    }
+
+    int read() {
+      deliver();
+      if(rx.empty()) {
+        return -1;
+      }
+      int c = (uint8_t)rx[0];
+      rx.erase(0, 1);
+      return c;
+    }
+
+    int peek() {
+      deliver();
+      return rx.empty() ? -1 : (uint8_t)rx[0];
+    }
+
+  private:
+    // Move the answers due on the simulated clock to the reception
+    void deliver() {
+      while(!pending.empty() && pending.front().first <= fakeNow) {
+        rx += pending.front().second;
+        pending.pop_front();
+      }
+    }
+
+    std::string line;
+    std::string raw;
+    std::string rx;
+    std::deque<std::pair<unsigned long, std::string> > pending;
+};
+
+// Debug output of the driver, printed on stdout if the environment variable DEBUG is set
+class DebugOutput : public Stream {
+  public:
+    size_t write(uint8_t c) {
+      if(enabled) {
+        putchar(c);
+      }
+      return 1;
+    }
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+
+  private:
+    bool enabled = getenv("DEBUG") != NULL;
+};
+
+#endif // _SIM800L_HOST_TEST_H_
@@ -0,0 +1,141 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Benchmark of the encoding of a record on the host (no module needed): size on the wire
+// and time of the CBOR encoder (map, array, length only for SIM800LCborPayload) against
+// the same record in JSON built with snprintf(), like the example Benchmark_CBOR on the
+// board. The time is measured with the clock of the host.
+#include <chrono>
+#include "HostTest.h"
+#include "SIM800LCbor.h"
+
+#define ITERATIONS 200000
+
+// Typical record of a sensor
+struct Record {
+  const char* id;
+  uint32_t timestamp;
+  float temperature;
+  float humidity;
+  float pressure;
+  float battery;
+  int16_t rssi;
+  bool door;
+};
+
+Record record = {"dev-042", 1700000000UL, 21.5, 48.25, 1013.2, 3.71, -71, true};
+
+// Encode the record in CBOR
+void encodeCbor(SIM800LCborEncoder* encoder, void* context) {
+  Record* r = (Record*) context;
+  encoder->beginMap(8);
+  encoder->addString("id", r->id);
+  encoder->addUInt("ts", r->timestamp);
+  encoder->addFloat("t", r->temperature);
+  encoder->addFloat("h", r->humidity);
+  encoder->addFloat("p", r->pressure);
+  encoder->addFloat("bat", r->battery);
+  encoder->addInt("rssi", r->rssi);
+  encoder->addBool("door", r->door);
+}
+
+// Encode the record in CBOR as an array (the fields are identified by their position)
+void encodeCborArray(SIM800LCborEncoder* encoder, void* context) {
+  Record* r = (Record*) context;
+  encoder->beginArray(8);
+  encoder->writeString(r->id);
+  encoder->writeUInt(r->timestamp);
+  encoder->writeFloat(r->temperature);
+  encoder->writeFloat(r->humidity);
+  encoder->writeFloat(r->pressure);
+  encoder->writeFloat(r->battery);
+  encoder->writeInt(r->rssi);
+  encoder->writeBool(r->door);
+}
+
+// Encode the same record in JSON, as usually done for doPost()
+uint16_t encodeJson(Record* r, char* buffer, uint16_t size) {
+  return snprintf(buffer, size, "{\"id\":\"%s\",\"ts\":%lu,\"t\":%.2f,\"h\":%.2f,\"p\":%.2f,\"bat\":%.2f,\"rssi\":%d,\"door\":%s}",
+    r->id, (unsigned long)r->timestamp, r->temperature, r->humidity, r->pressure, r->battery, r->rssi, r->door ? "true" : "false");
+}
+
+typedef std::chrono::steady_clock Clock;
+
+// Elapsed time in nanosec since start
+uint64_t elapsedNs(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// Print the size (and the ratio to JSON) and the encoding time of a record
+void printResult(const char* name, uint16_t length, uint64_t elapsed, uint16_t jsonLength) {
+  printf("%-24s: %3u bytes (JSON / %.2f), %7.1f ns per record\n", name, length,
+         (float)jsonLength / length, (double)elapsed / ITERATIONS);
+}
+
+int main() {
+  // JSON built with snprintf()
+  char json[128];
+  uint16_t jsonLength = 0;
+  Clock::time_point start = Clock::now();
+  for(uint32_t i = 0; i < ITERATIONS; i++) {
+    jsonLength = encodeJson(&record, json, sizeof(json));
+  }
+  printResult("JSON", jsonLength, elapsedNs(start), jsonLength);
+
+  // CBOR in a buffer
+  uint8_t cbor[64];
+  uint16_t cborLength = 0;
+  start = Clock::now();
+  for(uint32_t i = 0; i < ITERATIONS; i++) {
+    SIM800LCborEncoder encoder(cbor, sizeof(cbor));
+    encodeCbor(&encoder, &record);
+    cborLength = encoder.getLength();
+  }
+  printResult("CBOR map", cborLength, elapsedNs(start), jsonLength);
+  CHECK(cborLength < jsonLength);
+
+  // CBOR array in a buffer
+  start = Clock::now();
+  for(uint32_t i = 0; i < ITERATIONS; i++) {
+    SIM800LCborEncoder encoder(cbor, sizeof(cbor));
+    encodeCborArray(&encoder, &record);
+    cborLength = encoder.getLength();
+  }
+  printResult("CBOR array", cborLength, elapsedNs(start), jsonLength);
+
+  // CBOR length counted before being written straight to the module by SIM800LCborPayload
+  SIM800LCborPayload payload(encodeCbor, &record);
+  start = Clock::now();
+  for(uint32_t i = 0; i < ITERATIONS; i++) {
+    cborLength = payload.getLength();
+  }
+  printResult("CBOR map (length only)", cborLength, elapsedNs(start), jsonLength);
+  return 0;
+}
@@ -0,0 +1,130 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Benchmark of the parsing on the host (no module needed): time per byte of
+// readResponse() through the stream and by spans of the ring buffer, and of strIndex(),
+// like the example Benchmark_Parsing on the board. The time is measured with the clock
+// of the host (the clock of the driver is simulated).
+#include <chrono>
+#include "HostTest.h"
+#include "SIM800L.h"
+#include "SIM800LRing.h"
+
+#define ITERATIONS 200000
+#define BATCH 64
+
+// Typical answer of the module parsed by the driver
+const char ANSWER[] = "\r\n+HTTPACTION: 0,200,1024\r\n";
+#define ANSWER_LENGTH (sizeof(ANSWER) - 1)
+
+// Stream replaying the answer endlessly (the bytes sent are ignored)
+class ReplayStream : public Stream {
+  public:
+    int available() { return 1; }
+    int read() { uint8_t c = ANSWER[position]; position = (position + 1) % ANSWER_LENGTH; return c; }
+    int peek() { return ANSWER[position]; }
+    size_t write(uint8_t c) { (void)c; return 1; }
+    uint16_t position = 0;
+};
+
+// Access to the parsing methods of the driver
+class BenchDriver : public SIM800L {
+  public:
+    BenchDriver(Stream* stream) : SIM800L(stream, RESET_PIN_NOT_USED, 200, 64) {}
+    BenchDriver(SIM800LRing* ring) : SIM800L(ring, RESET_PIN_NOT_USED, 200, 64) {}
+    using SIM800L::readResponse;
+    using SIM800L::strIndex;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// Elapsed time in nanosec since start
+uint64_t elapsedNs(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+// Print the time per byte of a benchmark
+void printResult(const char* name, uint64_t elapsed, uint64_t bytes) {
+  printf("%-26s: %6.2f ns/byte (%llu us for %llu bytes)\n", name, (double)elapsed / bytes,
+         (unsigned long long)(elapsed / 1000), (unsigned long long)bytes);
+}
+
+// Answers read byte by byte through the Stream interface
+void benchStream() {
+  ReplayStream stream;
+  BenchDriver driver(&stream);
+  Clock::time_point start = Clock::now();
+  for(uint32_t i = 0; i < ITERATIONS; i++) {
+    CHECK(driver.readResponse(DEFAULT_TIMEOUT));
+  }
+  printResult("readResponse() by stream", elapsedNs(start), (uint64_t)ITERATIONS * ANSWER_LENGTH);
+}
+
+// Answers stored in the ring buffer (as by the interrupt of the UART) and parsed by spans,
+// only the parsing is measured
+void benchRing() {
+  ReplayStream silent;
+  SIM800LRing ring(&silent, BATCH * ANSWER_LENGTH + 1);
+  ring.setPushMode(true);
+  BenchDriver driver(&ring);
+  uint64_t elapsed = 0;
+  for(uint32_t i = 0; i < ITERATIONS; i += BATCH) {
+    for(uint16_t j = 0; j < BATCH * ANSWER_LENGTH; j++) {
+      CHECK(ring.push(ANSWER[j % ANSWER_LENGTH]));
+    }
+    Clock::time_point start = Clock::now();
+    for(uint16_t j = 0; j < BATCH; j++) {
+      CHECK(driver.readResponse(DEFAULT_TIMEOUT));
+    }
+    elapsed += elapsedNs(start);
+  }
+  printResult("readResponse() by ring", elapsed, (uint64_t)ITERATIONS * ANSWER_LENGTH);
+}
+
+// Search of the answer in a buffer (the results are accumulated in a volatile sink and
+// printed, so that the calls are not removed by the optimizer)
+void benchStrIndex() {
+  ReplayStream silent;
+  BenchDriver driver(&silent);
+  volatile int32_t sink = 0;
+  Clock::time_point start = Clock::now();
+  for(uint32_t i = 0; i < ITERATIONS; i++) {
+    sink = sink + driver.strIndex(ANSWER, "1024");
+  }
+  printResult("strIndex()", elapsedNs(start), (uint64_t)ITERATIONS * ANSWER_LENGTH);
+  CHECK(sink == (int32_t)ITERATIONS * 21);
+}
+
+int main() {
+  benchStream();
+  benchRing();
+  benchStrIndex();
+  return 0;
+}
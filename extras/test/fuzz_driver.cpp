@@ -0,0 +1,233 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Fuzzing harness of the parsers of the driver: the module answers each command line with
+// the next segment of the input, so malformed answers go through the public API of the
+// driver built with the sanitizers. Layout of an input:
+//   <call> <buffer size> <unsolicited> 0x1E <answer 1> 0x1E <answer 2> 0x1E ...
+// The first byte selects the method called (modulo the number of calls), the second one
+// the size of the internal buffer. The seed corpus in corpus/ holds real answers of the module.
+//
+// With libFuzzer (clang):
+//   make -C extras/test fuzz_libfuzzer CXX=clang++
+//   extras/test/fuzz_libfuzzer extras/test/corpus/
+// Without libFuzzer (make -C extras/test fuzz): each file of the corpus and a number of
+// random mutations of it are run, the input of a crash is saved in crash.bin
+//   fuzz_driver [-n <mutations per file>] <file>...
+#include "HostTest.h"
+#include "SIM800L.h"
+#include <fstream>
+#include <random>
+#include <sanitizer/common_interface_defs.h>
+#include <vector>
+
+#define FUZZ_SEPARATOR 0x1E
+
+// Module answering each command line (or block ended by Ctrl-Z) with the next segment,
+// the first segment is received before any command (unsolicited result codes)
+class FuzzModem : public Stream {
+  public:
+    FuzzModem(const uint8_t* _data, size_t _size) : data(_data), size(_size) {
+      nextSegment();
+    }
+
+    size_t write(uint8_t c) {
+      if(c == '\n' || c == 0x1A) {
+        nextSegment();
+      }
+      return 1;
+    }
+
+    int available() {
+      return rx.size();
+    }
+
+    int read() {
+      if(rx.empty()) {
+        return -1;
+      }
+      int c = (uint8_t)rx[0];
+      rx.erase(0, 1);
+      return c;
+    }
+
+    int peek() {
+      return rx.empty() ? -1 : (uint8_t)rx[0];
+    }
+
+  private:
+    void nextSegment() {
+      while(position < size && data[position] != FUZZ_SEPARATOR) {
+        rx += (char)data[position++];
+      }
+      position++;
+    }
+
+    const uint8_t* data;
+    size_t size;
+    size_t position = 0;
+    std::string rx;
+};
+
+// Sink checking that the data written stays within the bounds given
+class CheckSink : public SIM800LSink {
+  public:
+    bool write(uint32_t offset, const uint8_t* data, uint16_t length) {
+      (void)offset;
+      for(uint16_t i = 0; i < length; i++) {
+        checksum += data[i];
+      }
+      return true;
+    }
+    uint32_t checksum = 0;
+};
+
+static void onSMS(SIM800LSMS* sms, void* context) {
+  uint32_t* checksum = (uint32_t*)context;
+  for(uint16_t i = 0; i < sms->length; i++) {
+    *checksum += sms->data[i];
+  }
+  *checksum += strlen(sms->sender);
+}
+
+// Read the whole string returned by a getter (out of bounds if not terminated)
+static size_t touch(const char* s) {
+  return s != NULL ? strlen(s) : 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  if(size < 2) {
+    return 0;
+  }
+
+  FuzzModem modem(data + 2, size - 2);
+  SIM800L sim(&modem, RESET_PIN_NOT_USED, 32 + data[1], 64 + data[1], NULL);
+  CheckSink sink;
+  SIM800LDownload download;
+  uint32_t checksum = 0;
+
+  switch(data[0] % 14) {
+    case 0: sim.getSignal(); break;
+    case 1: sim.getRegistrationStatus(); break;
+    case 2: touch(sim.getVersion()); break;
+    case 3: touch(sim.getFirmware()); break;
+    case 4: touch(sim.getSimCardNumber()); break;
+    case 5: touch(sim.getSimStatus()); break;
+    case 6: touch(sim.getIP()); break;
+    case 7: sim.getPowerMode(); break;
+    case 8:
+      if(sim.doGet("http://example.com/data", 1000) == 200) {
+        touch(sim.getDataReceived());
+      }
+      break;
+    case 9: sim.doDownload("http://example.com/fw.bin", &sink, &download, 64, 1000); break;
+    case 10: sim.readAllSMS(onSMS, &checksum, false); break;
+    case 11: sim.checkNewSMS(); break;
+    case 12: sim.ftpGet("/", "data.bin", &sink, 64, 1000); break;
+    case 13: sim.getFileSize("data.bin"); break;
+  }
+  return 0;
+}
+
+#ifndef SIM800L_LIBFUZZER
+// Input being run, saved if the sanitizers stop the program
+static std::vector<uint8_t> current;
+
+static void saveCrash() {
+  std::ofstream file("crash.bin", std::ios::binary);
+  file.write((const char*)current.data(), current.size());
+  fprintf(stderr, "Input saved in crash.bin\n");
+}
+
+static void mutate(std::vector<uint8_t>* input, std::mt19937* random) {
+  uint8_t count = 1 + (*random)() % 4;
+  for(uint8_t i = 0; i < count; i++) {
+    size_t position = input->empty() ? 0 : (*random)() % input->size();
+    switch((*random)() % 5) {
+      case 0: // Flip a byte
+        if(!input->empty()) (*input)[position] = (*random)();
+        break;
+      case 1: // Remove a byte
+        if(!input->empty()) input->erase(input->begin() + position);
+        break;
+      case 2: // Insert a byte
+        input->insert(input->begin() + position, (uint8_t)(*random)());
+        break;
+      case 3: // Truncate
+        input->resize(position);
+        break;
+      case 4: // Repeat a block (long answers)
+        if(!input->empty()) {
+          size_t length = 1 + (*random)() % (input->size() - position);
+          std::vector<uint8_t> block(input->begin() + position, input->begin() + position + length);
+          for(uint8_t repeat = (*random)() % 8; repeat > 0; repeat--) {
+            input->insert(input->begin() + position, block.begin(), block.end());
+          }
+        }
+        break;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  unsigned long mutations = 2000;
+  int first = 1;
+  if(argc > 2 && strcmp(argv[1], "-n") == 0) {
+    mutations = strtoul(argv[2], NULL, 10);
+    first = 3;
+  }
+  __sanitizer_set_death_callback(saveCrash);
+
+  std::mt19937 random(1);
+  unsigned long runs = 0;
+  for(int i = first; i < argc; i++) {
+    std::ifstream file(argv[i], std::ios::binary);
+    std::vector<uint8_t> seed((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if(!file && seed.empty()) {
+      printf("Unable to read %s\n", argv[i]);
+      return 1;
+    }
+
+    current = seed;
+    LLVMFuzzerTestOneInput(current.data(), current.size());
+    runs++;
+    for(unsigned long m = 0; m < mutations; m++) {
+      current = seed;
+      mutate(&current, &random);
+      LLVMFuzzerTestOneInput(current.data(), current.size());
+      runs++;
+    }
+  }
+
+  printf("%lu inputs run\n", runs);
+  printf("ALL OK\n");
+  return 0;
+}
+#endif
@@ -0,0 +1,341 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Replay of the transcripts recorded with SIM800LTranscript: the driver talks to a module
+// which checks every byte sent against the TX records and answers with the RX records at
+// their recorded delays. For each transcript, the result of the call, the number of round
+// trips and the elapsed time (simulated clock) are checked against the expectations
+// written at the top of the file:
+//   @call doGet http://example.com/ 10000
+//   @expect 200 Hello
+//   @roundtrips 8
+//   @budget 1200
+// Usage: replay <transcript>...
+#include "HostTest.h"
+#include "SIM800L.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#define REPLAY_BURST_GAP 50   // Maximum gap between the records of an answer sent at once (millisec)
+
+// Record of the transcript: <millis> TX|RX "<bytes>"
+struct Record {
+  unsigned long time;
+  bool tx;
+  std::string bytes;
+  int line;
+};
+
+// Transcript with its expectations
+struct Transcript {
+  std::vector<std::string> call;
+  std::string expect;
+  long roundTrips = -1;
+  long budget = -1;
+  std::vector<Record> records;
+};
+
+// Decode the escaped bytes of a record (\r, \n, \", \\ and \xHH)
+bool unescape(const std::string& text, size_t start, std::string* bytes) {
+  for(size_t i = start; i < text.size(); i++) {
+    char c = text[i];
+    if(c == '"') {
+      return true;
+    }
+    if(c != '\\') {
+      *bytes += c;
+      continue;
+    }
+    if(++i >= text.size()) {
+      return false;
+    }
+    switch(text[i]) {
+      case 'r': *bytes += '\r'; break;
+      case 'n': *bytes += '\n'; break;
+      case 'x':
+        if(i + 2 >= text.size()) {
+          return false;
+        }
+        *bytes += (char)strtoul(text.substr(i + 1, 2).c_str(), NULL, 16);
+        i += 2;
+        break;
+      default: *bytes += text[i]; break;
+    }
+  }
+  return false;
+}
+
+bool loadTranscript(const char* path, Transcript* transcript) {
+  std::ifstream file(path);
+  if(!file) {
+    printf("%s: unable to open\n", path);
+    return false;
+  }
+
+  std::string text;
+  int line = 0;
+  while(std::getline(file, text)) {
+    line++;
+    if(text.empty() || text[0] == '#') {
+      continue;
+    }
+
+    if(text[0] == '@') {
+      std::istringstream directive(text.substr(1));
+      std::string name;
+      directive >> name;
+      if(name == "call") {
+        std::string argument;
+        while(directive >> argument) {
+          transcript->call.push_back(argument);
+        }
+      } else if(name == "expect") {
+        std::getline(directive >> std::ws, transcript->expect);
+      } else if(name == "roundtrips") {
+        directive >> transcript->roundTrips;
+      } else if(name == "budget") {
+        directive >> transcript->budget;
+      } else {
+        printf("%s:%d: unknown directive %s\n", path, line, name.c_str());
+        return false;
+      }
+      continue;
+    }
+
+    Record record;
+    char direction[3] = {0};
+    size_t quote = text.find('"');
+    if(sscanf(text.c_str(), "%lu %2s", &record.time, direction) != 2 || quote == std::string::npos || !unescape(text, quote + 1, &record.bytes)) {
+      printf("%s:%d: invalid record\n", path, line);
+      return false;
+    }
+    record.tx = strcmp(direction, "TX") == 0;
+    record.line = line;
+    transcript->records.push_back(record);
+  }
+
+  if(transcript->call.empty()) {
+    printf("%s: no @call\n", path);
+    return false;
+  }
+  return true;
+}
+
+// Module replaying a transcript
+class ReplayModem : public Stream {
+  public:
+    ReplayModem(const std::vector<Record>* _records) : records(_records) {
+      // Bytes received before the first command (URC of the boot)
+      scheduleAnswer(records->empty() ? 0 : (*records)[0].time);
+    }
+
+    // Check if all the commands of the transcript were sent
+    bool isComplete() {
+      return error.empty() && next >= records->size();
+    }
+
+    std::string error;
+
+    size_t write(uint8_t c) {
+      if(!error.empty()) {
+        return 1;
+      }
+      if(next >= records->size() || !(*records)[next].tx) {
+        error = "unexpected byte sent: " + describe(c);
+        return 1;
+      }
+
+      const Record& record = (*records)[next];
+      if(record.bytes[offset] != (char)c) {
+        char message[128];
+        snprintf(message, sizeof(message), "line %d, byte %u: expected %s, sent %s", record.line,
+          (unsigned)offset, describe(record.bytes[offset]).c_str(), describe(c).c_str());
+        error = message;
+        return 1;
+      }
+
+      // End of the record: the answer follows at its recorded delay
+      if(++offset == record.bytes.size()) {
+        offset = 0;
+        next++;
+        scheduleAnswer(record.time);
+      }
+      return 1;
+    }
+
+    int available() {
+      deliver();
+      return rx.size();
+    }
+
+    int read() {
+      deliver();
+      if(rx.empty()) {
+        return -1;
+      }
+      int c = (uint8_t)rx[0];
+      rx.erase(0, 1);
+      return c;
+    }
+
+    int peek() {
+      deliver();
+      return rx.empty() ? -1 : (uint8_t)rx[0];
+    }
+
+  private:
+    // Queue the RX records following the current position, relative to a reference time.
+    // The timestamps are the time of the reading by the driver: after the latency of the
+    // first record, the records read less than REPLAY_BURST_GAP apart were sent at once
+    // by the module and are delivered together, only the longer gaps (the answer of the
+    // server for instance) are replayed
+    void scheduleAnswer(unsigned long reference) {
+      unsigned long due = fakeNow;
+      bool first = true;
+      while(next < records->size() && !(*records)[next].tx) {
+        const Record& record = (*records)[next];
+        unsigned long gap = record.time > reference ? record.time - reference : 0;
+        if(first || gap > REPLAY_BURST_GAP) {
+          due += gap > 0 ? gap : 1;
+          first = false;
+        }
+        pending.push_back(std::make_pair(due, record.bytes));
+        reference = record.time;
+        next++;
+      }
+    }
+
+    void deliver() {
+      while(!pending.empty() && pending.front().first <= fakeNow) {
+        rx += pending.front().second;
+        pending.erase(pending.begin());
+      }
+    }
+
+    static std::string describe(char c) {
+      char text[8];
+      snprintf(text, sizeof(text), c >= 0x20 && c < 0x7F ? "'%c'" : "0x%02X", (uint8_t)c);
+      return text;
+    }
+
+    const std::vector<Record>* records;
+    size_t next = 0;
+    size_t offset = 0;
+    std::string rx;
+    std::vector<std::pair<unsigned long, std::string> > pending;
+};
+
+// Call a method of the driver by its name, the result is returned as text
+bool callDriver(SIM800L* sim, const std::vector<std::string>& call, std::string* result) {
+  const std::string& name = call[0];
+  char text[32];
+  if(name == "isReady" && call.size() == 1) {
+    *result = sim->isReady() ? "true" : "false";
+  } else if(name == "getSignal" && call.size() == 1) {
+    snprintf(text, sizeof(text), "%u", sim->getSignal());
+    *result = text;
+  } else if(name == "getRegistrationStatus" && call.size() == 1) {
+    snprintf(text, sizeof(text), "%d", (int)sim->getRegistrationStatus());
+    *result = text;
+  } else if(name == "getVersion" && call.size() == 1) {
+    char* version = sim->getVersion();
+    *result = version != NULL ? version : "NULL";
+  } else if(name == "getFirmware" && call.size() == 1) {
+    char* firmware = sim->getFirmware();
+    *result = firmware != NULL ? firmware : "NULL";
+  } else if(name == "doGet" && call.size() == 3) {
+    uint16_t rc = sim->doGet(call[1].c_str(), atoi(call[2].c_str()));
+    snprintf(text, sizeof(text), "%u ", rc);
+    *result = text + std::string(rc == 200 ? sim->getDataReceived() : "");
+  } else if(name == "doPost" && call.size() == 5) {
+    uint16_t rc = sim->doPost(call[1].c_str(), call[2].c_str(), call[3].c_str(), 10000, atoi(call[4].c_str()));
+    snprintf(text, sizeof(text), "%u ", rc);
+    *result = text + std::string(rc == 200 ? sim->getDataReceived() : "");
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool replay(const char* path, DebugOutput* debug) {
+  Transcript transcript;
+  if(!loadTranscript(path, &transcript)) {
+    return false;
+  }
+
+  ReplayModem modem(&transcript.records);
+  SIM800L sim(&modem, RESET_PIN_NOT_USED, 200, 512, debug);
+  unsigned long start = fakeNow;
+  std::string result;
+  if(!callDriver(&sim, transcript.call, &result)) {
+    printf("%s: unknown call %s\n", path, transcript.call[0].c_str());
+    return false;
+  }
+  unsigned long elapsed = fakeNow - start;
+  uint32_t roundTrips = sim.getCommandCount();
+
+  bool ok = true;
+  if(!modem.isComplete()) {
+    printf("%s: %s\n", path, modem.error.empty() ? "commands of the transcript not sent" : modem.error.c_str());
+    ok = false;
+  }
+  if(result != transcript.expect) {
+    printf("%s: result \"%s\", expected \"%s\"\n", path, result.c_str(), transcript.expect.c_str());
+    ok = false;
+  }
+  if(transcript.roundTrips >= 0 && roundTrips != (uint32_t)transcript.roundTrips) {
+    printf("%s: %u round trips, expected %ld\n", path, (unsigned)roundTrips, transcript.roundTrips);
+    ok = false;
+  }
+  if(transcript.budget >= 0 && elapsed > (unsigned long)transcript.budget) {
+    printf("%s: %lu ms, budget of %ld ms\n", path, elapsed, transcript.budget);
+    ok = false;
+  }
+
+  printf("%s %s (%u round trips, %lu ms)\n", ok ? "OK  " : "FAIL", path, (unsigned)roundTrips, elapsed);
+  return ok;
+}
+
+int main(int argc, char** argv) {
+  DebugOutput debug;
+  int failures = 0;
+  for(int i = 1; i < argc; i++) {
+    if(!replay(argv[i], &debug)) {
+      failures++;
+    }
+  }
+  if(failures > 0) {
+    printf("%d transcript(s) failed\n", failures);
+    return 1;
+  }
+  printf("ALL OK\n");
+  return 0;
+}
@@ -0,0 +1,118 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include <Arduino.h>
+
+/*****************************************************************************************
+ * SIMULATED CLOCK
+ *****************************************************************************************/
+unsigned long fakeNow = 0;
+
+unsigned long millis() {
+  return fakeNow++;
+}
+
+unsigned long micros() {
+  return fakeNow * 1000;
+}
+
+void delay(unsigned long ms) {
+  fakeNow += ms;
+}
+
+/*****************************************************************************************
+ * PINS AND INTERRUPTS (no effect on the host)
+ *****************************************************************************************/
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  (void)pin;
+  (void)value;
+}
+
+void noInterrupts() {}
+
+void interrupts() {}
+
+/*****************************************************************************************
+ * PRINT AND STREAM
+ *****************************************************************************************/
+static size_t printNumber(Print* out, unsigned long value, int base, bool negative) {
+  char buffer[40];
+  snprintf(buffer, sizeof(buffer), base == HEX ? "%s%lX" : "%s%lu", negative ? "-" : "", value);
+  return out->write(buffer);
+}
+
+size_t Print::print(const __FlashStringHelper* s) { return write((const char*)s); }
+size_t Print::print(const char* s) { return write(s); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char v, int base) { return printNumber(this, v, base, false); }
+size_t Print::print(int v, int base) { return print((long)v, base); }
+size_t Print::print(unsigned int v, int base) { return printNumber(this, v, base, false); }
+size_t Print::print(long v, int base) { return v < 0 ? printNumber(this, -(unsigned long)v, base, true) : printNumber(this, v, base, false); }
+size_t Print::print(unsigned long v, int base) { return printNumber(this, v, base, false); }
+
+size_t Print::print(double v, int digits) {
+  char buffer[40];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, v);
+  return write(buffer);
+}
+
+size_t Print::println(void) { return write("\r\n"); }
+size_t Print::println(const __FlashStringHelper* s) { return print(s) + println(); }
+size_t Print::println(const char* s) { return print(s) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char v, int base) { return print(v, base) + println(); }
+size_t Print::println(int v, int base) { return print(v, base) + println(); }
+size_t Print::println(unsigned int v, int base) { return print(v, base) + println(); }
+size_t Print::println(long v, int base) { return print(v, base) + println(); }
+size_t Print::println(unsigned long v, int base) { return print(v, base) + println(); }
+size_t Print::println(double v, int digits) { return print(v, digits) + println(); }
+
+void Stream::setTimeout(unsigned long _timeout) {
+  timeout = _timeout;
+}
+
+// Read until the buffer is full or nothing is received during the timeout of the stream
+size_t Stream::readBytes(char* buffer, size_t length) {
+  size_t count = 0;
+  unsigned long start = millis();
+  while(count < length && millis() - start < timeout) {
+    int c = read();
+    if(c >= 0) {
+      buffer[count++] = (char)c;
+      start = millis();
+    }
+  }
+  return count;
+}
@@ -0,0 +1,196 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Bearer profiles and their failover against an emulated module: the stalls of the
+// active bearer (no answer of the server, network or DNS errors) are counted, and after
+// the maximum the requests move to the other profile configured, opened without its
+// parameters sent again. A server answering 408 is not a stall.
+#include "HostTest.h"
+#include "SIM800L.h"
+
+// Module with 3 bearer profiles: the network behind a profile may stall the requests
+class EmulatedModem {
+  public:
+    FakeModem stream;
+    bool open[4] = {false, true, false, false};
+    bool stalled[4] = {false, false, false, false}; // The server never answers through the profile
+    int16_t stallCME = -1;         // Extended error of the action on a stalled profile (-1: no answer)
+    bool refuseOpen = false;       // The profiles cannot be opened
+    bool server408 = false;        // The server answers 408
+    uint8_t cid = 1;
+    uint16_t actions[4] = {0, 0, 0, 0};
+
+    EmulatedModem() {
+      stream.onLine = [this](const std::string& command) -> std::string {
+        if(command.compare(0, 11, "AT+SAPBR=1,") == 0) {
+          if(refuseOpen) {
+            return "\r\nERROR\r\n";
+          }
+          open[atoi(command.c_str() + 11)] = true;
+          return "\r\nOK\r\n";
+        }
+        if(command.compare(0, 11, "AT+SAPBR=2,") == 0) {
+          int profile = atoi(command.c_str() + 11);
+          char answer[64];
+          if(open[profile]) {
+            sprintf(answer, "\r\n+SAPBR: %d,1,\"10.0.0.%d\"\r\n\r\nOK\r\n", profile, profile);
+          } else {
+            sprintf(answer, "\r\n+SAPBR: %d,3,\"0.0.0.0\"\r\n\r\nOK\r\n", profile);
+          }
+          return answer;
+        }
+        if(command.compare(0, 18, "AT+HTTPPARA=\"CID\",") == 0) {
+          cid = atoi(command.c_str() + 18);
+          return "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPACTION=0") {
+          actions[cid]++;
+          if(server408) {
+            stream.answer("\r\n+HTTPACTION: 0,408,0\r\n", 300);
+          } else if(stalled[cid] && stallCME >= 0) {
+            char answer[32];
+            sprintf(answer, "\r\n+CME ERROR: %d\r\n", stallCME);
+            return answer;
+          } else if(!stalled[cid]) {
+            stream.answer("\r\n+HTTPACTION: 0,200,2\r\n", 300);
+          }
+          return "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPREAD") {
+          return "\r\n+HTTPREAD: 2\r\nhi\r\nOK\r\n";
+        }
+        return "\r\nOK\r\n";
+      };
+    }
+};
+
+// Profiles configured once (CID 1 to 3 only) and the IP address of the active one
+void testConfiguration(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 64, debug);
+  CHECK(driver.setupGPRS("apn1"));
+  CHECK(driver.setupBearer(2, "apn2", "user", "secret"));
+  CHECK(!driver.setupBearer(4, "apn4"));
+  CHECK(modem.stream.log.find("AT+SAPBR=3,1,\"Contype\",\"GPRS\"\r\nAT+SAPBR=3,1,\"APN\",\"apn1\"\r\n") != std::string::npos);
+  CHECK(modem.stream.log.find("AT+SAPBR=3,2,\"Contype\",\"GPRS\"\r\nAT+SAPBR=3,2,\"APN\",\"apn2\"\r\n"
+                              "AT+SAPBR=3,2,\"USER\",\"user\"\r\nAT+SAPBR=3,2,\"PWD\",\"secret\"\r\n") != std::string::npos);
+  CHECK(driver.getBearerStats(1)->configured && driver.getBearerStats(2)->configured && !driver.getBearerStats(3)->configured);
+  CHECK(driver.getBearerStats(0) == NULL && driver.getBearerStats(4) == NULL);
+  CHECK(driver.isConnectedGPRS() && !driver.isConnectedBearer(2));
+  CHECK(strcmp(driver.getIP(), "10.0.0.1") == 0);
+  CHECK(!driver.setActiveBearer(0) && driver.setActiveBearer(2) && driver.getActiveBearer() == 2);
+  printf("configuration: OK\n");
+}
+
+// Three requests stalled on CID 1, then the fourth goes through CID 2 (opened, not configured again)
+void testFailover(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 64, debug);
+  CHECK(driver.setupGPRS("apn1"));
+  CHECK(driver.setupBearer(2, "apn2"));
+  driver.enableBearerFailover(3);
+  modem.stalled[1] = true;
+
+  for(uint8_t i = 1; i <= 3; i++) {
+    CHECK(driver.doGet("http://example.com/", 1000) == 408);
+    CHECK(driver.getBearerStats(1)->consecutiveFailures == i);
+    CHECK(driver.getActiveBearer() == (i < 3 ? 1 : 2));
+  }
+  CHECK(modem.open[2] && modem.actions[1] == 3 && modem.actions[2] == 0);
+
+  size_t before = modem.stream.log.size();
+  CHECK(driver.doGet("http://example.com/", 1000) == 200);
+  std::string log = modem.stream.log.substr(before);
+  CHECK(log.find("AT+HTTPPARA=\"CID\",2\r\n") != std::string::npos && log.find("AT+SAPBR=3,2") == std::string::npos);
+  CHECK(modem.actions[2] == 1);
+  CHECK(driver.getBearerStats(1)->failures == 3 && driver.getBearerStats(1)->requests == 3);
+  CHECK(driver.getBearerStats(2)->requests == 1 && driver.getBearerStats(2)->consecutiveFailures == 0);
+  CHECK(strcmp(driver.getIP(), "10.0.0.2") == 0);
+  printf("failover: OK\n");
+}
+
+// With retries, the failover happens within the call and the next attempt opens a new
+// session on the other profile; network errors of the module are stalls too
+void testFailoverWithRetries(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 64, debug);
+  CHECK(driver.enableExtendedErrors());
+  CHECK(driver.setupGPRS("apn1"));
+  CHECK(driver.setupBearer(2, "apn2"));
+  driver.enableBearerFailover(3);
+  driver.setRetryPolicy(5, 100, 100);
+  modem.stalled[1] = true;
+  modem.stallCME = 160;
+
+  CHECK(driver.doGet("http://example.com/", 1000) == 200);
+  CHECK(driver.getActiveBearer() == 2 && modem.actions[1] == 3 && modem.actions[2] == 1);
+  CHECK(driver.getBearerStats(1)->failures == 3 && driver.getLastError().stage == STAGE_NONE);
+  printf("failover with retries: OK\n");
+}
+
+// A server answering 408 is retried but is not a stall, and a profile which cannot be
+// opened is not used (its failure is counted)
+void testNoFailover(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 64, debug);
+  CHECK(driver.setupGPRS("apn1"));
+  CHECK(driver.setupBearer(2, "apn2"));
+  driver.enableBearerFailover(1);
+  driver.setRetryPolicy(2, 100, 100);
+
+  modem.server408 = true;
+  CHECK(driver.doGet("http://example.com/", 1000) == 408);
+  CHECK(driver.getLastError().httpStatus == 408 && modem.actions[1] == 2);
+  CHECK(driver.getActiveBearer() == 1 && driver.getBearerStats(1)->failures == 0);
+
+  modem.server408 = false;
+  modem.stalled[1] = true;
+  modem.refuseOpen = true;
+  CHECK(driver.doGet("http://example.com/", 1000) == 408);
+  CHECK(driver.getActiveBearer() == 1 && driver.getBearerStats(1)->failures == 2);
+  CHECK(driver.getBearerStats(2)->consecutiveFailures == 2 && !modem.open[2]);
+
+  // Without failover the stalls stay on the active profile
+  driver.enableBearerFailover(0);
+  modem.refuseOpen = false;
+  CHECK(driver.doGet("http://example.com/", 1000) == 408);
+  CHECK(driver.getActiveBearer() == 1 && driver.getBearerStats(1)->consecutiveFailures == 4);
+  printf("no failover: OK\n");
+}
+
+int main() {
+  DebugOutput debug;
+  testConfiguration(&debug);
+  testFailover(&debug);
+  testFailoverWithRetries(&debug);
+  testNoFailover(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
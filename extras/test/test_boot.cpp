@@ -0,0 +1,175 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Fast cold start (begin()) against an emulated module which boots: no answer before RDY,
+// Call Ready and SMS Ready notifications, delayed registration on the network. The time to
+// the first request and the number of commands are measured (cold and warm start)
+#include "HostTest.h"
+#include "SIM800L.h"
+
+// Module booting at bootAt: answers after bootMs, registered after registrationMs
+class BootingModem {
+  public:
+    FakeModem stream;
+    unsigned long bootAt = 0;
+    unsigned long bootMs = 650;
+    unsigned long registrationMs = 3000;
+    bool bearerOpen = false;
+    uint8_t bearerFailures = 0;     // Next bearer openings refused (ERROR)
+    bool networkSilent = false;     // The bearer opening never answers
+    uint16_t commands = 0;
+    uint16_t bearerAttempts = 0;
+    std::string log;
+
+    BootingModem() {
+      stream.onLine = [this](const std::string& command) -> std::string {
+        commands++;
+        log += command + "|";
+        if(fakeNow < bootAt + bootMs) {
+          return "";
+        }
+        if(command == "AT+CREG?") {
+          return fakeNow < bootAt + registrationMs ? "\r\n+CREG: 0,2\r\n\r\nOK\r\n" : "\r\n+CREG: 0,1\r\n\r\nOK\r\n";
+        }
+        if(command == "AT+SAPBR=2,1") {
+          return bearerOpen ? "\r\n+SAPBR: 1,1,\"10.0.0.1\"\r\n\r\nOK\r\n" : "\r\n+SAPBR: 1,3,\"0.0.0.0\"\r\n\r\nOK\r\n";
+        }
+        if(command == "AT+SAPBR=1,1") {
+          bearerAttempts++;
+          if(networkSilent) {
+            return "";
+          }
+          if(bearerFailures > 0) {
+            bearerFailures--;
+            return "\r\nERROR\r\n";
+          }
+          bearerOpen = true;
+        }
+        return "\r\nOK\r\n";
+      };
+    }
+
+    // Power on: the notifications of the boot are scheduled
+    void powerOn() {
+      bootAt = fakeNow;
+      bearerOpen = false;
+      commands = 0;
+      log.clear();
+      stream.answer("\r\nRDY\r\n", bootMs + 50);
+      stream.answer("\r\nCall Ready\r\n", registrationMs - 500);
+      stream.answer("\r\nSMS Ready\r\n", registrationMs - 400);
+    }
+};
+
+// Cold start: configuration during the registration, bearer opened as soon as registered
+void testColdStart(DebugOutput* debug) {
+  BootingModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 64, debug);
+  modem.powerOn();
+  CHECK(driver.begin("internet", "u", "p", 20000));
+
+  SIM800LBootStats stats = driver.getBootStats();
+  CHECK(stats.responsiveMs >= modem.bootMs && stats.responsiveMs < modem.bootMs + 300);
+  CHECK(stats.configuredMs > stats.responsiveMs && stats.configuredMs < modem.registrationMs);
+  CHECK(stats.registeredMs >= modem.registrationMs && stats.registeredMs < modem.registrationMs + 300);
+  CHECK(stats.firstRequestMs >= stats.registeredMs && stats.firstRequestMs < modem.registrationMs + 600);
+  // Polls of the registration every SIM800L_BOOT_POLL at most, plus the polls of the module and the bearer
+  CHECK(stats.commands == modem.commands && stats.commands <= 6 + modem.registrationMs / SIM800L_BOOT_POLL);
+  CHECK(modem.log.find("AT+CMEE=1;+SAPBR=3,1,\"Contype\",\"GPRS\";+SAPBR=3,1,\"APN\",\"internet\";+SAPBR=3,1,\"USER\",\"u\";+SAPBR=3,1,\"PWD\",\"p\"|") != std::string::npos);
+  CHECK(driver.getBearerStats(1)->configured && modem.bearerOpen);
+  printf("cold start: OK (responsive %u ms, configured %u ms, registered %u ms, first request %u ms, %u commands)\n",
+    (unsigned)stats.responsiveMs, (unsigned)stats.configuredMs, (unsigned)stats.registeredMs, (unsigned)stats.firstRequestMs, stats.commands);
+
+  // Warm start: the module answers and the bearer is already opened
+  modem.log.clear();
+  modem.commands = 0;
+  CHECK(driver.begin("internet", "u", "p", 20000));
+  stats = driver.getBootStats();
+  CHECK(modem.log.find("AT+SAPBR=1,1") == std::string::npos);
+  CHECK(stats.commands == modem.commands && stats.commands <= 4);
+  printf("warm start: OK (first request %u ms, %u commands)\n", (unsigned)stats.firstRequestMs, stats.commands);
+}
+
+// Credentials too long for one command line: the configuration is sent command by command
+void testLongConfiguration(DebugOutput* debug) {
+  BootingModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 64, 64, debug);
+  modem.powerOn();
+  CHECK(driver.begin("internet", "user", "password", 20000));
+  CHECK(modem.log.find("AT+CMEE=1|AT+SAPBR=3,1,\"Contype\",\"GPRS\"|AT+SAPBR=3,1,\"APN\",\"internet\"|AT+SAPBR=3,1,\"USER\",\"user\"|AT+SAPBR=3,1,\"PWD\",\"password\"|") != std::string::npos);
+  CHECK(driver.getBootStats().commands == modem.commands);
+  printf("long configuration: OK\n");
+}
+
+// A refused bearer is retried after a poll delay, a silent network is bounded by the timeout
+void testBearerFailures(DebugOutput* debug) {
+  BootingModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 64, debug);
+  modem.powerOn();
+  modem.bearerFailures = 3;
+  CHECK(driver.begin("internet", NULL, NULL, 20000));
+  SIM800LBootStats stats = driver.getBootStats();
+  CHECK(modem.bearerAttempts == 4);
+  CHECK(stats.firstRequestMs >= modem.registrationMs + 3 * SIM800L_BOOT_POLL);
+
+  modem.powerOn();
+  modem.networkSilent = true;
+  modem.bearerAttempts = 0;
+  unsigned long start = fakeNow;
+  CHECK(!driver.begin("internet", NULL, NULL, 10000));
+  // One wait for the network, up to the timeout (the last poll may end a bit later)
+  CHECK(fakeNow - start < 10000 + SIM800L_BOOT_POLL + 100);
+  CHECK(modem.bearerAttempts == 1);
+  CHECK(driver.getBootStats().firstRequestMs == 0);
+  printf("bearer failures: OK\n");
+}
+
+// No module (no RDY, no answer): begin() gives up at its timeout
+void testNoModule(DebugOutput* debug) {
+  BootingModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 64, debug);
+  modem.bootMs = 1000000;
+  modem.powerOn();
+  unsigned long start = fakeNow;
+  CHECK(!driver.begin("internet", NULL, NULL, 3000));
+  CHECK(fakeNow - start < 3000 + SIM800L_BOOT_POLL + 100);
+  CHECK(driver.getBootStats().responsiveMs == 0 && driver.getBootStats().firstRequestMs == 0);
+  printf("no module: OK\n");
+}
+
+int main() {
+  DebugOutput debug;
+  testColdStart(&debug);
+  testLongConfiguration(&debug);
+  testBearerFailures(&debug);
+  testNoModule(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
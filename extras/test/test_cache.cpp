@@ -0,0 +1,265 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Cache of the HTTP answers against an emulated server: the validators of an answer are
+// kept, the next GET is conditional and a 304 replays the cached body (in the reception
+// buffer or to the sink), a modified answer replaces it, and an interrupted one does not
+#include <map>
+#include "HostTest.h"
+#include "SIM800L.h"
+
+#define URL "http://example.com/config"
+
+// Cache in memory: the answer being stored replaces the previous one only when complete
+class MemoryCache : public SIM800LCache {
+  public:
+    struct Entry {
+      std::string etag, lastModified, body;
+    };
+    std::map<std::string, Entry> entries;
+    std::string storingUrl;
+    Entry storing;
+    bool open = false;
+    uint16_t begins = 0, ends = 0;
+
+    bool lookup(const char* url, char* etag, uint8_t etagSize, char* lastModified, uint8_t lastModifiedSize) {
+      std::map<std::string, Entry>::iterator it = entries.find(url);
+      if(it == entries.end()) {
+        return false;
+      }
+      snprintf(etag, etagSize, "%s", it->second.etag.c_str());
+      snprintf(lastModified, lastModifiedSize, "%s", it->second.lastModified.c_str());
+      return true;
+    }
+
+    bool begin(const char* url, const char* etag, const char* lastModified) {
+      CHECK(!open);
+      storingUrl = url;
+      storing.etag = etag;
+      storing.lastModified = lastModified;
+      storing.body.clear();
+      open = true;
+      begins++;
+      return true;
+    }
+
+    bool write(uint32_t offset, const uint8_t* data, uint16_t length) {
+      CHECK(open && offset == storing.body.size());
+      storing.body.append((const char*)data, length);
+      return true;
+    }
+
+    void end(bool complete) {
+      CHECK(open);
+      open = false;
+      ends++;
+      if(complete) {
+        entries[storingUrl] = storing;
+      }
+    }
+
+    uint16_t read(const char* url, uint32_t offset, uint8_t* buffer, uint16_t maxLength) {
+      const std::string& body = entries[url].body;
+      if(offset >= body.size()) {
+        return 0;
+      }
+      uint16_t length = body.size() - offset < maxLength ? body.size() - offset : maxLength;
+      memcpy(buffer, body.data() + offset, length);
+      return length;
+    }
+};
+
+// Sink in memory (a new body starts at offset 0), refusing the data when full
+class MemorySink : public SIM800LSink {
+  public:
+    std::string data;
+    bool full = false;
+
+    bool write(uint32_t offset, const uint8_t* chunk, uint16_t length) {
+      if(offset == 0) {
+        data.clear();
+      }
+      CHECK(offset == data.size());
+      data.append((const char*)chunk, length);
+      return !full;
+    }
+};
+
+// Server answering 304 when the validators sent match the current version of the resource
+class EmulatedModem {
+  public:
+    FakeModem stream;
+    std::string body = "{\"interval\":60,\"mode\":\"eco\"}";
+    std::string etag = "W/\"abc123\"";
+    std::string lastModified = "Sun, 06 Nov 1994 08:49:37 GMT";
+    std::string userData;
+    uint16_t reads = 0, heads = 0, notModified = 0;
+    bool failRead = false;
+
+    EmulatedModem() {
+      stream.onLine = [this](const std::string& command) -> std::string {
+        // The parameters belong to the HTTP session
+        if(command == "AT+HTTPINIT") {
+          userData.clear();
+          return "\r\nOK\r\n";
+        }
+        if(command.compare(0, 23, "AT+HTTPPARA=\"USERDATA\",") == 0) {
+          userData = command.substr(24, command.size() - 25);
+          return "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPACTION=0") {
+          bool matching = !etag.empty() && userData.find("If-None-Match: " + etag) != std::string::npos;
+          notModified += matching;
+          char urc[40];
+          sprintf(urc, "\r\n+HTTPACTION: 0,%u,%u\r\n", matching ? 304 : 200, matching ? 0 : (unsigned)body.size());
+          stream.answer(urc, 300);
+          return "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPHEAD") {
+          heads++;
+          std::string header = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n";
+          if(!etag.empty()) {
+            header += "etag: " + etag + "\r\n";
+          }
+          if(!lastModified.empty()) {
+            header += "Last-Modified: " + lastModified + "\r\n";
+          }
+          header += "\r\n";
+          char answer[32];
+          sprintf(answer, "\r\n+HTTPHEAD: %u\r\n", (unsigned)header.size());
+          return answer + header + "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPREAD") {
+          reads++;
+          char answer[32];
+          sprintf(answer, "\r\n+HTTPREAD: %u\r\n", (unsigned)body.size());
+          if(failRead) {
+            return answer + body.substr(0, 10);
+          }
+          return answer + body + "\r\nOK\r\n";
+        }
+        return "\r\nOK\r\n";
+      };
+    }
+};
+
+// The second GET sends the validators, the server answers 304 and the body comes from
+// the cache, in the reception buffer and then to the sink
+void testReplay(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  MemoryCache cache;
+  CHECK(driver.setResponseCache(&cache));
+
+  CHECK(driver.doGet(URL, "X-Key: 1", 10000) == 200);
+  CHECK(!driver.isAnswerFromCache() && modem.reads == 1 && modem.heads == 1 && modem.userData == "X-Key: 1");
+  CHECK(cache.entries[URL].body == modem.body);
+  CHECK(cache.entries[URL].etag == modem.etag && cache.entries[URL].lastModified == modem.lastModified);
+
+  CHECK(driver.doGet(URL, "X-Key: 1", 10000) == 200);
+  CHECK(modem.userData == "X-Key: 1\\r\\nIf-None-Match: W/\"abc123\"\\r\\nIf-Modified-Since: Sun, 06 Nov 1994 08:49:37 GMT");
+  CHECK(modem.notModified == 1 && modem.reads == 1 && modem.heads == 1);
+  CHECK(driver.isAnswerFromCache() && strcmp(driver.getDataReceived(), modem.body.c_str()) == 0);
+  CHECK(driver.getLastError().stage == STAGE_NONE);
+
+  MemorySink sink;
+  driver.setResponseSink(&sink);
+  CHECK(driver.doGet(URL, 10000) == 200);
+  CHECK(driver.isAnswerFromCache() && sink.data == modem.body && modem.reads == 1);
+  CHECK(cache.begins == 1 && cache.ends == 1);
+  printf("replay: OK\n");
+}
+
+// A modified resource replaces the cached answer while going to the sink, an interrupted
+// read keeps the previous answer (still served on the next 304)
+void testModified(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  MemoryCache cache;
+  CHECK(driver.setResponseCache(&cache));
+  MemorySink sink;
+  driver.setResponseSink(&sink);
+  CHECK(driver.doGet(URL, 10000) == 200);
+  std::string first = modem.body;
+
+  modem.etag = "W/\"def456\"";
+  modem.body = "{\"interval\":30}";
+  modem.failRead = true;
+  CHECK(driver.doGet(URL, 10000) == 705);
+  CHECK(!cache.open && cache.entries[URL].body == first && cache.entries[URL].etag == "W/\"abc123\"");
+
+  modem.failRead = false;
+  CHECK(driver.doGet(URL, 10000) == 200);
+  CHECK(!driver.isAnswerFromCache() && sink.data == modem.body);
+  CHECK(cache.entries[URL].body == modem.body && cache.entries[URL].etag == modem.etag);
+
+  CHECK(driver.doGet(URL, 10000) == 200);
+  CHECK(driver.isAnswerFromCache() && sink.data == modem.body && modem.notModified == 1);
+  printf("modified: OK\n");
+}
+
+// Answers without validators are not cached, a sink refusing the replay reports the
+// error at the read stage, and the URL in flash is not cached
+void testNotCached(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  MemoryCache cache;
+  CHECK(driver.setResponseCache(&cache));
+
+  modem.etag = "";
+  modem.lastModified = "";
+  CHECK(driver.doGet(URL, 10000) == 200);
+  CHECK(driver.doGet(URL, 10000) == 200);
+  CHECK(cache.begins == 0 && cache.entries.empty() && modem.reads == 2);
+  CHECK(modem.userData.empty());
+
+  modem.etag = "\"v1\"";
+  CHECK(driver.doGet(URL, 10000) == 200);
+  MemorySink sink;
+  sink.full = true;
+  driver.setResponseSink(&sink);
+  CHECK(driver.doGet(URL, 10000) == 708);
+  CHECK(driver.getLastError().stage == STAGE_READ && driver.getLastError().httpStatus == 304);
+  driver.setResponseSink(NULL);
+
+  uint16_t ends = cache.ends;
+  CHECK(driver.doGet(F(URL), 10000) == 200);
+  CHECK(cache.ends == ends && !driver.isAnswerFromCache());
+  printf("not cached: OK\n");
+}
+
+int main() {
+  DebugOutput debug;
+  testReplay(&debug);
+  testModified(&debug);
+  testNotCached(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
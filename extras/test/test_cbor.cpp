@@ -0,0 +1,254 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Encoder of CBOR documents: heads of the integers and lengths at each boundary of their
+// size, half precision floats chosen when exact and single precision elsewhere, overflow
+// of the buffer, and SIM800LCborPayload counting the same length as it writes, up to
+// the body posted to an emulated module
+#include <math.h>
+#include "HostTest.h"
+#include "SIM800L.h"
+#include "SIM800LCbor.h"
+
+// Bytes written by the encoder, in hexadecimal
+std::string hex(const uint8_t* data, uint16_t length) {
+  std::string result;
+  char digits[3];
+  for(uint16_t i = 0; i < length; i++) {
+    snprintf(digits, sizeof(digits), "%02x", data[i]);
+    result += digits;
+  }
+  return result;
+}
+
+// Encode one item in a buffer and compare it to the expected bytes
+#define ENCODED(items, expected) do { \
+    uint8_t buffer[64]; \
+    SIM800LCborEncoder encoder(buffer, sizeof(buffer)); \
+    encoder.items; \
+    CHECK(!encoder.hasError()); \
+    CHECK(hex(buffer, encoder.getLength()) == expected); \
+  } while(0)
+
+// Output recording the bytes written straight by the encoder
+class RecordOutput : public Print {
+  public:
+    size_t write(uint8_t c) { data += (char)c; return 1; }
+    std::string data;
+};
+
+// Typical record of a sensor
+void encodeRecord(SIM800LCborEncoder* encoder, void* context) {
+  (void)context;
+  encoder->beginMap(8);
+  encoder->addString("id", "dev-042");
+  encoder->addUInt("ts", 1700000000UL);
+  encoder->addFloat("t", 21.5f);
+  encoder->addFloat("h", 48.25f);
+  encoder->addFloat("p", 1013.2f);
+  encoder->addFloat("bat", 3.71f);
+  encoder->addInt("rssi", -71);
+  encoder->addBool("door", true);
+}
+
+// Argument of the head on 0, 1, 2 or 4 bytes, on both sides of each boundary
+void testIntegers(DebugOutput* debug) {
+  (void)debug;
+  ENCODED(writeUInt(0), "00");
+  ENCODED(writeUInt(23), "17");
+  ENCODED(writeUInt(24), "1818");
+  ENCODED(writeUInt(255), "18ff");
+  ENCODED(writeUInt(256), "190100");
+  ENCODED(writeUInt(65535), "19ffff");
+  ENCODED(writeUInt(65536), "1a00010000");
+  ENCODED(writeUInt(4294967295UL), "1affffffff");
+
+  // Negative values are encoded as -1 - argument
+  ENCODED(writeInt(-1), "20");
+  ENCODED(writeInt(-24), "37");
+  ENCODED(writeInt(-25), "3818");
+  ENCODED(writeInt(-256), "38ff");
+  ENCODED(writeInt(-257), "390100");
+  ENCODED(writeInt(-65536), "39ffff");
+  ENCODED(writeInt(-65537), "3a00010000");
+  ENCODED(writeInt(INT32_MIN), "3a7fffffff");
+  ENCODED(writeInt(INT32_MAX), "1a7fffffff");
+  ENCODED(writeInt(23), "17");
+  printf("integers: OK\n");
+}
+
+// Lengths of the strings and counts of the arrays and maps use the same heads
+void testLengths(DebugOutput* debug) {
+  (void)debug;
+  static const uint16_t lengths[] = {0, 23, 24, 255, 256, 300};
+  static const char* heads[] = {"60", "77", "7818", "78ff", "790100", "79012c"};
+  static char text[301];
+  memset(text, 'a', 300);
+  for(uint8_t i = 0; i < 6; i++) {
+    text[lengths[i]] = '\0';
+    uint8_t buffer[310];
+    SIM800LCborEncoder encoder(buffer, sizeof(buffer));
+    encoder.writeString(text);
+    CHECK(hex(buffer, encoder.getLength()).substr(0, strlen(heads[i])) == heads[i]);
+    CHECK(encoder.getLength() == strlen(heads[i]) / 2 + lengths[i]);
+    text[lengths[i]] = 'a';
+  }
+
+  const uint8_t data[] = {0x00, 0xFF};
+  ENCODED(writeBytes(data, 2), "4200ff");
+  ENCODED(writeString(F("IETF")), "6449455446");
+  ENCODED(beginArray(23), "97");
+  ENCODED(beginArray(24), "9818");
+  ENCODED(beginMap(256), "b90100");
+  ENCODED(beginMap(2); encoder.addUInt("a", 1); encoder.addBool("b", false), "a26161016162f4");
+  ENCODED(writeNull(), "f6");
+  printf("lengths: OK\n");
+}
+
+// Floats on 2 bytes when exact in half precision, on 4 bytes elsewhere
+void testFloats(DebugOutput* debug) {
+  (void)debug;
+  ENCODED(writeFloat(0.0f), "f90000");
+  ENCODED(writeFloat(-0.0f), "f98000");
+  ENCODED(writeFloat(1.5f), "f93e00");
+  ENCODED(writeFloat(21.5f), "f94d60");
+  ENCODED(writeFloat(65504.0f), "f97bff");
+  ENCODED(writeFloat(0.00006103515625f), "f90400");
+  ENCODED(writeFloat(INFINITY), "f97c00");
+  ENCODED(writeFloat(-INFINITY), "f9fc00");
+  ENCODED(writeFloat(NAN), "f97e00");
+
+  // Out of the range of the half precision, or with more than 10 bits of mantissa
+  ENCODED(writeFloat(65536.0f), "fa47800000");
+  ENCODED(writeFloat(100000.0f), "fa47c35000");
+  ENCODED(writeFloat(1013.2f), "fa447d4ccd");
+  ENCODED(writeFloat(1.0009765625f), "f93c01");
+  ENCODED(writeFloat(1.00048828125f), "fa3f801000");
+  ENCODED(writeFloat(3.4028234663852886e+38f), "fa7f7fffff");
+
+  // Each half precision value: the normal ones are kept on 2 bytes with the same bits,
+  // the subnormal ones fall back on 4 bytes with the same value
+  uint16_t halves = 0;
+  for(uint32_t bits = 0; bits <= 0xFFFF; bits++) {
+    uint16_t exponent = (bits >> 10) & 0x1F;
+    uint16_t mantissa = bits & 0x3FF;
+    if(exponent == 0x1F && mantissa != 0) {
+      continue;
+    }
+    float value = ldexpf(exponent == 0 ? mantissa : mantissa | 0x400, (exponent == 0 ? 1 : exponent) - 25);
+    if(exponent == 0x1F) {
+      value = INFINITY;
+    }
+    if(bits & 0x8000) {
+      value = -value;
+    }
+
+    uint8_t buffer[8];
+    SIM800LCborEncoder encoder(buffer, sizeof(buffer));
+    encoder.writeFloat(value);
+    if(exponent != 0 || mantissa == 0) {
+      CHECK(encoder.getLength() == 3 && buffer[0] == 0xF9);
+      CHECK((uint32_t)((buffer[1] << 8) | buffer[2]) == bits);
+      halves++;
+    } else {
+      uint32_t single = ((uint32_t)buffer[1] << 24) | ((uint32_t)buffer[2] << 16) | (buffer[3] << 8) | buffer[4];
+      float decoded;
+      memcpy(&decoded, &single, 4);
+      CHECK(encoder.getLength() == 5 && buffer[0] == 0xFA && decoded == value);
+    }
+  }
+  printf("floats: OK (%u values on 2 bytes)\n", halves);
+}
+
+// A buffer too small keeps the length required and reports the error until reset
+void testOverflow(DebugOutput* debug) {
+  (void)debug;
+  uint8_t buffer[4];
+  SIM800LCborEncoder encoder(buffer, sizeof(buffer));
+  encoder.writeString("hello");
+  CHECK(encoder.hasError() && encoder.getLength() == 6);
+  CHECK(hex(buffer, sizeof(buffer)) == "6568656c");
+  encoder.reset();
+  encoder.writeUInt(1000);
+  CHECK(!encoder.hasError() && encoder.getLength() == 3);
+  printf("overflow: OK\n");
+}
+
+// The payload counts the length with the same callback it writes with, and the module
+// receives exactly the announced length
+void testPayload(DebugOutput* debug) {
+  uint8_t buffer[64];
+  SIM800LCborEncoder inBuffer(buffer, sizeof(buffer));
+  encodeRecord(&inBuffer, NULL);
+  CHECK(!inBuffer.hasError());
+
+  SIM800LCborPayload payload(encodeRecord);
+  RecordOutput output;
+  payload.writeTo(&output);
+  CHECK(payload.getLength() == inBuffer.getLength());
+  CHECK(output.data == std::string((const char*)buffer, inBuffer.getLength()));
+  CHECK(strcmp(payload.getContentType(), SIM800L_CBOR_CONTENT_TYPE) == 0);
+
+  FakeModem modem;
+  std::string body;
+  modem.onLine = [&](const std::string& line) -> std::string {
+    if(line.compare(0, 12, "AT+HTTPDATA=") == 0) {
+      modem.rawExpected = atoi(line.c_str() + 12);
+      return "\r\nDOWNLOAD\r\n";
+    }
+    if(line.compare(0, 14, "AT+HTTPACTION=") == 0) {
+      modem.answer("\r\n+HTTPACTION: 1,201,0\r\n", 50);
+    }
+    return "\r\nOK\r\n";
+  };
+  modem.onRaw = [&](const std::string& raw) -> std::string {
+    body = raw;
+    return "\r\nOK\r\n";
+  };
+  SIM800L driver(&modem, RESET_PIN_NOT_USED, 200, 64, debug);
+  CHECK(driver.doPost("http://example.com/records", NULL, &payload, 5000, 5000) == 201);
+  CHECK(modem.log.find("AT+HTTPPARA=\"CONTENT\",\"application/cbor\"\r\n") != std::string::npos);
+  char announced[32];
+  snprintf(announced, sizeof(announced), "AT+HTTPDATA=%u,5000\r\n", payload.getLength());
+  CHECK(modem.log.find(announced) != std::string::npos);
+  CHECK(body == output.data);
+  printf("payload: OK (%u bytes)\n", payload.getLength());
+}
+
+int main() {
+  DebugOutput debug;
+  testIntegers(&debug);
+  testLengths(&debug);
+  testFloats(&debug);
+  testOverflow(&debug);
+  testPayload(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
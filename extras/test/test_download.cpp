@@ -0,0 +1,210 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Resumable download by windows of HTTPREAD against an emulated module: a window lost
+// in the middle of the transfer, resumed with the BREAK offset and a 206 answer (or the
+// whole resource again when the server ignores it), with the CRC32 of the data
+#include "HostTest.h"
+#include "SIM800L.h"
+
+#define RESOURCE_SIZE 1000
+#define WINDOW_SIZE 100
+
+// Sink in memory which refuses the data once full
+class MemorySink : public SIM800LSink {
+  public:
+    std::string data;
+    size_t capacity = RESOURCE_SIZE;
+
+    bool write(uint32_t offset, const uint8_t* chunk, uint16_t length) {
+      CHECK(offset == data.size());
+      if(data.size() + length > capacity) {
+        return false;
+      }
+      data.append((const char*)chunk, length);
+      return true;
+    }
+};
+
+// Module downloading a resource from a server which honors the BREAK offset (206) or not (200)
+class EmulatedModem {
+  public:
+    FakeModem stream;
+    std::string resource;
+    bool session = false;
+    bool honorRange = true;
+    uint32_t breakOffset = 0;
+    uint16_t maxWindow = 0xFFFF;   // Largest window provided by the module
+    int16_t dropRead = -1;         // Index of the HTTPREAD failing (connection lost)
+    uint16_t reads = 0;
+
+    EmulatedModem() {
+      for(uint16_t i = 0; i < RESOURCE_SIZE; i++) {
+        resource += (char)(i * 7 + i / 256);
+      }
+      stream.onLine = [this](const std::string& command) -> std::string {
+        if(command == "AT+HTTPINIT") {
+          if(session) {
+            return "\r\nERROR\r\n";
+          }
+          session = true;
+          breakOffset = 0;
+          return "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPTERM") {
+          if(!session) {
+            return "\r\nERROR\r\n";
+          }
+          session = false;
+          return "\r\nOK\r\n";
+        }
+        if(command.compare(0, 20, "AT+HTTPPARA=\"BREAK\",") == 0) {
+          breakOffset = atoi(command.c_str() + 20);
+          return "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPACTION=0") {
+          char urc[40];
+          if(breakOffset > 0 && honorRange) {
+            sprintf(urc, "\r\n+HTTPACTION: 0,206,%u\r\n", (unsigned)(resource.size() - breakOffset));
+          } else {
+            breakOffset = 0;
+            sprintf(urc, "\r\n+HTTPACTION: 0,200,%u\r\n", (unsigned)resource.size());
+          }
+          stream.answer(urc, 500);
+          return "\r\nOK\r\n";
+        }
+        if(command.compare(0, 12, "AT+HTTPREAD=") == 0) {
+          if(reads++ == dropRead) {
+            return "\r\nERROR\r\n";
+          }
+          unsigned start, length;
+          sscanf(command.c_str() + 12, "%u,%u", &start, &length);
+          std::string window = resource.substr(breakOffset + start, length < maxWindow ? length : maxWindow);
+          char header[32];
+          sprintf(header, "\r\n+HTTPREAD: %u\r\n", (unsigned)window.size());
+          return header + window + "\r\nOK\r\n";
+        }
+        return "\r\nOK\r\n";
+      };
+    }
+};
+
+// Reference CRC32 (IEEE 802.3, bit by bit)
+uint32_t referenceCRC32(const std::string& data) {
+  uint32_t crc = 0xFFFFFFFF;
+  for(size_t i = 0; i < data.size(); i++) {
+    crc ^= (uint8_t)data[i];
+    for(uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+// A window lost after the first one stops the download with the committed data kept,
+// the next call resumes at the offset and the server answers 206 with the rest
+void testResume(DebugOutput* debug) {
+  EmulatedModem modem;
+  modem.dropRead = 1;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  MemorySink sink;
+  SIM800LDownload download;
+
+  CHECK(driver.doDownload("http://example.com/fw.bin", &sink, &download, WINDOW_SIZE, 10000) == 705);
+  CHECK(download.offset == WINDOW_SIZE && download.totalSize == RESOURCE_SIZE);
+  CHECK(sink.data == modem.resource.substr(0, WINDOW_SIZE));
+  CHECK(download.crc32 == referenceCRC32(sink.data));
+  CHECK(!modem.session);
+
+  CHECK(driver.doDownload("http://example.com/fw.bin", &sink, &download, WINDOW_SIZE, 10000) == 206);
+  CHECK(modem.stream.log.find("AT+HTTPPARA=\"BREAK\",100\r\n") != std::string::npos);
+  CHECK(download.offset == RESOURCE_SIZE && download.totalSize == RESOURCE_SIZE);
+  CHECK(sink.data == modem.resource);
+  CHECK(download.crc32 == referenceCRC32(modem.resource));
+  CHECK(!modem.session);
+  printf("resume: OK (crc32 %08x)\n", (unsigned)download.crc32);
+}
+
+// A server ignoring the offset sends the whole resource again: the bytes already
+// committed are skipped, and windows shorter than requested are accepted
+void testFullAnswer(DebugOutput* debug) {
+  EmulatedModem modem;
+  modem.dropRead = 3;
+  modem.honorRange = false;
+  modem.maxWindow = 64;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  MemorySink sink;
+  SIM800LDownload download;
+
+  CHECK(driver.doDownload("http://example.com/fw.bin", &sink, &download, WINDOW_SIZE, 10000) == 705);
+  CHECK(download.offset == 3 * 64);
+  CHECK(driver.doDownload("http://example.com/fw.bin", &sink, &download, WINDOW_SIZE, 10000) == 200);
+  CHECK(modem.stream.log.find("AT+HTTPREAD=192,100\r\n") != std::string::npos);
+  CHECK(sink.data == modem.resource);
+  CHECK(download.crc32 == referenceCRC32(modem.resource));
+  printf("full answer: OK\n");
+}
+
+// A sink which refuses a window stops the download without committing it
+void testSinkFull(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  MemorySink sink;
+  sink.capacity = 250;
+  SIM800LDownload download;
+
+  CHECK(driver.doDownload("http://example.com/fw.bin", &sink, &download, WINDOW_SIZE, 10000) == 708);
+  CHECK(download.offset == 200 && sink.data.size() == 200);
+  CHECK(download.crc32 == referenceCRC32(modem.resource.substr(0, 200)));
+  CHECK(!modem.session);
+  printf("sink full: OK\n");
+}
+
+// CRC32 of the check value of the standard
+void testCheckValue(DebugOutput* debug) {
+  EmulatedModem modem;
+  modem.resource = "123456789";
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  MemorySink sink;
+  SIM800LDownload download;
+  CHECK(driver.doDownload("http://example.com/check.txt", &sink, &download, 4, 10000) == 200);
+  CHECK(download.crc32 == 0xCBF43926);
+  printf("check value: OK\n");
+}
+
+int main() {
+  DebugOutput debug;
+  testResume(&debug);
+  testFullAnswer(&debug);
+  testSinkFull(&debug);
+  testCheckValue(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
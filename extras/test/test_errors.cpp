@@ -0,0 +1,227 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Errors of the HTTP calls against an emulated module: classification of the HTTP
+// statuses and of the extended errors of the module (+CME ERROR), and retries resumed
+// from the stage which failed (new action, new read after the data already received,
+// or new session) with a delay doubling up to the maximum
+#include "HostTest.h"
+#include "SIM800L.h"
+
+const std::string BODY = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+// Sink in memory
+class MemorySink : public SIM800LSink {
+  public:
+    std::string data;
+
+    bool write(uint32_t offset, const uint8_t* chunk, uint16_t length) {
+      CHECK(offset == data.size());
+      data.append((const char*)chunk, length);
+      return true;
+    }
+};
+
+// Module counting the commands of each stage, with scripted failures
+class EmulatedModem {
+  public:
+    FakeModem stream;
+    uint16_t inits = 0, writes = 0, actions = 0, reads = 0, terms = 0;
+    uint8_t initFailures = 0;      // Next HTTPINIT refused with initCME
+    int16_t initCME = 3;
+    uint8_t serverErrors = 0;      // Next answers of the server with serverStatus
+    uint16_t serverStatus = 503;
+    uint8_t failedReads = 0;       // Next HTTPREAD refused
+    bool partialRead = false;      // Next HTTPREAD stops after 10 bytes
+
+    EmulatedModem() {
+      stream.onLine = [this](const std::string& command) -> std::string {
+        if(command == "AT+HTTPINIT") {
+          inits++;
+          if(initFailures > 0) {
+            initFailures--;
+            char answer[32];
+            sprintf(answer, "\r\n+CME ERROR: %d\r\n", initCME);
+            return answer;
+          }
+          return "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPTERM") {
+          terms++;
+          return "\r\nOK\r\n";
+        }
+        if(command.compare(0, 12, "AT+HTTPDATA=") == 0) {
+          writes++;
+          stream.rawExpected = atoi(command.c_str() + 12);
+          return "\r\nDOWNLOAD\r\n";
+        }
+        if(command.compare(0, 14, "AT+HTTPACTION=") == 0) {
+          actions++;
+          char urc[40];
+          sprintf(urc, "\r\n+HTTPACTION: %c,%u,%u\r\n", command[14], serverErrors > 0 ? serverStatus : 200, (unsigned)BODY.size());
+          if(serverErrors > 0) {
+            serverErrors--;
+          }
+          stream.answer(urc, 300);
+          return "\r\nOK\r\n";
+        }
+        if(command.compare(0, 11, "AT+HTTPREAD") == 0) {
+          reads++;
+          if(failedReads > 0) {
+            failedReads--;
+            return "\r\nERROR\r\n";
+          }
+          unsigned start = 0, length = BODY.size();
+          sscanf(command.c_str(), "AT+HTTPREAD=%u,%u", &start, &length);
+          char header[32];
+          sprintf(header, "\r\n+HTTPREAD: %u\r\n", length);
+          if(partialRead) {
+            partialRead = false;
+            return header + BODY.substr(start, 10);
+          }
+          return header + BODY.substr(start, length) + "\r\nOK\r\n";
+        }
+        return "\r\nOK\r\n";
+      };
+      stream.onRaw = [](const std::string& data) -> std::string {
+        (void)data;
+        return "\r\nOK\r\n";
+      };
+    }
+
+    void resetCounters() {
+      inits = writes = actions = reads = terms = 0;
+    }
+};
+
+// Without retry policy the error is reported once with its stage and its class
+void testClassification(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  CHECK(driver.enableExtendedErrors());
+  CHECK(modem.stream.log.find("AT+CMEE=1\r\n") != std::string::npos);
+
+  modem.serverErrors = 1;
+  CHECK(driver.doGet("http://example.com/", 10000) == 503);
+  SIM800LError error = driver.getLastError();
+  CHECK(error.stage == STAGE_SERVER && error.code == 503 && error.httpStatus == 503 && error.transient);
+  CHECK(modem.inits == 1 && modem.actions == 1 && modem.terms == 1);
+
+  // Statuses of the client are permanent, even with a retry policy
+  driver.setRetryPolicy(3, 100, 1000);
+  modem.resetCounters();
+  modem.serverErrors = 1;
+  modem.serverStatus = 404;
+  CHECK(driver.doGet("http://example.com/", 10000) == 404);
+  error = driver.getLastError();
+  CHECK(error.stage == STAGE_SERVER && error.httpStatus == 404 && !error.transient);
+  CHECK(modem.actions == 1);
+
+  CHECK(driver.doGet("http://example.com/", 10000) == 200);
+  CHECK(driver.getLastError().stage == STAGE_NONE && driver.getLastError().code == 0);
+  printf("classification: OK\n");
+}
+
+// Each retry restarts at the stage which failed: the action for the server, the read
+// after the data committed to the sink, without a new session or a new upload
+void testStageResume(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  driver.setRetryPolicy(3, 100, 150);
+
+  // Delays of 100 then 150 ms (doubled, capped at the maximum) before the retries
+  modem.serverErrors = 2;
+  unsigned long start = fakeNow;
+  CHECK(driver.doGet("http://example.com/", 10000) == 200);
+  CHECK(fakeNow - start >= 3 * 300 + 100 + 150);
+  CHECK(modem.inits == 1 && modem.actions == 3 && modem.terms == 1);
+  CHECK(strcmp(driver.getDataReceived(), BODY.c_str()) == 0);
+
+  // Too many failures: the last error is reported and the session closed
+  modem.resetCounters();
+  modem.serverErrors = 3;
+  CHECK(driver.doGet("http://example.com/", 10000) == 503);
+  CHECK(driver.getLastError().stage == STAGE_SERVER && modem.actions == 3 && modem.terms == 1);
+
+  // Read refused: read again, the payload is not uploaded twice
+  modem.resetCounters();
+  modem.failedReads = 1;
+  CHECK(driver.doPost("http://example.com/", "text/plain", "hello", 1000, 10000) == 200);
+  CHECK(modem.inits == 1 && modem.writes == 1 && modem.actions == 1 && modem.reads == 2 && modem.terms == 1);
+
+  // Read interrupted: the next read starts after the data already in the sink
+  MemorySink sink;
+  driver.setResponseSink(&sink);
+  modem.resetCounters();
+  modem.partialRead = true;
+  CHECK(driver.doGet("http://example.com/", 10000) == 200);
+  CHECK(modem.stream.log.find("AT+HTTPREAD=10,26\r\n") != std::string::npos);
+  CHECK(sink.data == BODY && modem.actions == 1 && modem.reads == 2);
+  printf("stage resume: OK\n");
+}
+
+// The extended error of the module decides: a permanent one stops at once, a transient
+// one is retried in a new session
+void testExtendedErrors(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  CHECK(driver.enableExtendedErrors());
+  driver.setRetryPolicy(3, 100, 1000);
+
+  modem.initFailures = 10;
+  CHECK(driver.doGet("http://example.com/", 10000) == 701);
+  SIM800LError error = driver.getLastError();
+  CHECK(error.stage == STAGE_INIT && error.code == 701 && error.cmeCode == 3 && !error.transient);
+  CHECK(modem.inits == 1 && modem.terms == 1);
+
+  modem.resetCounters();
+  modem.initFailures = 10;
+  modem.initCME = 181;
+  CHECK(driver.doGet("http://example.com/", 10000) == 701);
+  error = driver.getLastError();
+  CHECK(error.stage == STAGE_INIT && error.cmeCode == 181 && error.transient);
+  CHECK(modem.inits == 3 && modem.terms == 3 && modem.actions == 0);
+
+  // The session opens again at the second attempt
+  modem.resetCounters();
+  modem.initFailures = 1;
+  CHECK(driver.doGet("http://example.com/", 10000) == 200);
+  CHECK(modem.inits == 2 && modem.actions == 1 && driver.getLastError().cmeCode == -1);
+  printf("extended errors: OK\n");
+}
+
+int main() {
+  DebugOutput debug;
+  testClassification(&debug);
+  testStageResume(&debug);
+  testExtendedErrors(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
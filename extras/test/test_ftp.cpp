@@ -0,0 +1,216 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// FTP transfers against an emulated module: download by chunks with the data arriving
+// in bursts (+FTPGET: 1,1 again after an empty chunk), upload with the module accepting
+// less than offered, and the errors of the server (status code, silent server)
+#include "HostTest.h"
+#include "SIM800L.h"
+
+#define FILE_SIZE 1000
+#define CHUNK_SIZE 128
+#define MAX_PUT 70
+
+// Sink in memory
+class MemorySink : public SIM800LSink {
+  public:
+    std::string data;
+
+    bool write(uint32_t offset, const uint8_t* chunk, uint16_t length) {
+      CHECK(offset == data.size());
+      data.append((const char*)chunk, length);
+      return true;
+    }
+};
+
+// Source in memory
+class MemorySource : public SIM800LSource {
+  public:
+    std::string data;
+    size_t position = 0;
+
+    uint16_t read(uint8_t* buffer, uint16_t maxLength) {
+      size_t length = data.size() - position < maxLength ? data.size() - position : maxLength;
+      memcpy(buffer, data.data() + position, length);
+      position += length;
+      return length;
+    }
+};
+
+// Module with the FTP session state: the data of the server arrives by bursts
+class EmulatedModem {
+  public:
+    FakeModem stream;
+    std::string file;
+    std::string uploaded;
+    bool session = false;
+    uint16_t burstSize = 300;      // Bytes available on the module per burst of the server
+    uint16_t maxPut = MAX_PUT;     // Largest chunk accepted by the module on upload
+    uint16_t serverError = 0;      // Error of the server reported instead of the data
+    bool serverSilent = false;     // The server never answers
+    uint32_t position = 0;
+    uint32_t burstEnd = 0;
+    uint16_t quits = 0;
+
+    EmulatedModem() {
+      for(uint16_t i = 0; i < FILE_SIZE; i++) {
+        file += (char)('A' + i % 26);
+      }
+      stream.onLine = [this](const std::string& command) -> std::string {
+        if(command == "AT+FTPGET=1" || command == "AT+FTPPUT=1") {
+          if(session) {
+            return "\r\nERROR\r\n";
+          }
+          session = true;
+          position = 0;
+          burstEnd = burstSize;
+          bool get = command == "AT+FTPGET=1";
+          if(serverError > 0) {
+            session = false;
+            char urc[32];
+            sprintf(urc, "\r\n+FTP%s: 1,%u\r\n", get ? "GET" : "PUT", serverError);
+            stream.answer(urc, 800);
+          } else if(!serverSilent) {
+            stream.answer(get ? "\r\n+FTPGET: 1,1\r\n" : "\r\n+FTPPUT: 1,1,1360\r\n", 800);
+          }
+          return "\r\nOK\r\n";
+        }
+        if(command.compare(0, 12, "AT+FTPGET=2,") == 0) {
+          uint32_t end = std::min<uint32_t>(burstEnd, file.size());
+          std::string chunk = file.substr(position, std::min<uint32_t>(atoi(command.c_str() + 12), end - position));
+          position += chunk.size();
+          if(chunk.empty()) {
+            // Nothing more on the module for now: next burst or end of the file
+            burstEnd += burstSize;
+            if(position < file.size()) {
+              stream.answer("\r\n+FTPGET: 1,1\r\n", 300);
+            } else {
+              session = false;
+              stream.answer("\r\n+FTPGET: 1,0\r\n", 100);
+            }
+          }
+          char header[32];
+          sprintf(header, "\r\n+FTPGET: 2,%u\r\n", (unsigned)chunk.size());
+          return header + chunk + "\r\nOK\r\n";
+        }
+        if(command == "AT+FTPPUT=2,0") {
+          session = false;
+          stream.answer("\r\n+FTPPUT: 1,0\r\n", 200);
+          return "\r\nOK\r\n";
+        }
+        if(command.compare(0, 12, "AT+FTPPUT=2,") == 0) {
+          uint16_t accepted = std::min<uint16_t>(atoi(command.c_str() + 12), maxPut);
+          stream.rawExpected = accepted;
+          char answer[32];
+          sprintf(answer, "\r\n+FTPPUT: 2,%u\r\n", accepted);
+          return answer;
+        }
+        if(command == "AT+FTPQUIT") {
+          quits++;
+          session = false;
+        }
+        return "\r\nOK\r\n";
+      };
+      stream.onRaw = [this](const std::string& data) -> std::string {
+        uploaded += data;
+        stream.answer("\r\n+FTPPUT: 1,1,1360\r\n", 150);
+        return "\r\nOK\r\n";
+      };
+    }
+};
+
+// The file is downloaded across the bursts of the server and the session is closed by
+// the module at the end
+void testGet(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, CHUNK_SIZE, debug);
+  MemorySink sink;
+  CHECK(driver.ftpGet("/fw/", "fw.bin", &sink, CHUNK_SIZE, 10000) == 0);
+  CHECK(sink.data == modem.file);
+  CHECK(driver.getLastTransferSize() == FILE_SIZE);
+  CHECK(!modem.session && modem.quits == 0);
+  CHECK(modem.stream.log.find("AT+FTPGETNAME=\"fw.bin\"\r\nAT+FTPGETPATH=\"/fw/\"\r\n") != std::string::npos);
+  printf("get: OK\n");
+}
+
+// The data is uploaded in the chunks accepted by the module, then the end is announced
+void testPut(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, CHUNK_SIZE, debug);
+  MemorySource source;
+  source.data = modem.file;
+  CHECK(driver.ftpPut("/logs/", "log.txt", &source, CHUNK_SIZE, true, 10000) == 0);
+  CHECK(modem.uploaded == modem.file);
+  CHECK(driver.getLastTransferSize() == FILE_SIZE);
+  CHECK(modem.stream.log.find("AT+FTPPUTOPT=\"APPE\"\r\n") != std::string::npos);
+  CHECK(modem.stream.log.find("AT+FTPPUT=2,128\r\n") != std::string::npos);
+  size_t commands = 0;
+  for(size_t i = modem.stream.log.find("AT+FTPPUT=2,"); i != std::string::npos; i = modem.stream.log.find("AT+FTPPUT=2,", i + 1)) {
+    commands++;
+  }
+  CHECK(commands == (FILE_SIZE + MAX_PUT - 1) / MAX_PUT + 1);
+  CHECK(!modem.session);
+  printf("put: OK\n");
+}
+
+// The error of the server is returned as is (the module closes the session itself), a
+// silent server is a timeout and the session is quit by the driver
+void testErrors(DebugOutput* debug) {
+  EmulatedModem modem;
+  SIM800L driver(&modem.stream, RESET_PIN_NOT_USED, 200, CHUNK_SIZE, debug);
+  MemorySink sink;
+  MemorySource source;
+  source.data = modem.file;
+
+  modem.serverError = 66;
+  CHECK(driver.ftpGet("/fw/", "missing.bin", &sink, CHUNK_SIZE, 10000) == 66);
+  modem.serverError = 77;
+  CHECK(driver.ftpPut("/logs/", "log.txt", &source, CHUNK_SIZE, false, 10000) == 77);
+  CHECK(sink.data.empty() && modem.uploaded.empty() && modem.quits == 0);
+
+  modem.serverError = 0;
+  modem.serverSilent = true;
+  unsigned long start = fakeNow;
+  CHECK(driver.ftpGet("/fw/", "fw.bin", &sink, CHUNK_SIZE, 5000) == 408);
+  CHECK(fakeNow - start >= 5000 && fakeNow - start < 6000);
+  CHECK(modem.quits == 1 && !modem.session);
+  CHECK(driver.ftpPut("/logs/", "log.txt", &source, CHUNK_SIZE, false, 5000) == 408);
+  CHECK(modem.quits == 2 && !modem.session);
+  printf("errors: OK\n");
+}
+
+int main() {
+  DebugOutput debug;
+  testGet(&debug);
+  testPut(&debug);
+  testErrors(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
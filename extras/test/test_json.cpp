@@ -0,0 +1,170 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Streaming JSON scanner: the values extracted are the same whatever the chunks of the
+// document (split at each position, byte by byte, or by the windows of HTTPREAD of an
+// emulated module), and invalid documents are reported, also when split
+#include "HostTest.h"
+#include "SIM800L.h"
+#include "SIM800LJson.h"
+
+// Document with escapes, unicode, nested arrays and objects, numbers and literals
+const std::string DOCUMENT = "{\"status\":\"ok\",\"data\":{\"items\":[{\"id\":1,\"name\":\"a\\\"b\\u00e9\"},"
+  "{\"id\":22,\"tags\":[],\"name\":\"second\"}],\"count\":2,\"nested\":{\"x\":{}}},"
+  "\"flag\":true,\"pi\":-3.14e2,\"long\":\"0123456789abcdef\"} ";
+
+// Scanner with the paths of the document and the values expected
+class DocumentScanner : public SIM800LJsonScanner {
+  public:
+    char status[8], id[8], name0[16], name1[16], count[4], flag[6], pi[12], truncated[8], missing[4];
+
+    DocumentScanner() {
+      addPath("status", status, sizeof(status));
+      addPath("data.items.1.id", id, sizeof(id));
+      addPath("data.items.0.name", name0, sizeof(name0));
+      addPath("data.items.1.name", name1, sizeof(name1));
+      addPath("data.count", count, sizeof(count));
+      addPath("flag", flag, sizeof(flag));
+      addPath("pi", pi, sizeof(pi));
+      addPath("long", truncated, sizeof(truncated));
+    }
+
+    // Check the values extracted from the whole document
+    void check() {
+      CHECK(isComplete() && !hasError());
+      CHECK(strcmp(status, "ok") == 0);
+      CHECK(strcmp(id, "22") == 0);
+      CHECK(strcmp(name0, "a\"b\xc3\xa9") == 0);
+      CHECK(strcmp(name1, "second") == 0);
+      CHECK(strcmp(count, "2") == 0);
+      CHECK(strcmp(flag, "true") == 0);
+      CHECK(strcmp(pi, "-3.14e2") == 0);
+      CHECK(strcmp(truncated, "0123456") == 0);
+      for(uint8_t i = 0; i < 8; i++) {
+        CHECK(isFound(i));
+      }
+    }
+};
+
+// Write the document in chunks ending at the positions given
+bool writeChunks(SIM800LJsonScanner* scanner, const std::string& document, size_t first, size_t second) {
+  bool valid = scanner->write(0, (const uint8_t*)document.data(), first);
+  valid = scanner->write(first, (const uint8_t*)document.data() + first, second - first) && valid;
+  return scanner->write(second, (const uint8_t*)document.data() + second, document.size() - second) && valid;
+}
+
+// The document split in three chunks at every pair of positions, then byte by byte
+void testSplits(DebugOutput* debug) {
+  (void)debug;
+  DocumentScanner scanner;
+  uint32_t splits = 0;
+  for(size_t first = 1; first < DOCUMENT.size(); first++) {
+    for(size_t second = first; second < DOCUMENT.size(); second++) {
+      CHECK(writeChunks(&scanner, DOCUMENT, first, second));
+      scanner.check();
+      splits++;
+    }
+  }
+
+  scanner.write(0, (const uint8_t*)DOCUMENT.data(), 1);
+  CHECK(!scanner.isComplete() && !scanner.isFound(0));
+  for(size_t i = 1; i < DOCUMENT.size(); i++) {
+    CHECK(scanner.write(i, (const uint8_t*)DOCUMENT.data() + i, 1));
+  }
+  scanner.check();
+  printf("splits: OK (%u)\n", (unsigned)splits);
+}
+
+// The windows of HTTPREAD are given to the scanner as they arrive through doGet()
+void testResponseSink(DebugOutput* debug) {
+  FakeModem modem;
+  modem.onLine = [&](const std::string& command) -> std::string {
+    if(command == "ATI") {
+      return "\r\nSIM800 R14.18\r\n\r\nOK\r\n";
+    }
+    if(command == "AT+HTTPACTION=0") {
+      char urc[40];
+      sprintf(urc, "\r\n+HTTPACTION: 0,200,%u\r\n", (unsigned)DOCUMENT.size());
+      modem.answer(urc, 300);
+    }
+    if(command == "AT+HTTPREAD") {
+      char header[32];
+      sprintf(header, "\r\n+HTTPREAD: %u\r\n", (unsigned)DOCUMENT.size());
+      return header + DOCUMENT + "\r\nOK\r\n";
+    }
+    return "\r\nOK\r\n";
+  };
+  SIM800L driver(&modem, RESET_PIN_NOT_USED, 200, 32, debug);
+  DocumentScanner scanner;
+  driver.setResponseSink(&scanner);
+  CHECK(driver.doGet("http://example.com/items", 10000) == 200);
+  scanner.check();
+  printf("response sink: OK\n");
+}
+
+// Invalid documents are reported whatever the split, and the next document at offset 0
+// starts from a clean state
+void testInvalid(DebugOutput* debug) {
+  (void)debug;
+  static const char* invalid[] = {"{\"a\" 1}", "{\"a\":1 2}", "[1,,2]", "{\"a\":\"\\x\"}", "{\"a\":1}}", NULL};
+  char value[4];
+  for(uint8_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    // Last document: nested deeper than the scanner supports
+    std::string document = invalid[i] != NULL ? invalid[i] :
+      std::string(SIM800L_JSON_MAX_DEPTH + 1, '[') + "1" + std::string(SIM800L_JSON_MAX_DEPTH + 1, ']');
+    for(size_t first = 1; first < document.size(); first++) {
+      SIM800LJsonScanner scanner;
+      scanner.addPath("a", value, sizeof(value));
+      CHECK(!writeChunks(&scanner, document, first, first));
+      CHECK(scanner.hasError());
+
+      CHECK(scanner.write(0, (const uint8_t*)"{\"a\":12}", 8));
+      CHECK(scanner.isComplete() && scanner.isFound(0) && strcmp(value, "12") == 0);
+    }
+  }
+
+  // Valid but without the path, or not finished
+  SIM800LJsonScanner scanner;
+  scanner.addPath("a", value, sizeof(value));
+  CHECK(scanner.write(0, (const uint8_t*)"[1,{\"a\":5}]", 11));
+  CHECK(scanner.isComplete() && !scanner.isFound(0));
+  CHECK(scanner.write(0, (const uint8_t*)"{\"b\":[", 6));
+  CHECK(!scanner.isComplete() && !scanner.hasError());
+  printf("invalid: OK\n");
+}
+
+int main() {
+  DebugOutput debug;
+  testSplits(&debug);
+  testResponseSink(&debug);
+  testInvalid(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
@@ -0,0 +1,290 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Pool of modules against emulated modules: a request which fails to start or whose
+// server times out moves to another module, a server timeout closes the HTTP session,
+// unsolicited messages do not end the wait for the server, and the aggregate
+// throughput of the pool is measured against a single module
+#include "HostTest.h"
+#include "SIM800L.h"
+#include "SIM800LPool.h"
+
+#define BODY_SIZE 100
+
+// Module with the HTTP session state of the SIM800L: HTTPINIT fails while a session is open
+class EmulatedModem {
+  public:
+    FakeModem stream;
+    bool session = false;
+    uint8_t actionFailures = 0;   // Next HTTP actions refused by the module
+    bool serverSilent = false;    // The server never answers
+    bool unsolicited = false;     // The module sends unsolicited messages before the answer
+    unsigned long latencyMs = 500;
+    uint32_t served = 0;
+    uint32_t actions = 0;
+
+    EmulatedModem() {
+      stream.onLine = [this](const std::string& command) -> std::string {
+        if(command == "AT+HTTPINIT") {
+          if(session) {
+            return "\r\nERROR\r\n";
+          }
+          session = true;
+          return "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPTERM") {
+          if(!session) {
+            return "\r\nERROR\r\n";
+          }
+          session = false;
+          return "\r\nOK\r\n";
+        }
+        if(command == "ATI") {
+          return "\r\nSIM800 R14.18\r\n\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPACTION=0") {
+          if(actionFailures > 0) {
+            actionFailures--;
+            return "\r\nERROR\r\n";
+          }
+          actions++;
+          if(unsolicited) {
+            stream.answer("\r\n+CMTI: \"SM\",3\r\n", latencyMs / 4);
+            stream.answer("\r\nRING\r\n", latencyMs / 2);
+            stream.answer("\r\nUNDER-VOLTAGE WARNNING\r\n", latencyMs * 3 / 4);
+          }
+          if(!serverSilent) {
+            char urc[40];
+            sprintf(urc, "\r\n+HTTPACTION: 0,200,%u\r\n", BODY_SIZE);
+            stream.answer(urc, latencyMs);
+          }
+          return "\r\nOK\r\n";
+        }
+        if(command == "AT+HTTPREAD") {
+          served++;
+          char header[32];
+          sprintf(header, "\r\n+HTTPREAD: %u\r\n", BODY_SIZE);
+          return header + std::string(BODY_SIZE, 'x') + "\r\nOK\r\n";
+        }
+        return "\r\nOK\r\n";
+      };
+    }
+};
+
+struct Result {
+  uint16_t httpRC = 0;
+  SIM800L* modem = NULL;
+  bool done = false;
+};
+
+void onDone(SIM800L* modem, uint16_t httpRC, void* context) {
+  Result* result = (Result*)context;
+  result->httpRC = httpRC;
+  result->modem = modem;
+  result->done = true;
+}
+
+void runUntilIdle(SIM800LPool* pool) {
+  while(!pool->isIdle()) {
+    pool->loop();
+  }
+}
+
+// A module which refuses the action is left with its session closed and the job
+// moves to another module in the same pass
+void testFailover(DebugOutput* debug) {
+  EmulatedModem emulated[2];
+  SIM800L first(&emulated[0].stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  SIM800L second(&emulated[1].stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  SIM800LPool pool;
+  pool.addModem(&first);
+  pool.addModem(&second);
+
+  emulated[0].actionFailures = 1;
+  Result result;
+  CHECK(pool.enqueueGet("http://x/a", NULL, 10000, onDone, &result));
+  pool.loop();
+  CHECK(pool.getQueueSize() == 0);
+  CHECK(!emulated[0].session);
+  CHECK(emulated[1].session);
+  CHECK(pool.getStats(0)->failures == 1);
+
+  runUntilIdle(&pool);
+  CHECK(result.done && result.httpRC == 200 && result.modem == &second);
+  CHECK(!emulated[1].session);
+
+  // The module which failed is usable again
+  Result next;
+  CHECK(pool.enqueueGet("http://x/b", NULL, 10000, onDone, &next));
+  pool.loop();
+  pool.loop();
+  runUntilIdle(&pool);
+  CHECK(next.done && next.httpRC == 200);
+  printf("failover: OK\n");
+}
+
+// A server timeout is retried up to the maximum of attempts, reported once and
+// the session is closed for the next request
+void testTimeout(DebugOutput* debug) {
+  EmulatedModem emulated;
+  SIM800L modem(&emulated.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  SIM800LPool pool;
+  pool.addModem(&modem);
+
+  emulated.serverSilent = true;
+  Result timedOut;
+  CHECK(pool.enqueueGet("http://x/slow", NULL, 2000, onDone, &timedOut));
+  runUntilIdle(&pool);
+  CHECK(timedOut.done && timedOut.httpRC == 408);
+  CHECK(emulated.actions == SIM800L_POOL_MAX_ATTEMPTS);
+  CHECK(!emulated.session);
+  CHECK(pool.isDegraded(0));
+
+  // The next request waits for the end of the degradation
+  emulated.serverSilent = false;
+  Result next;
+  CHECK(pool.enqueueGet("http://x/fast", NULL, 2000, onDone, &next));
+  runUntilIdle(&pool);
+  CHECK(next.done && next.httpRC == 200);
+  CHECK(!pool.isDegraded(0));
+  printf("timeout: OK\n");
+}
+
+// A server timeout moves the job to another module, the caller is notified once
+void testTimeoutMoved(DebugOutput* debug) {
+  EmulatedModem emulated[2];
+  SIM800L first(&emulated[0].stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  SIM800L second(&emulated[1].stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  SIM800LPool pool;
+  pool.addModem(&first);
+  pool.addModem(&second);
+
+  emulated[0].serverSilent = true;
+  Result result;
+  CHECK(pool.enqueueGet("http://x/a", NULL, 2000, onDone, &result));
+  pool.loop();
+  CHECK(emulated[0].session && !emulated[1].session);
+  runUntilIdle(&pool);
+  CHECK(result.done && result.httpRC == 200 && result.modem == &second);
+  CHECK(emulated[0].actions == 1 && emulated[1].actions == 1);
+  CHECK(pool.getStats(0)->failures == 1 && pool.getStats(1)->failures == 0);
+  CHECK(!emulated[0].session && !emulated[1].session);
+
+  // Both servers silent: the job is given up after the maximum of attempts
+  emulated[1].serverSilent = true;
+  Result failed;
+  CHECK(pool.enqueueGet("http://x/b", NULL, 2000, onDone, &failed));
+  runUntilIdle(&pool);
+  CHECK(failed.done && failed.httpRC == 408);
+  CHECK(emulated[0].actions + emulated[1].actions == 2 + SIM800L_POOL_MAX_ATTEMPTS);
+  printf("timeout moved: OK\n");
+}
+
+// Unsolicited messages of the module (+CMTI, RING, UNDER-VOLTAGE) do not end the wait
+// for the server, through the pool and through doGet()
+void testUnsolicited(DebugOutput* debug) {
+  EmulatedModem emulated;
+  emulated.unsolicited = true;
+  SIM800L modem(&emulated.stream, RESET_PIN_NOT_USED, 200, 128, debug);
+  SIM800LPool pool;
+  pool.addModem(&modem);
+
+  Result result;
+  CHECK(pool.enqueueGet("http://x/a", NULL, 10000, onDone, &result));
+  pool.loop();
+  unsigned long start = fakeNow;
+  while(fakeNow - start < emulated.latencyMs * 7 / 8) {
+    pool.loop();
+  }
+  CHECK(!result.done);
+  runUntilIdle(&pool);
+  CHECK(result.done && result.httpRC == 200);
+  CHECK(modem.getDataSizeReceived() == BODY_SIZE);
+  CHECK(emulated.actions == 1);
+  CHECK(pool.getStats(0)->failures == 0);
+
+  CHECK(modem.doGet("http://x/b", 10000) == 200);
+  CHECK(modem.getDataSizeReceived() == BODY_SIZE);
+  CHECK(emulated.actions == 2);
+  printf("unsolicited: OK\n");
+}
+
+// Time to serve a batch of requests with a number of modules (simulated millisec)
+unsigned long benchmark(uint8_t modemCount, uint8_t requestCount, uint32_t* throughput, DebugOutput* debug) {
+  EmulatedModem emulated[SIM800L_POOL_MAX_MODEMS];
+  SIM800L* modems[SIM800L_POOL_MAX_MODEMS];
+  SIM800LPool pool;
+  for(uint8_t i = 0; i < modemCount; i++) {
+    emulated[i].latencyMs = 2000;
+    modems[i] = new SIM800L(&emulated[i].stream, RESET_PIN_NOT_USED, 200, 128, debug);
+    pool.addModem(modems[i]);
+  }
+
+  Result results[SIM800L_POOL_QUEUE_SIZE];
+  unsigned long start = fakeNow;
+  for(uint8_t i = 0; i < requestCount; i++) {
+    CHECK(pool.enqueueGet("http://x/bench", NULL, 10000, onDone, &results[i]));
+  }
+  runUntilIdle(&pool);
+  unsigned long elapsed = fakeNow - start;
+
+  for(uint8_t i = 0; i < requestCount; i++) {
+    CHECK(results[i].done && results[i].httpRC == 200);
+  }
+  *throughput = pool.getThroughput();
+  for(uint8_t i = 0; i < modemCount; i++) {
+    delete modems[i];
+  }
+  return elapsed;
+}
+
+void testThroughput(DebugOutput* debug) {
+  uint32_t single = 0;
+  uint32_t aggregate = 0;
+  unsigned long singleMs = benchmark(1, SIM800L_POOL_QUEUE_SIZE, &single, debug);
+  unsigned long poolMs = benchmark(SIM800L_POOL_MAX_MODEMS, SIM800L_POOL_QUEUE_SIZE, &aggregate, debug);
+  printf("throughput: 1 module %lu ms (%u B/s), %u modules %lu ms (%u B/s)\n",
+    singleMs, (unsigned)single, SIM800L_POOL_MAX_MODEMS, poolMs, (unsigned)aggregate);
+
+  // The servers are awaited in parallel
+  CHECK(poolMs * 2 < singleMs);
+  CHECK(aggregate > single * 2);
+}
+
+int main() {
+  DebugOutput debug;
+  testFailover(&debug);
+  testTimeout(&debug);
+  testTimeoutMoved(&debug);
+  testUnsolicited(&debug);
+  testThroughput(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
@@ -0,0 +1,133 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Ring buffer between the serial link and the driver: bytes moved by pump(), push mode
+// with pump() disabled, and a producer thread (like an emulator or a receive task)
+// pushing while the driver consumes the spans. Built with ThreadSanitizer.
+#include "HostTest.h"
+#include "SIM800LRing.h"
+#include <thread>
+
+#define STREAM_SIZE 200000
+
+// Serial link holding the bytes received
+class SerialLink : public Stream {
+  public:
+    std::string rx;
+    std::string tx;
+    size_t write(uint8_t c) { tx += (char)c; return 1; }
+    int available() { return rx.size(); }
+    int read() {
+      if(rx.empty()) {
+        return -1;
+      }
+      int c = (uint8_t)rx[0];
+      rx.erase(0, 1);
+      return c;
+    }
+    int peek() { return rx.empty() ? -1 : (uint8_t)rx[0]; }
+};
+
+void testPump() {
+  SerialLink serial;
+  SIM800LRing ring(&serial, 8);
+  serial.rx = "\r\nOK\r\n+CSQ: 18,0\r\n";
+
+  // The bytes are moved while there is room (one slot is kept free), the rest waits
+  CHECK(ring.available() == 7);
+  CHECK(serial.rx.size() == 11);
+  uint8_t data[32];
+  CHECK(ring.read(data, 18, 100) == 18);
+  CHECK(memcmp(data, "\r\nOK\r\n+CSQ: 18,0\r\n", 18) == 0);
+  CHECK(ring.getOverflowCount() == 0);
+
+  ring.write((const uint8_t*)"AT\r\n", 4);
+  CHECK(serial.tx == "AT\r\n");
+  printf("pump: OK\n");
+}
+
+void testPushMode() {
+  SerialLink serial;
+  SIM800LRing ring(&serial, 8);
+  ring.setPushMode(true);
+  serial.rx = "ignored";
+
+  // Only the bytes pushed are received, the serial link is not read
+  CHECK(ring.available() == 0);
+  for(uint8_t i = 0; i < 10; i++) {
+    ring.push('a' + i);
+  }
+  CHECK(ring.available() == 7 && ring.getOverflowCount() == 3);
+  CHECK(serial.rx == "ignored");
+  CHECK(ring.read() == 'a' && ring.peek() == 'b');
+  printf("push mode: OK\n");
+}
+
+void testProducerThread() {
+  SerialLink serial;
+  SIM800LRing ring(&serial, 64);
+  ring.setPushMode(true);
+
+  std::thread producer([&ring] {
+    for(uint32_t i = 0; i < STREAM_SIZE; i++) {
+      while(!ring.push((uint8_t)(i % 251))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  // The driver consumes the contiguous spans while the producer fills the buffer
+  uint32_t received = 0;
+  bool ordered = true;
+  while(received < STREAM_SIZE) {
+    const uint8_t* data;
+    uint16_t length = ring.span(&data);
+    for(uint16_t i = 0; i < length; i++) {
+      ordered = ordered && data[i] == (uint8_t)((received + i) % 251);
+    }
+    ring.consume(length);
+    received += length;
+    if(length == 0) {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+
+  CHECK(ordered && ring.available() == 0);
+  printf("producer thread: OK (%u bytes, %u retries on full buffer)\n", (unsigned)received, (unsigned)ring.getOverflowCount());
+}
+
+int main() {
+  testPump();
+  testPushMode();
+  testProducerThread();
+  printf("ALL OK\n");
+  return 0;
+}
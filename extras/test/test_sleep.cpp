@@ -0,0 +1,161 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Sleep with the slow clock against an emulated module which sleeps by itself when its
+// serial line is idle (AT+CSCLK=2): the characters received while asleep and during the
+// 100 ms after waking up are lost, like on the SIM800L
+#include "HostTest.h"
+#include "SIM800L.h"
+
+#define WAKE_GUARD 100
+
+// Serial line of a module with the automatic slow clock
+class SleepyModem : public Stream {
+  public:
+    FakeModem module;
+    bool slowClock = false;
+    uint32_t dropped = 0;
+    uint32_t wakeUps = 0;
+
+    SleepyModem() {
+      module.onLine = [this](const std::string& command) -> std::string {
+        if(command == "AT+CSCLK=2") {
+          slowClock = true;
+        } else if(command == "AT+CSCLK=0") {
+          slowClock = false;
+        } else if(command == "AT+CSQ") {
+          return "\r\n+CSQ: 18,0\r\n\r\nOK\r\n";
+        }
+        return "\r\nOK\r\n";
+      };
+    }
+
+    bool isAsleep() {
+      return slowClock && fakeNow - lastActivity >= SIM800L_SLEEP_IDLE_DELAY;
+    }
+
+    size_t write(uint8_t c) {
+      if(isAsleep()) {
+        wakeUps++;
+        waking = true;
+        awakeSince = fakeNow;
+      }
+      lastActivity = fakeNow;
+      if(waking && fakeNow - awakeSince < WAKE_GUARD) {
+        dropped++;
+        return 1;
+      }
+      return module.write(c);
+    }
+
+    int available() {
+      return module.available();
+    }
+
+    int read() {
+      int c = module.read();
+      if(c >= 0) {
+        lastActivity = fakeNow;
+      }
+      return c;
+    }
+
+    int peek() {
+      return module.peek();
+    }
+
+  private:
+    unsigned long lastActivity = 0;
+    bool waking = false;
+    unsigned long awakeSince = 0;
+};
+
+// The module which fell asleep by itself is woken up before the next command
+void testAutomaticSleep(DebugOutput* debug) {
+  SleepyModem modem;
+  SIM800L driver(&modem, RESET_PIN_NOT_USED, 200, 128, debug);
+  CHECK(driver.enableSleep());
+
+  // Commands in a row: the module stays awake, no waking characters
+  for(uint8_t i = 0; i < 3; i++) {
+    CHECK(driver.getSignal() == 18);
+    delay(1000);
+  }
+  CHECK(!driver.isSleeping() && modem.dropped == 0);
+
+  // Idle serial line: the module sleeps by itself and loses the waking characters only
+  delay(SIM800L_SLEEP_IDLE_DELAY);
+  CHECK(modem.isAsleep() && driver.isSleeping());
+  CHECK(driver.getSignal() == 18);
+  CHECK(modem.wakeUps == 1 && modem.dropped == 4);
+  CHECK(!driver.isSleeping());
+
+  // Several idle periods
+  for(uint8_t i = 0; i < 3; i++) {
+    delay(SIM800L_SLEEP_IDLE_DELAY + 1000);
+    CHECK(driver.getSignal() == 18);
+  }
+  CHECK(modem.wakeUps == 4);
+  printf("automatic sleep: OK (%u waking characters dropped)\n", (unsigned)modem.dropped);
+}
+
+// Time spent sleeping by itself once the idle delay elapsed
+void testPowerStats(DebugOutput* debug) {
+  SleepyModem modem;
+  SIM800L driver(&modem, RESET_PIN_NOT_USED, 200, 128, debug);
+  CHECK(driver.enableSleep());
+  driver.resetPowerStats();
+
+  delay(SIM800L_SLEEP_IDLE_DELAY + 10000);
+  uint32_t awake = driver.getTimeAwake();
+  uint32_t sleeping = driver.getTimeSleeping();
+  CHECK(awake > SIM800L_SLEEP_IDLE_DELAY - 100 && awake <= SIM800L_SLEEP_IDLE_DELAY);
+  CHECK(sleeping >= 9900 && sleeping <= 10100);
+
+  CHECK(driver.getSignal() == 18);
+  CHECK(driver.getTimeSleeping() >= sleeping);
+  uint32_t charge = driver.getEstimatedCharge();
+  CHECK(charge > 0);
+
+  // Disabled slow clock: always awake
+  CHECK(driver.disableSleep());
+  delay(2 * SIM800L_SLEEP_IDLE_DELAY);
+  CHECK(!driver.isSleeping() && !modem.isAsleep());
+  CHECK(driver.getSignal() == 18);
+  printf("power stats: OK (awake %u ms, sleeping %u ms, %u uAh)\n", (unsigned)awake, (unsigned)sleeping, (unsigned)charge);
+}
+
+int main() {
+  DebugOutput debug;
+  testAutomaticSleep(&debug);
+  testPowerStats(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
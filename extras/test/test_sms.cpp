@@ -0,0 +1,319 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// SMS in PDU mode against an emulated storage of messages: GSM 7 bits packing, headers of
+// the concatenated messages, binary coding, decoding of the CMGL listing and deletion of
+// the messages read in one command (one by one if some messages cannot be decoded)
+#include "HostTest.h"
+#include "SIM800L.h"
+#include <map>
+#include <vector>
+
+#define CAPACITY 100
+
+std::string fromHex(const std::string& hex) {
+  std::string bytes;
+  for(size_t i = 0; i + 1 < hex.size(); i += 2) {
+    bytes += (char)strtoul(hex.substr(i, 2).c_str(), NULL, 16);
+  }
+  return bytes;
+}
+
+std::string toHex(const std::string& bytes) {
+  std::string hex;
+  char digits[3];
+  for(size_t i = 0; i < bytes.size(); i++) {
+    sprintf(digits, "%02X", (uint8_t)bytes[i]);
+    hex += digits;
+  }
+  return hex;
+}
+
+// Message stored on the module
+struct StoredSMS {
+  std::string pdu;   // Hexadecimal PDU listed by CMGL
+  bool read;
+};
+
+// Module storing the messages sent to itself (SMS-SUBMIT turned into SMS-DELIVER)
+class EmulatedModem {
+  public:
+    FakeModem stream;
+    std::map<uint16_t, StoredSMS> storage;
+    std::vector<std::string> submitted;    // TPDU of the messages sent (hexadecimal)
+    std::vector<std::string> deletions;    // Delete commands received
+    std::string arrivingPdu;               // Message received while listing the storage
+    uint16_t tpduLength = 0;
+
+    EmulatedModem() {
+      stream.onLine = [this](const std::string& command) -> std::string {
+        if(command.compare(0, 8, "AT+CMGS=") == 0) {
+          tpduLength = atoi(command.c_str() + 8);
+          return "\r\n> ";
+        }
+        if(command == "AT+CPMS?") {
+          char answer[80];
+          sprintf(answer, "\r\n+CPMS: \"SM\",%u,%u,\"SM\",%u,%u,\"SM\",%u,%u\r\n\r\nOK\r\n",
+            (unsigned)storage.size(), CAPACITY, (unsigned)storage.size(), CAPACITY, (unsigned)storage.size(), CAPACITY);
+          return answer;
+        }
+        if(command == "AT+CMGL=4") {
+          return list();
+        }
+        if(command.compare(0, 8, "AT+CMGD=") == 0) {
+          deletions.push_back(command.substr(8));
+          if(command == "AT+CMGD=1,1") {
+            for(std::map<uint16_t, StoredSMS>::iterator it = storage.begin(); it != storage.end();) {
+              it = it->second.read ? storage.erase(it) : ++it;
+            }
+          } else if(storage.erase(atoi(command.c_str() + 8)) == 0) {
+            return "\r\nERROR\r\n";
+          }
+        }
+        return "\r\nOK\r\n";
+      };
+      stream.onRaw = [this](const std::string& data) -> std::string {
+        submitted.push_back(data);
+        store(deliverFromSubmit(fromHex(data)));
+        return "\r\n+CMGS: 7\r\n\r\nOK\r\n";
+      };
+    }
+
+    // Store a new message (unread) at the first free index
+    uint16_t store(const std::string& pdu) {
+      uint16_t index = 1;
+      while(storage.count(index) > 0) {
+        index++;
+      }
+      storage[index].pdu = pdu;
+      storage[index].read = false;
+      return index;
+    }
+
+  private:
+    // List all the messages and mark them as read, a message can arrive just after the listing
+    std::string list() {
+      std::string answer = "\r\n";
+      for(std::map<uint16_t, StoredSMS>::iterator it = storage.begin(); it != storage.end(); ++it) {
+        char header[40];
+        sprintf(header, "+CMGL: %u,%u,,%u\r\n", it->first, it->second.read ? 1 : 0, (unsigned)it->second.pdu.size() / 2 - 1);
+        answer += header + it->second.pdu + "\r\n";
+        it->second.read = true;
+      }
+      if(!arrivingPdu.empty()) {
+        store(arrivingPdu);
+        arrivingPdu.clear();
+      }
+      return answer + "\r\nOK\r\n";
+    }
+
+    // SMS-DELIVER with the content of an SMS-SUBMIT (the recipient becomes the sender)
+    std::string deliverFromSubmit(const std::string& submit) {
+      CHECK(submit[0] == 0x00);
+      std::string tpdu = submit.substr(1);
+      CHECK(tpdu.size() == tpduLength);
+      uint8_t firstOctet = tpdu[0];
+      size_t addressSize = 2 + ((uint8_t)tpdu[2] + 1) / 2;
+      std::string deliver;
+      deliver += (char)0x00;
+      deliver += (char)(firstOctet & 0x40);
+      deliver += tpdu.substr(2, addressSize);
+      deliver += tpdu.substr(2 + addressSize, 2);
+      deliver += fromHex("21107021000000");
+      deliver += tpdu.substr(4 + addressSize);
+      return toHex(deliver);
+    }
+};
+
+// Messages given to the callback
+struct Received {
+  uint16_t index;
+  std::string content;
+  std::string sender;
+  std::string timestamp;
+  uint8_t reference;
+  uint8_t count;
+  uint8_t number;
+  bool binary;
+};
+
+void onSMS(SIM800LSMS* sms, void* context) {
+  std::vector<Received>* received = (std::vector<Received>*)context;
+  CHECK(sms->binary || sms->data[sms->length] == '\0');
+  Received message = {sms->index, std::string((const char*)sms->data, sms->length), sms->sender, sms->timestamp,
+    sms->partReference, sms->partCount, sms->partNumber, sms->binary};
+  received->push_back(message);
+}
+
+// Reference example of the GSM 03.40 PDU format: "hellohello" packed in 9 bytes
+void testPacking(DebugOutput* debug) {
+  EmulatedModem emulated;
+  SIM800L modem(&emulated.stream, RESET_PIN_NOT_USED, 200, 256, debug);
+  CHECK(modem.setupSMS());
+  CHECK(modem.sendSMS("+27838890001", "hellohello"));
+  CHECK(emulated.submitted.size() == 1);
+  CHECK(emulated.submitted[0] == "0001000B917238880900F100000AE8329BFD4697D9EC37");
+
+  // The characters out of the GSM alphabet are replaced, the special ones are mapped
+  CHECK(modem.sendSMS("0470", "@$_~"));
+  CHECK(emulated.submitted[1] == "000100048140070000040041E407");
+  printf("packing: OK\n");
+}
+
+// Long texts and binary data are split in concatenated parts with a user data header
+void testConcatenation(DebugOutput* debug) {
+  EmulatedModem emulated;
+  SIM800L modem(&emulated.stream, RESET_PIN_NOT_USED, 200, 256, debug);
+  CHECK(modem.setupSMS());
+
+  std::string text;
+  for(int i = 0; i < 400; i++) {
+    text += "abcdefghij@$_ 0123456789XYZ"[i % 27];
+  }
+  CHECK(modem.sendSMS("+32470123456", text.c_str()));
+  CHECK(emulated.submitted.size() == 3);
+  // SMS-SUBMIT with header, 7 septets of header + 153 characters, reference 1, part 1 of 3
+  CHECK(emulated.submitted[0].compare(0, 6, "004100") == 0);
+  CHECK(emulated.submitted[0].substr(22, 18) == "0000A0050003010301");
+  // Last part: 94 characters
+  CHECK(emulated.submitted[2].substr(22, 18) == "000065050003010303");
+
+  uint8_t data[300];
+  for(int i = 0; i < 300; i++) {
+    data[i] = i * 7;
+  }
+  CHECK(modem.sendBinarySMS("0470123", data, 3));
+  // 8 bits coding, 3 bytes
+  CHECK(emulated.submitted[3] == "0001000781400721F300040300070E");
+  CHECK(modem.sendBinarySMS("0470123", data, 300));
+  CHECK(emulated.submitted.size() == 4 + 3);
+  // 6 bytes of header + 134 bytes, reference 2
+  CHECK(emulated.submitted[4].substr(18, 18) == "00048C050003020301");
+
+  // All the parts are read back in order
+  std::vector<Received> received;
+  CHECK(modem.readAllSMS(onSMS, &received, false) == 7);
+  std::string joined;
+  for(int i = 0; i < 3; i++) {
+    CHECK(received[i].count == 3 && received[i].number == i + 1 && !received[i].binary);
+    CHECK(received[i].sender == "+32470123456" && received[i].timestamp == "12/01/07,12:00:00");
+    joined += received[i].content;
+  }
+  CHECK(joined == text);
+  CHECK(received[3].binary && received[3].count == 0 && received[3].content == std::string((const char*)data, 3));
+  std::string binary;
+  for(int i = 4; i < 7; i++) {
+    CHECK(received[i].binary && received[i].count == 3 && received[i].number == i - 3 && received[i].sender == "0470123");
+    binary += received[i].content;
+  }
+  CHECK(binary == std::string((const char*)data, 300));
+  CHECK(received[0].reference != received[4].reference);
+  printf("concatenation: OK\n");
+}
+
+// Listing of messages received from the network: numeric and alphanumeric senders, 16 bits reference
+void testListing(DebugOutput* debug) {
+  EmulatedModem emulated;
+  SIM800L modem(&emulated.stream, RESET_PIN_NOT_USED, 200, 256, debug);
+  CHECK(modem.setupSMS());
+  emulated.store("07917283010010F5040BC87238880900F10000993092516195800AE8329BFD4697D9EC37");
+  emulated.store("07917283010010F504" "07D0C2B07B0D" "0000993092516195800AE8329BFD4697D9EC37");
+  emulated.store("07917283010010F5440BC87238880900F10000993092516195800D" "06080401020302" "E8329BFD06");
+
+  std::vector<Received> received;
+  CHECK(modem.readAllSMS(onSMS, &received, false) == 3);
+  CHECK(received[0].index == 1 && received[0].content == "hellohello" && received[0].sender == "27838890001");
+  CHECK(received[0].timestamp == "99/03/29,15:16:59");
+  CHECK(received[1].sender == "Bank" && received[1].content == "hellohello");
+  CHECK(received[2].content == "hello" && received[2].reference == 2 && received[2].count == 3 && received[2].number == 2);
+  printf("listing: OK\n");
+}
+
+// The messages read are deleted in one command, a message received during the listing is kept
+void testBatchDelete(DebugOutput* debug) {
+  EmulatedModem emulated;
+  SIM800L modem(&emulated.stream, RESET_PIN_NOT_USED, 200, 256, debug);
+  CHECK(modem.setupSMS());
+  for(int i = 0; i < 5; i++) {
+    CHECK(modem.sendSMS("+32470123456", "ping"));
+  }
+  emulated.arrivingPdu = "07917283010010F5040BC87238880900F10000993092516195800AE8329BFD4697D9EC37";
+
+  std::vector<Received> received;
+  CHECK(modem.readAllSMS(onSMS, &received, true) == 5);
+  CHECK(emulated.deletions.size() == 1 && emulated.deletions[0] == "1,1");
+  CHECK(emulated.storage.size() == 1 && !emulated.storage.begin()->second.read);
+
+  received.clear();
+  CHECK(modem.readAllSMS(onSMS, &received, true) == 1 && received[0].content == "hellohello");
+  CHECK(emulated.storage.empty());
+  printf("batch delete: OK\n");
+}
+
+// The messages which cannot be decoded are kept, the others are deleted one by one
+// at any index of the storage
+void testInvalidMessages(DebugOutput* debug) {
+  EmulatedModem emulated;
+  SIM800L modem(&emulated.stream, RESET_PIN_NOT_USED, 200, 256, debug);
+  for(uint16_t index = 1; index < 70; index++) {
+    emulated.storage[index].pdu = index == 20 ? "ZZZZ" : "07917283010010F5040BC87238880900F10000993092516195800AE8329BFD4697D9EC37";
+    emulated.storage[index].read = false;
+  }
+  CHECK(modem.setupSMS());
+
+  std::vector<Received> received;
+  CHECK(modem.readAllSMS(onSMS, &received, true) == 68);
+  CHECK(emulated.deletions.size() == 68);
+  CHECK(emulated.storage.size() == 1 && emulated.storage.count(20) == 1);
+  printf("invalid messages: OK\n");
+}
+
+// New message notified by the module
+void testNotification(DebugOutput* debug) {
+  EmulatedModem emulated;
+  SIM800L modem(&emulated.stream, RESET_PIN_NOT_USED, 200, 256, debug);
+  emulated.stream.answer("\r\n+CMTI: \"SM\",12\r\n");
+  delay(5);
+  CHECK(modem.checkNewSMS() == 12);
+  CHECK(modem.checkNewSMS() == -1);
+  printf("notification: OK\n");
+}
+
+int main() {
+  DebugOutput debug;
+  testPacking(&debug);
+  testConcatenation(&debug);
+  testListing(&debug);
+  testBatchDelete(&debug);
+  testInvalidMessages(&debug);
+  testNotification(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
@@ -0,0 +1,189 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Timeouts derived from the latency (computeTimeout()): convergence of the average and
+// of the variation, doubling after a timeout, clamping between 1 second and the maximum
+// of the specifications, override and default timeouts, against an emulated module
+#include "HostTest.h"
+#include "SIM800L.h"
+
+#define MAX_TIMEOUT 65000
+
+// Driver giving access to the estimator of the timeouts
+class TimeoutDriver : public SIM800L {
+  public:
+    TimeoutDriver(Stream* stream, Stream* debug) : SIM800L(stream, RESET_PIN_NOT_USED, 200, 128, debug) {}
+    using SIM800L::computeTimeout;
+    using SIM800L::recordLatency;
+};
+
+// Nothing is derived before enough answers (or when disabled): the maximum timeout is used
+void testDefault(DebugOutput* debug) {
+  FakeModem modem;
+  TimeoutDriver driver(&modem, debug);
+  for(uint8_t i = 0; i < SIM800L_TIMEOUT_MIN_SAMPLES; i++) {
+    driver.recordLatency(TIMEOUT_NETWORK, 2000, true);
+  }
+  CHECK(driver.computeTimeout(TIMEOUT_NETWORK, MAX_TIMEOUT) == MAX_TIMEOUT);
+
+  driver.enableAdaptiveTimeouts(true);
+  CHECK(driver.computeTimeout(TIMEOUT_NETWORK, MAX_TIMEOUT) < MAX_TIMEOUT);
+  driver.recordLatency(TIMEOUT_SERVER, 2000, true);
+  CHECK(driver.computeTimeout(TIMEOUT_SERVER, MAX_TIMEOUT) == MAX_TIMEOUT);
+  printf("default: OK\n");
+}
+
+// The average converges to a stable latency and the variation vanishes,
+// a jittery latency keeps a margin of 4 x its variation
+void testConvergence(DebugOutput* debug) {
+  FakeModem modem;
+  TimeoutDriver driver(&modem, debug);
+  driver.enableAdaptiveTimeouts(true);
+
+  driver.recordLatency(TIMEOUT_NETWORK, 8000, true);
+  for(uint8_t i = 0; i < 60; i++) {
+    driver.recordLatency(TIMEOUT_NETWORK, 4000, true);
+  }
+  CHECK(driver.getAverageLatency(TIMEOUT_NETWORK) >= 4000 && driver.getAverageLatency(TIMEOUT_NETWORK) <= 4010);
+  uint16_t stable = driver.computeTimeout(TIMEOUT_NETWORK, MAX_TIMEOUT);
+  CHECK(stable >= 4000 && stable <= 4050);
+
+  for(uint8_t i = 0; i < 60; i++) {
+    driver.recordLatency(TIMEOUT_SERVER, i % 2 == 0 ? 1000 : 3000, true);
+  }
+  uint32_t average = driver.getAverageLatency(TIMEOUT_SERVER);
+  uint16_t jittery = driver.computeTimeout(TIMEOUT_SERVER, MAX_TIMEOUT);
+  CHECK(average >= 1700 && average <= 2300);
+  CHECK(jittery >= average + 4 * 800 && jittery <= average + 4 * 1200);
+  printf("convergence: OK (stable %u ms, jittery %u ms)\n", stable, jittery);
+}
+
+// Each timeout doubles the next one (up to 16 times), an answer restores it
+void testBackoff(DebugOutput* debug) {
+  FakeModem modem;
+  TimeoutDriver driver(&modem, debug);
+  driver.enableAdaptiveTimeouts(true);
+  for(uint8_t i = 0; i < 40; i++) {
+    driver.recordLatency(TIMEOUT_NETWORK, 2000, true);
+  }
+  uint16_t base = driver.computeTimeout(TIMEOUT_NETWORK, MAX_TIMEOUT);
+
+  driver.recordLatency(TIMEOUT_NETWORK, 0, false);
+  CHECK(driver.computeTimeout(TIMEOUT_NETWORK, MAX_TIMEOUT) == 2 * base);
+  driver.recordLatency(TIMEOUT_NETWORK, 0, false);
+  CHECK(driver.computeTimeout(TIMEOUT_NETWORK, MAX_TIMEOUT) == 4 * base);
+  for(uint8_t i = 0; i < 10; i++) {
+    driver.recordLatency(TIMEOUT_NETWORK, 0, false);
+  }
+  CHECK(driver.computeTimeout(TIMEOUT_NETWORK, MAX_TIMEOUT) == 16 * base);
+
+  driver.recordLatency(TIMEOUT_NETWORK, 2000, true);
+  CHECK(driver.computeTimeout(TIMEOUT_NETWORK, MAX_TIMEOUT) == base);
+  printf("backoff: OK\n");
+}
+
+// The derived timeout stays between 1 second and the maximum of the specifications
+void testClamping(DebugOutput* debug) {
+  FakeModem modem;
+  TimeoutDriver driver(&modem, debug);
+  driver.enableAdaptiveTimeouts(true);
+  for(uint8_t i = 0; i < 40; i++) {
+    driver.recordLatency(TIMEOUT_COMMAND, 20, true);
+    driver.recordLatency(TIMEOUT_SMS, 20000, true);
+  }
+  CHECK(driver.computeTimeout(TIMEOUT_COMMAND, DEFAULT_TIMEOUT) == SIM800L_TIMEOUT_MIN);
+  CHECK(driver.computeTimeout(TIMEOUT_SMS, 25000) >= 20000);
+  for(uint8_t i = 0; i < 4; i++) {
+    driver.recordLatency(TIMEOUT_SMS, 0, false);
+  }
+  CHECK(driver.computeTimeout(TIMEOUT_SMS, 25000) == 25000);
+  printf("clamping: OK\n");
+}
+
+// An override takes precedence over the derived and default timeouts until reset to 0,
+// the classes out of range are ignored
+void testOverride(DebugOutput* debug) {
+  FakeModem modem;
+  TimeoutDriver driver(&modem, debug);
+  driver.setTimeoutOverride(TIMEOUT_SERVER, 30000);
+  CHECK(driver.computeTimeout(TIMEOUT_SERVER, MAX_TIMEOUT) == 30000);
+
+  driver.enableAdaptiveTimeouts(true);
+  for(uint8_t i = 0; i < 40; i++) {
+    driver.recordLatency(TIMEOUT_SERVER, 2000, true);
+  }
+  CHECK(driver.computeTimeout(TIMEOUT_SERVER, MAX_TIMEOUT) == 30000);
+  driver.setTimeoutOverride(TIMEOUT_SERVER, 0);
+  CHECK(driver.computeTimeout(TIMEOUT_SERVER, MAX_TIMEOUT) < 30000);
+
+  driver.setTimeoutOverride(TIMEOUT_NONE, 1234);
+  CHECK(driver.getAverageLatency(TIMEOUT_NONE) == 0);
+  printf("override: OK\n");
+}
+
+// Latency measured on the commands sent to the module: a module which stops answering
+// costs the derived timeout instead of the default one
+void testModule(DebugOutput* debug) {
+  FakeModem modem;
+  bool answering = true;
+  modem.onLine = [&modem, &answering](const std::string& command) -> std::string {
+    (void)command;
+    if(answering) {
+      modem.answer("\r\n+CSQ: 18,0\r\n\r\nOK\r\n", 300);
+    }
+    return "";
+  };
+  SIM800L driver(&modem, RESET_PIN_NOT_USED, 200, 128, debug);
+  driver.enableAdaptiveTimeouts(true);
+  for(uint8_t i = 0; i < 2 * SIM800L_TIMEOUT_MIN_SAMPLES; i++) {
+    CHECK(driver.getSignal() == 18);
+  }
+  uint32_t average = driver.getAverageLatency(TIMEOUT_COMMAND);
+  CHECK(average >= 300 && average < 400);
+
+  answering = false;
+  unsigned long start = fakeNow;
+  CHECK(driver.getSignal() == 0);
+  unsigned long elapsed = fakeNow - start;
+  CHECK(elapsed >= SIM800L_TIMEOUT_MIN && elapsed < DEFAULT_TIMEOUT / 2);
+  printf("module: OK (average %u ms, dead module detected in %lu ms)\n", (unsigned)average, elapsed);
+}
+
+int main() {
+  DebugOutput debug;
+  testDefault(&debug);
+  testConvergence(&debug);
+  testBackoff(&debug);
+  testClamping(&debug);
+  testOverride(&debug);
+  testModule(&debug);
+  printf("ALL OK\n");
+  return 0;
+}
@@ -0,0 +1,169 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+// Worker sharing a module between threads (std::thread build of the worker): the requests
+// are executed by priority, the callbacks and futures are completed, and several producer
+// threads submit requests concurrently. Built with ThreadSanitizer.
+#include "HostTest.h"
+#include "SIM800L.h"
+#include "SIM800LWorker.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#define PRODUCERS 4
+#define REQUESTS_PER_PRODUCER 5
+
+// Completed requests, in the order of execution (only written by the worker thread)
+std::vector<std::string> completions;
+
+uint16_t getSignalCommand(SIM800L* modem, void* context) {
+  (void)context;
+  completions.push_back("signal");
+  return modem->getSignal();
+}
+
+void onCompleted(SIM800L* modem, uint16_t result, void* context) {
+  char line[80];
+  snprintf(line, sizeof(line), "%s:%u:%s", (const char*)context, result, modem->getDataReceived());
+  completions.push_back(line);
+}
+
+// Module answering the status and HTTP commands
+void setupModem(FakeModem* modem) {
+  modem->onLine = [modem](const std::string& command) -> std::string {
+    if(command == "AT+CSQ") {
+      return "\r\n+CSQ: 18,0\r\n\r\nOK\r\n";
+    }
+    if(command.compare(0, 12, "AT+HTTPDATA=") == 0) {
+      modem->rawExpected = atoi(command.c_str() + 12);
+      return "\r\nDOWNLOAD\r\n";
+    }
+    if(command.compare(0, 14, "AT+HTTPACTION=") == 0) {
+      modem->answer("\r\n+HTTPACTION: " + command.substr(14) + ",200,2\r\n", 500);
+      return "\r\nOK\r\n";
+    }
+    if(command == "AT+HTTPREAD") {
+      return "\r\n+HTTPREAD: 2\r\nok\r\nOK\r\n";
+    }
+    return "\r\nOK\r\n";
+  };
+  modem->onRaw = [](const std::string& data) -> std::string {
+    (void)data;
+    return "\r\nOK\r\n";
+  };
+}
+
+void testPriorities(SIM800LWorker* worker) {
+  SIM800LFuture upload, get, signal;
+  CHECK(worker->submitPost("http://host/upload", NULL, "text/plain", "data", 1000, 60000, PRIORITY_LOW, &upload, onCompleted, (void*)"upload"));
+  CHECK(worker->submitGet("http://host/get", NULL, 10000, PRIORITY_NORMAL, &get, onCompleted, (void*)"get"));
+  CHECK(worker->submitCommand(getSignalCommand, NULL, PRIORITY_HIGH, &signal));
+  CHECK(worker->getQueueSize(PRIORITY_LOW) == 1);
+
+  // Nothing is executed before the start of the worker
+  CHECK(!worker->wait(&signal, 50));
+
+  CHECK(worker->begin());
+  CHECK(worker->wait(&upload, 5000) && worker->wait(&get, 5000) && worker->wait(&signal, 5000));
+  CHECK(completions.size() == 3);
+  CHECK(completions[0] == "signal" && completions[1] == "get:200:ok" && completions[2] == "upload:200:ok");
+  CHECK(signal.result == 18 && get.result == 200 && upload.result == 200);
+  printf("priorities: OK\n");
+}
+
+void testProducerThreads(SIM800LWorker* worker) {
+  std::atomic<int> succeeded(0);
+  std::vector<std::thread> producers;
+  for(int t = 0; t < PRODUCERS; t++) {
+    producers.emplace_back([worker, t, &succeeded] {
+      for(int i = 0; i < REQUESTS_PER_PRODUCER; i++) {
+        SIM800LFuture future;
+        while(!worker->submitGet("http://host/get", NULL, 10000, (WorkerPriority)(t % PRIORITY_NONE), &future)) {
+          std::this_thread::yield();
+        }
+        if(worker->wait(&future, 10000) && future.result == 200) {
+          succeeded++;
+        }
+      }
+    });
+  }
+  for(size_t t = 0; t < producers.size(); t++) {
+    producers[t].join();
+  }
+
+  CHECK(succeeded == PRODUCERS * REQUESTS_PER_PRODUCER);
+  printf("producer threads: OK (%d requests)\n", succeeded.load());
+}
+
+// The lanes are observed and a future is waited for by other threads while the future is
+// submitted again after each completion (ThreadSanitizer checks the accesses)
+void testObservers(SIM800LWorker* worker) {
+  SIM800LFuture future;
+  std::atomic<bool> finished(false);
+  std::atomic<int> observed(0);
+  std::thread monitor([worker, &finished, &observed] {
+    while(!finished) {
+      observed += worker->getQueueSize(PRIORITY_NORMAL);
+      std::this_thread::yield();
+    }
+  });
+  std::thread waiter([worker, &future, &finished] {
+    while(!finished) {
+      worker->wait(&future, 1);
+    }
+  });
+
+  for(int i = 0; i < REQUESTS_PER_PRODUCER; i++) {
+    CHECK(worker->submitGet("http://host/get", NULL, 10000, PRIORITY_NORMAL, &future));
+    CHECK(worker->wait(&future, 10000) && future.result == 200);
+  }
+  finished = true;
+  monitor.join();
+  waiter.join();
+  CHECK(worker->getQueueSize(PRIORITY_NORMAL) == 0);
+  printf("observers: OK\n");
+}
+
+int main() {
+  FakeModem modem;
+  DebugOutput debug;
+  setupModem(&modem);
+  SIM800L sim800l(&modem, RESET_PIN_NOT_USED, 200, 128, &debug);
+
+  SIM800LWorker worker(&sim800l);
+  testPriorities(&worker);
+  testProducerThreads(&worker);
+  testObservers(&worker);
+  worker.end();
+
+  printf("ALL OK\n");
+  return 0;
+}
@@ -35,6 +35,7 @@
  */
 const char AT_CMD_BASE[] PROGMEM = "AT";                                      // Basic AT command to check the link
 const char AT_CMD_ECHO[] PROGMEM = "ATE1&W";                                  // Set command echo mode
+const char AT_CMD_CMEE1[] PROGMEM = "AT+CMEE=1";                              // Report the errors of the module with numeric codes
 
 const char AT_CMD_CPIN_TEST[] PROGMEM = "AT+CPIN?";                           // Check SIM card status
 const char AT_CMD_CPIN_PIN[] PROGMEM = "AT+CPIN=";                            // Configure PIN code
@@ -48,18 +49,23 @@ const char AT_CMD_CFUN_TEST[] PROGMEM = "AT+CFUN?";                           //
 const char AT_CMD_CFUN0[] PROGMEM = "AT+CFUN=0";                              // Switch minimum power mode
 const char AT_CMD_CFUN1[] PROGMEM = "AT+CFUN=1";                              // Switch normal power mode
 const char AT_CMD_CFUN4[] PROGMEM = "AT+CFUN=4";                              // Switch sleep power mode
+const char AT_CMD_CSCLK0[] PROGMEM = "AT+CSCLK=0";                            // Disable the slow clock
+const char AT_CMD_CSCLK1[] PROGMEM = "AT+CSCLK=1";                            // Enable the slow clock controlled by DTR
+const char AT_CMD_CSCLK2[] PROGMEM = "AT+CSCLK=2";                            // Enable the slow clock automatically
 
 const char AT_CMD_CREG_TEST[] PROGMEM = "AT+CREG?";                           // Check the network registration status
-const char AT_CMD_SAPBR_GPRS[] PROGMEM = "AT+SAPBR=3,1,\"Contype\",\"GPRS\""; // Configure the GPRS bearer
-const char AT_CMD_SAPBR_APN[] PROGMEM = "AT+SAPBR=3,1,\"APN\",";              // Configure the APN for the GPRS
-const char AT_CMD_SAPBR_USER[] PROGMEM = "AT+SAPBR=3,1,\"USER\",";            // Configure the USER for the GPRS (linked to APN)
-const char AT_CMD_SAPBR_PWD[] PROGMEM = "AT+SAPBR=3,1,\"PWD\",";              // Configure the PWD for the GPRS (linked to APN)
-const char AT_CMD_SAPBR1[] PROGMEM = "AT+SAPBR=1,1";                          // Connect GPRS
-const char AT_CMD_SAPBR2[] PROGMEM = "AT+SAPBR=2,1";                          // Check GPRS connection status
-const char AT_CMD_SAPBR0[] PROGMEM = "AT+SAPBR=0,1";                          // Disconnect GPRS
+const char AT_CMD_BOOT_CONFIG[] PROGMEM = "AT+CMEE=1;+SAPBR=3,%u,\"Contype\",\"GPRS\";+SAPBR=3,%u,\"APN\",\"%s\""; // Configuration of the module and of the bearer at boot
+const char AT_CMD_BOOT_CREDENTIALS[] PROGMEM = ";+SAPBR=3,%u,\"USER\",\"%s\";+SAPBR=3,%u,\"PWD\",\"%s\""; // Credentials of the bearer at boot
+const char AT_CMD_SAPBR_GPRS[] PROGMEM = "AT+SAPBR=3,%u,\"Contype\",\"GPRS\""; // Configure the GPRS bearer
+const char AT_CMD_SAPBR_APN[] PROGMEM = "AT+SAPBR=3,%u,\"APN\",";             // Configure the APN for the GPRS
+const char AT_CMD_SAPBR_USER[] PROGMEM = "AT+SAPBR=3,%u,\"USER\",";           // Configure the USER for the GPRS (linked to APN)
+const char AT_CMD_SAPBR_PWD[] PROGMEM = "AT+SAPBR=3,%u,\"PWD\",";             // Configure the PWD for the GPRS (linked to APN)
+const char AT_CMD_SAPBR1[] PROGMEM = "AT+SAPBR=1,%u";                         // Connect GPRS
+const char AT_CMD_SAPBR2[] PROGMEM = "AT+SAPBR=2,%u";                         // Check GPRS connection status
+const char AT_CMD_SAPBR0[] PROGMEM = "AT+SAPBR=0,%u";                         // Disconnect GPRS
 
 const char AT_CMD_HTTPINIT[] PROGMEM = "AT+HTTPINIT";                         // Init HTTP connection
-const char AT_CMD_HTTPPARA_CID[] PROGMEM = "AT+HTTPPARA=\"CID\",1";           // Connect HTTP through GPRS bearer
+const char AT_CMD_HTTPPARA_CID[] PROGMEM = "AT+HTTPPARA=\"CID\",%u";          // Connect HTTP through GPRS bearer
 const char AT_CMD_HTTPPARA_URL[] PROGMEM = "AT+HTTPPARA=\"URL\",";            // Define the URL to connect in HTTP
 const char AT_CMD_HTTPPARA_USERDATA[] PROGMEM = "AT+HTTPPARA=\"USERDATA\",";  // Define the header(s)
 const char AT_CMD_HTTPPARA_CONTENT[] PROGMEM = "AT+HTTPPARA=\"CONTENT\",";    // Define the content type for the HTTP POST
@@ -69,18 +75,93 @@ const char AT_CMD_HTTPSSL_N[] PROGMEM = "AT+HTTPSSL=0";                       //
 const char AT_CMD_HTTPACTION0[] PROGMEM = "AT+HTTPACTION=0";                  // Launch HTTP GET action
 const char AT_CMD_HTTPACTION1[] PROGMEM = "AT+HTTPACTION=1";                  // Launch HTTP POST action
 const char AT_CMD_HTTPREAD[] PROGMEM = "AT+HTTPREAD";                         // Start reading HTTP return data
+const char AT_CMD_HTTPHEAD[] PROGMEM = "AT+HTTPHEAD";                         // Read the HTTP header of the answer
 const char AT_CMD_HTTPTERM[] PROGMEM = "AT+HTTPTERM";                         // Terminate HTTP connection
 
+const char AT_CMD_FTPCID[] PROGMEM = "AT+FTPCID=%u";                          // Connect FTP through GPRS bearer
+const char AT_CMD_FTPSERV[] PROGMEM = "AT+FTPSERV=";                          // Define the FTP server
+const char AT_CMD_FTPUN[] PROGMEM = "AT+FTPUN=";                              // Define the FTP user name
+const char AT_CMD_FTPPW[] PROGMEM = "AT+FTPPW=";                              // Define the FTP password
+const char AT_CMD_FTPTYPE_I[] PROGMEM = "AT+FTPTYPE=\"I\"";                   // Use binary FTP sessions
+const char AT_CMD_FTPMODE_PASSIVE[] PROGMEM = "AT+FTPMODE=1";                 // Use passive FTP mode
+const char AT_CMD_FTPGETNAME[] PROGMEM = "AT+FTPGETNAME=";                    // Define the name of the file to download
+const char AT_CMD_FTPGETPATH[] PROGMEM = "AT+FTPGETPATH=";                    // Define the path of the file to download
+const char AT_CMD_FTPPUTNAME[] PROGMEM = "AT+FTPPUTNAME=";                    // Define the name of the file to upload
+const char AT_CMD_FTPPUTPATH[] PROGMEM = "AT+FTPPUTPATH=";                    // Define the path of the file to upload
+const char AT_CMD_FTPPUTOPT_STOR[] PROGMEM = "AT+FTPPUTOPT=\"STOR\"";         // Replace the file on upload
+const char AT_CMD_FTPPUTOPT_APPE[] PROGMEM = "AT+FTPPUTOPT=\"APPE\"";         // Append to the file on upload
+const char AT_CMD_FTPGET1[] PROGMEM = "AT+FTPGET=1";                          // Open FTP download session
+const char AT_CMD_FTPPUT1[] PROGMEM = "AT+FTPPUT=1";                          // Open FTP upload session
+const char AT_CMD_FTPPUT20[] PROGMEM = "AT+FTPPUT=2,0";                       // End of FTP upload data
+const char AT_CMD_FTPQUIT[] PROGMEM = "AT+FTPQUIT";                           // Quit FTP session
+
+const char AT_CMD_FSCREATE[] PROGMEM = "AT+FSCREATE=C:\\User\\%s";            // Create a file on the flash of the module
+const char AT_CMD_FSWRITE[] PROGMEM = "AT+FSWRITE=C:\\User\\%s,1,%u,%u";      // Append data to a file of the module
+const char AT_CMD_FSFLSIZE[] PROGMEM = "AT+FSFLSIZE=C:\\User\\%s";            // Get the size of a file of the module
+const char AT_CMD_FSDEL[] PROGMEM = "AT+FSDEL=C:\\User\\%s";                  // Delete a file of the module
+const char AT_CMD_FTPPUTFRMFS[] PROGMEM = "AT+FTPPUTFRMFS=\"C:\\User\\%s\"";  // Upload a file of the module
+
+const char AT_CMD_CMGF0[] PROGMEM = "AT+CMGF=0";                              // Use PDU mode for SMS
+const char AT_CMD_CNMI[] PROGMEM = "AT+CNMI=2,1,0,0,0";                       // Notify the new SMS stored (+CMTI)
+const char AT_CMD_CMGL4[] PROGMEM = "AT+CMGL=4";                              // List all SMS stored
+const char AT_CMD_CMGD_READ[] PROGMEM = "AT+CMGD=1,1";                        // Delete all the SMS read
+const char AT_CMD_CMGD_ALL[] PROGMEM = "AT+CMGD=1,4";                         // Delete all SMS
+const char AT_CMD_CPMS_TEST[] PROGMEM = "AT+CPMS?";                           // Check the storage of the SMS
+
 const char AT_RSP_OK[] PROGMEM = "OK";                                        // Expected answer OK
+const char AT_RSP_ERROR[] PROGMEM = "ERROR";                                  // Answer ERROR
+const char AT_RSP_RDY[] PROGMEM = "RDY";                                      // Power on completed (fixed baud rate only)
+const char AT_RSP_CALL_READY[] PROGMEM = "Call Ready";                        // Phonebook initialized
+const char AT_RSP_SMS_READY[] PROGMEM = "SMS Ready";                          // SMS initialized
+const char AT_RSP_CPIN_NOT_INSERTED[] PROGMEM = "+CPIN: NOT INSERTED";        // SIM card missing
+const char AT_RSP_CPIN_SIM_PIN[] PROGMEM = "+CPIN: SIM PIN";                  // SIM card locked by a PIN code
 const char AT_RSP_DOWNLOAD[] PROGMEM = "DOWNLOAD";                            // Expected answer DOWNLOAD
 const char AT_RSP_HTTPREAD[] PROGMEM = "+HTTPREAD: ";                         // Expected answer HTTPREAD
-const char AT_RSP_SAPBR[] PROGMEM = "+SAPBR: 1,1";                            // Expected answer SAPBR: 1,1
+const char AT_RSP_HTTPHEAD[] PROGMEM = "+HTTPHEAD: ";                         // Expected answer HTTPHEAD
+const char AT_RSP_SAPBR[] PROGMEM = "+SAPBR: %u,1";                           // Expected answer SAPBR: <cid>,1
+const char AT_RSP_FTPGET[] PROGMEM = "+FTPGET:";                              // Expected answer FTPGET
+const char AT_RSP_FTPPUT[] PROGMEM = "+FTPPUT:";                              // Expected answer FTPPUT
+const char AT_RSP_FTPPUTFRMFS[] PROGMEM = "+FTPPUTFRMFS: ";                   // Expected answer FTPPUTFRMFS
+const char AT_RSP_FSFLSIZE[] PROGMEM = "+FSFLSIZE: ";                         // Expected answer FSFLSIZE
+const char AT_RSP_CMGS[] PROGMEM = "+CMGS:";                                  // Expected answer CMGS
+const char AT_RSP_CPMS[] PROGMEM = "+CPMS: ";                                 // Expected answer CPMS
+const char AT_RSP_CME_ERROR[] PROGMEM = "+CME ERROR: ";                       // Extended error of the module
+
+// Parameters of the current call located in PROGMEM
+#define FLASH_URL 0x01
+#define FLASH_HEADERS 0x02
+#define FLASH_CONTENT_TYPE 0x04
+#define FLASH_PAYLOAD 0x08
+#define FLASH_APN 0x10
+#define FLASH_CREDENTIALS 0x20
+#define FLASH_PIN 0x40
+
+// Events seen during the boot of the module
+#define BOOT_RESPONSIVE 0x01
+#define BOOT_RDY 0x02
+#define BOOT_CALL_READY 0x04
+#define BOOT_SMS_READY 0x08
+#define BOOT_SIM_ERROR 0x10
+
+// Binary payload located in RAM
+class SIM800LBinaryPayload : public SIM800LPayload {
+  public:
+    SIM800LBinaryPayload(const char* _contentType, const uint8_t* _data, uint16_t _length) : contentType(_contentType), data(_data), length(_length) {}
+    const char* getContentType() { return contentType; }
+    uint16_t getLength() { return length; }
+    void writeTo(Print* output) { output->write(data, length); }
+
+  private:
+    const char* contentType;
+    const uint8_t* data;
+    uint16_t length;
+};
 
 /**
  * Constructor; Init the driver, communication with the module and shared
  * buffer used by the driver (to avoid multiples allocation)
  */
-SIM800L::SIM800L(Stream* _stream, uint8_t _pinRst, uint16_t _internalBufferSize, uint16_t _recvBufferSize, Stream* _debugStream) {
+SIM800L::SIM800L(Stream* _stream, int8_t _pinRst, uint16_t _internalBufferSize, uint16_t _recvBufferSize, Stream* _debugStream) {
   // Store local variables
   stream = _stream;
   enableDebug = _debugStream != NULL;
@@ -109,6 +190,18 @@ SIM800L::SIM800L(Stream* _stream, uint8_t _pinRst, uint16_t _internalBufferSize,
   }
   recvBufferSize = _recvBufferSize;
   recvBuffer = (char *) malloc(recvBufferSize);
+
+  // Start the energy accounting
+  lastPowerStateChange = millis();
+}
+
+/**
+ * Constructor with a ring buffer between the serial link and the driver; the answers
+ * of the module are parsed by contiguous spans of the buffer
+ */
+SIM800L::SIM800L(SIM800LRing* _ring, int8_t _pinRst, uint16_t _internalBufferSize, uint16_t _recvBufferSize, Stream* _debugStream)
+  : SIM800L((Stream*)_ring, _pinRst, _internalBufferSize, _recvBufferSize, _debugStream) {
+  ring = _ring;
 }
 
 /**
@@ -117,6 +210,8 @@ SIM800L::SIM800L(Stream* _stream, uint8_t _pinRst, uint16_t _internalBufferSize,
 SIM800L::~SIM800L() {
   free(internalBuffer);
   free(recvBuffer);
+  free(cacheValidators);
+  free(smsDelivered);
 }
 
 /**
@@ -130,47 +225,115 @@ uint16_t SIM800L::doPost(const char* url, const char* contentType, const char* p
  * Do HTTP/S POST to a specific URL with headers
  */
 uint16_t SIM800L::doPost(const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs) {
-  // Initiate HTTP/S session with the module
-  uint16_t initRC = initiateHTTP(url, headers);
-  if(initRC > 0) {
-    return initRC;
+  return doHTTP(true, url, headers, contentType, payload, clientWriteTimeoutMs, serverReadTimeoutMs);
+}
+
+/**
+ * Do HTTP/S POST of a binary payload (CBOR, protobuf...) to a specific URL with headers
+ */
+uint16_t SIM800L::doPost(const char* url, const char* headers, const char* contentType, const uint8_t* payload, uint16_t length, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs) {
+  SIM800LBinaryPayload binary(contentType, payload, length);
+  return doPost(url, headers, &binary, clientWriteTimeoutMs, serverReadTimeoutMs);
+}
+
+/**
+ * Do HTTP/S POST to a specific URL with headers, the payload is written straight to the module
+ */
+uint16_t SIM800L::doPost(const char* url, const char* headers, SIM800LPayload* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs) {
+  payloadWriter = payload;
+  uint16_t rc = doHTTP(true, url, headers, payload->getContentType(), NULL, clientWriteTimeoutMs, serverReadTimeoutMs);
+  payloadWriter = NULL;
+  return rc;
+}
+
+/**
+ * Start HTTP/S POST to a specific URL with headers without waiting for the answer of the server
+ * Returns 0 if the action is started, the error code elsewhere
+ */
+uint16_t SIM800L::startPost(const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs) {
+  // Initiate HTTP/S session with the module, send the payload and start HTTP POST action
+  uint16_t rc = initiateHTTP(url, headers);
+  if(rc == 0) {
+    rc = writeHTTPPayload(contentType, payload, clientWriteTimeoutMs);
+  }
+  if(rc == 0) {
+    rc = startHTTPAction(true);
+  }
+
+  // Close the session to be able to start the next one
+  if(rc > 0) {
+    terminateHTTP();
   }
+  return rc;
+}
 
+/**
+ * Define the content type and write the payload of the HTTP POST on the module
+ * Returns 0 if OK, the error code elsewhere
+ */
+uint16_t SIM800L::writeHTTPPayload(const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs) {
   // Define the content type
-  sendCommand_P(AT_CMD_HTTPPARA_CONTENT, contentType);
+  sendCommand_P(AT_CMD_HTTPPARA_CONTENT, contentType, flashParameters & FLASH_CONTENT_TYPE);
   if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-    if(enableDebug) debugStream->println(F("SIM800L : doPost() - Unable to define the content type"));
+    if(enableDebug) debugStream->println(F("SIM800L : writeHTTPPayload() - Unable to define the content type"));
     return 702;
   }
 
   // Prepare to send the payload
-  sprintf(internalBuffer, "AT+HTTPDATA=%d,%d", strlen(payload), clientWriteTimeoutMs);
+  uint16_t payloadLength;
+  if(payloadWriter != NULL) {
+    payloadLength = payloadWriter->getLength();
+  } else {
+    payloadLength = flashParameters & FLASH_PAYLOAD ? strlen_P(payload) : strlen(payload);
+  }
+  sprintf_P(internalBuffer, PSTR("AT+HTTPDATA=%u,%u"), payloadLength, clientWriteTimeoutMs);
   sendCommand(internalBuffer);
   if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_DOWNLOAD)) {
-    if(enableDebug) debugStream->println(F("SIM800L : doPost() - Unable to send payload to module"));
+    if(enableDebug) debugStream->println(F("SIM800L : writeHTTPPayload() - Unable to send payload to module"));
     return 707;
   }
 
   // Write the payload on the module
   if(enableDebug) {
-    debugStream->print(F("SIM800L : doPost() - Payload to send : "));
-    debugStream->println(payload);
+    debugStream->print(F("SIM800L : writeHTTPPayload() - Payload to send : "));
+    if(payloadWriter != NULL) {
+      debugStream->print(payloadLength);
+      debugStream->print(F(" bytes of "));
+      debugStream->print(payloadWriter->getContentType());
+    } else {
+      printString(payload, flashParameters & FLASH_PAYLOAD);
+    }
+    debugStream->println();
   }
 
   purgeSerial();
-  stream->write(payload);
+  if(payloadWriter != NULL) {
+    payloadWriter->writeTo(stream);
+  } else {
+    writeString(payload, flashParameters & FLASH_PAYLOAD);
+  }
   stream->flush();
+  dataTransferred += payloadLength;
   delay(500);
 
-  // Start HTTP POST action
-  sendCommand_P(AT_CMD_HTTPACTION1);
-  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-    if(enableDebug) debugStream->println(F("SIM800L : doPost() - Unable to initiate POST action"));
-    return 703;
-  }
+  return 0;
+}
 
-  // Read data, manage buffers and close HTTP connection
-  return readHTTP(serverReadTimeoutMs);
+/**
+ * Do HTTP/S POST with the URL, the content type and the payload in PROGMEM (F() macro)
+ */
+uint16_t SIM800L::doPost(const __FlashStringHelper* url, const __FlashStringHelper* contentType, const __FlashStringHelper* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs) {
+  return doPost(url, NULL, contentType, payload, clientWriteTimeoutMs, serverReadTimeoutMs);
+}
+
+/**
+ * Do HTTP/S POST with the URL, the headers, the content type and the payload in PROGMEM (F() macro)
+ */
+uint16_t SIM800L::doPost(const __FlashStringHelper* url, const __FlashStringHelper* headers, const __FlashStringHelper* contentType, const __FlashStringHelper* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs) {
+  flashParameters = FLASH_URL | FLASH_HEADERS | FLASH_CONTENT_TYPE | FLASH_PAYLOAD;
+  uint16_t rc = doPost((const char*)url, (const char*)headers, (const char*)contentType, (const char*)payload, clientWriteTimeoutMs, serverReadTimeoutMs);
+  flashParameters = 0;
+  return rc;
 }
 
 /**
@@ -184,613 +347,3043 @@ uint16_t SIM800L::doGet(const char* url, uint16_t serverReadTimeoutMs) {
  * Do HTTP/S GET on a specific URL with headers
  */
 uint16_t SIM800L::doGet(const char* url, const char* headers, uint16_t serverReadTimeoutMs) {
-  // Initiate HTTP/S session
-  uint16_t initRC = initiateHTTP(url, headers);
-  if(initRC > 0) {
-    return initRC;
-  }
+  return doHTTP(false, url, headers, NULL, NULL, 0, serverReadTimeoutMs);
+}
 
-  // Start HTTP GET action
-  sendCommand_P(AT_CMD_HTTPACTION0);
-  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-    if(enableDebug) debugStream->println(F("SIM800L : doGet() - Unable to initiate GET action"));
-    return 703;
-  }
+/**
+ * Do HTTP/S GET with the URL in PROGMEM (F() macro)
+ */
+uint16_t SIM800L::doGet(const __FlashStringHelper* url, uint16_t serverReadTimeoutMs) {
+  return doGet(url, NULL, serverReadTimeoutMs);
+}
 
-  // Read data, manage buffers and close HTTP connection
-  return readHTTP(serverReadTimeoutMs);
+/**
+ * Do HTTP/S GET with the URL and the headers in PROGMEM (F() macro)
+ */
+uint16_t SIM800L::doGet(const __FlashStringHelper* url, const __FlashStringHelper* headers, uint16_t serverReadTimeoutMs) {
+  flashParameters = FLASH_URL | FLASH_HEADERS;
+  uint16_t rc = doGet((const char*)url, (const char*)headers, serverReadTimeoutMs);
+  flashParameters = 0;
+  return rc;
 }
 
 /**
- * Meta method to read the HTTP/S results on the module
+ * Start HTTP/S GET on a specific URL with headers without waiting for the answer of the server
+ * Returns 0 if the action is started, the error code elsewhere
  */
-uint16_t SIM800L::readHTTP(uint16_t serverReadTimeoutMs) {
-  // Cleanup the receive buffer
-  initRecvBuffer();
-  dataSize = 0;
-  
-  // Wait answer from the server
-  if(!readResponse(serverReadTimeoutMs)) {
-    if(enableDebug) debugStream->println(F("SIM800L : readHTTP() - Server timeout"));
-    return 408;
+uint16_t SIM800L::startGet(const char* url, const char* headers) {
+  // Initiate HTTP/S session and start HTTP GET action
+  uint16_t rc = initiateHTTP(url, headers);
+  if(rc == 0) {
+    rc = startHTTPAction(false);
   }
 
-  // Extract status information
-  int16_t idxBase = strIndex(internalBuffer, "+HTTPACTION: ");
-  if(idxBase < 0) {
-    if(enableDebug) debugStream->println(F("SIM800L : readHTTP() - Invalid answer on HTTP read"));
-    return 703;
+  // Close the session to be able to start the next one
+  if(rc > 0) {
+    terminateHTTP();
   }
+  return rc;
+}
 
-  // Get the HTTP return code
-  uint16_t httpRC = 0;
-  httpRC += (internalBuffer[idxBase + 15] - '0') * 100;
-  httpRC += (internalBuffer[idxBase + 16] - '0') * 10;
-  httpRC += (internalBuffer[idxBase + 17] - '0') * 1;
-
-  if(enableDebug) {
-    debugStream->print(F("SIM800L : readHTTP() - HTTP status "));
-    debugStream->println(httpRC);
+/**
+ * Start the HTTP action (GET or POST) on the session initiated
+ * Returns 0 if OK, the error code elsewhere
+ */
+uint16_t SIM800L::startHTTPAction(bool post) {
+  httpAnswerReceived = false;
+  sendCommand_P(post ? AT_CMD_HTTPACTION1 : AT_CMD_HTTPACTION0);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : startHTTPAction() - Unable to initiate HTTP action"));
+    return 703;
   }
 
-  if(httpRC == 200) {
-    // Get the size of the data to receive
-    dataSize = 0;
-    for(uint16_t i = 0; (internalBuffer[idxBase + 19 + i] - '0') >= 0 && (internalBuffer[idxBase + 19 + i] - '0') <= 9; i++) {
-      if(i != 0) {
-        dataSize = dataSize * 10;
-      }
-      dataSize += (internalBuffer[idxBase + 19 + i] - '0');
-    }
+  // The answer of the server is measured from now
+  armTimeout(TIMEOUT_SERVER);
 
-    if(enableDebug) {
-      debugStream->print(F("SIM800L : readHTTP() - Data size received of "));
-      debugStream->print(dataSize);
-      debugStream->println(F(" bytes"));
-    }
+  return 0;
+}
 
-    // Ask for reading and detect the start of the reading...
-    sendCommand_P(AT_CMD_HTTPREAD);
-    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_HTTPREAD, 2)) {
-      return 705;
-    }
+/**
+ * Check if the module has sent something since the last command
+ * (typically the answer of the server after startGet() or startPost())
+ */
+bool SIM800L::isAnswerAvailable() {
+  return stream->available() > 0;
+}
 
-    // Read the data and purge the serial if buffer is too small
-    if(dataSize < recvBufferSize - 1) {
-      stream->readBytes(recvBuffer, dataSize);
-    } else {
-      uint16_t toRead = dataSize;
-      size_t bytesRead = stream->readBytes(recvBuffer, recvBufferSize - 1);
-      toRead -= bytesRead;
-      while(toRead > 0) {
-        stream->read();
-        toRead -= 1;
-      }  
-    }
+/**
+ * Check if the answer of the server has been received after startGet() or startPost()
+ * (non blocking), the other messages of the module (+CMTI, RING...) are skipped
+ * The answer is kept for finishHTTP() which must be the next call
+ */
+bool SIM800L::isHTTPAnswerAvailable() {
+  if(!httpAnswerReceived) {
+    httpAnswerReceived = readHTTPAnswer(DEFAULT_TIMEOUT, false);
+  }
+  return httpAnswerReceived;
+}
 
-    if(recvBufferSize < dataSize) {
-      dataSize = recvBufferSize;
-      if(enableDebug) {
-        debugStream->println(F("SIM800L : readHTTP() - Buffer overflow while loading data from HTTP. Keep only first bytes..."));
-      }
-    }
+/**
+ * Wait for the answer of the server after startGet() or startPost(),
+ * read the data and close the HTTP connection
+ */
+uint16_t SIM800L::finishHTTP(uint16_t serverReadTimeoutMs) {
+  return readHTTP(serverReadTimeoutMs);
+}
 
-    // We are expecting a final OK
-    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-      if(enableDebug) debugStream->println(F("SIM800L : readHTTP() - Invalid end of data while reading HTTP result from the module"));
-      return 705;
-    }
+/**
+ * Do HTTP/S GET on a specific URL and stream the data to a sink by windows
+ * The download restarts from the last offset committed in the download state
+ * (via the BREAK parameter of the module) and keeps the CRC32 of the data up to date
+ */
+uint16_t SIM800L::doDownload(const char* url, SIM800LSink* sink, SIM800LDownload* download, uint16_t windowSize, uint16_t serverReadTimeoutMs) {
+  // The window is read in the reception buffer
+  if(windowSize == 0 || windowSize > recvBufferSize) {
+    windowSize = recvBufferSize;
+  }
 
-    if(enableDebug) {
-      debugStream->print(F("SIM800L : readHTTP() - Received from HTTP call : "));
-      debugStream->println(recvBuffer);
-    }
+  // Initiate HTTP/S session and download the windows
+  uint16_t httpRC = 0;
+  uint16_t rc = initiateHTTP(url, NULL);
+  if(rc == 0) {
+    rc = readDownload(sink, download, windowSize, serverReadTimeoutMs, &httpRC);
   }
 
-  // Close HTTP connection
-  sendCommand_P(AT_CMD_HTTPTERM);
-  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-    if(enableDebug) debugStream->println(F("SIM800L : readHTTP() - Unable to close HTTP session"));
-    return 706;
+  // Close HTTP connection (also on error, to be able to resume with a new session)
+  uint16_t termRC = terminateHTTP();
+  if(rc > 0) {
+    return rc;
+  }
+  if(termRC > 0) {
+    return termRC;
   }
 
   return httpRC;
 }
 
 /**
- * Meta method to initiate the HTTP/S session on the module
+ * Start the GET action of the download and commit the windows of the answer to the sink
+ * Returns 0 if OK (HTTP status in httpRC), the error code elsewhere
  */
-uint16_t SIM800L::initiateHTTP(const char* url, const char* headers) {
-  // Init HTTP connection
-  sendCommand_P(AT_CMD_HTTPINIT);
-  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-    if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to init HTTP"));
-    return 701;
+uint16_t SIM800L::readDownload(SIM800LSink* sink, SIM800LDownload* download, uint16_t windowSize, uint16_t serverReadTimeoutMs, uint16_t* httpRC) {
+  // Ask the server to resume after the last committed byte
+  if(download->offset > 0) {
+    sprintf_P(internalBuffer, PSTR("AT+HTTPPARA=\"BREAK\",%lu"), (unsigned long)download->offset);
+    sendCommand(internalBuffer);
+    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+      if(enableDebug) debugStream->println(F("SIM800L : readDownload() - Unable to define the resume offset"));
+      return 702;
+    }
   }
 
-  // Use the GPRS bearer
-  sendCommand_P(AT_CMD_HTTPPARA_CID);
+  // Start HTTP GET action
+  sendCommand_P(AT_CMD_HTTPACTION0);
   if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-    if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to define bearer"));
-    return 702;
+    if(enableDebug) debugStream->println(F("SIM800L : readDownload() - Unable to initiate GET action"));
+    return 703;
   }
 
-  // Define URL to look for
-  sendCommand_P(AT_CMD_HTTPPARA_URL, url);
-  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-    if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to define the URL"));
-    return 702;
-  }
+  // The answer of the server is measured from now
+  armTimeout(TIMEOUT_SERVER);
 
-  // Set Headers
-  if (headers != NULL) {
-    sendCommand_P(AT_CMD_HTTPPARA_USERDATA, headers);
-    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-      if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to define Headers"));
-      return 702;
-    }
+  // Wait answer from the server
+  lastTransferSize = 0;
+  lastTransferDuration = 0;
+  uint32_t timerStart = millis();
+  uint32_t length = 0;
+  uint16_t actionRC = readHTTPAction(serverReadTimeoutMs, httpRC, &length);
+  if(actionRC > 0) {
+    return actionRC;
   }
 
-  // Enable HTTP redirection if HTTP RC 302
-  sendCommand_P(AT_CMD_HTTPPARA_REDIR);
-  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-    if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to enable HTTP redirection"));
-    return 702;
+  // Position in the data held by the module of the next byte to commit:
+  // 206 means the server honored the resume offset, 200 means it sent the whole resource again
+  uint32_t readPos = 0;
+  if(*httpRC == 206) {
+    download->totalSize = download->offset + length;
+  } else if(*httpRC == 200) {
+    download->totalSize = length;
+    readPos = download->offset;
   }
 
-  // Check if the firmware support HTTPSSL command
-  bool isSupportSSL = false;
-  char* version = getVersion();
-  int16_t rIdx = strIndex(version, "R");
-  if(rIdx > 0) {
-    uint8_t releaseInt = (version[rIdx + 1] - '0') * 10 + (version[rIdx + 2] - '0');
+  if(*httpRC == 200 || *httpRC == 206) {
+    while(readPos < length) {
+      uint16_t toRead = windowSize;
+      if(length - readPos < toRead) {
+        toRead = length - readPos;
+      }
 
-    // The release should be greater or equals to 14 to support SSL stack
-    if(releaseInt >= 14) {
-      isSupportSSL = true;
-      if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Support of SSL enabled"));
-    } else {
-      isSupportSSL = false;
-      if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Support of SSL disabled (SIM800L firware below R14)"));
-    }
-  }
+      // Ask for the window and detect the start of the reading
+      sprintf_P(internalBuffer, PSTR("AT+HTTPREAD=%lu,%u"), (unsigned long)readPos, toRead);
+      sendCommand(internalBuffer);
+      if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_HTTPREAD, 2)) {
+        if(enableDebug) debugStream->println(F("SIM800L : readDownload() - Unable to read the window"));
+        return 705;
+      }
 
-  // Send HTTPSSL command only if the version is greater or equals to 14
-  if(isSupportSSL) {
-    // HTTP or HTTPS
-    if(strIndex(url, "https://") == 0) {
-      sendCommand_P(AT_CMD_HTTPSSL_Y);
-      if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-        if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to switch to HTTPS"));
-        return 702;
+      // The module could provide less data than requested
+      int16_t idx = strIndex(internalBuffer, "+HTTPREAD: ");
+      uint16_t windowLength = idx < 0 ? 0 : strtoul(internalBuffer + idx + 11, NULL, 10);
+      if(windowLength == 0 || windowLength > toRead || readData(recvBuffer, windowLength) != windowLength) {
+        if(enableDebug) debugStream->println(F("SIM800L : readDownload() - Invalid window received"));
+        return 705;
       }
-    } else {
-      sendCommand_P(AT_CMD_HTTPSSL_N);
+
+      // Commit the window to the sink
+      if(!sink->write(download->offset, (uint8_t*)recvBuffer, windowLength)) {
+        if(enableDebug) debugStream->println(F("SIM800L : readDownload() - Unable to write on the sink"));
+        return 708;
+      }
+      download->crc32 = updateCRC32(download->crc32, (uint8_t*)recvBuffer, windowLength);
+      download->offset += windowLength;
+      readPos += windowLength;
+      lastTransferSize += windowLength;
+      dataTransferred += windowLength;
+
+      // We are expecting a final OK
       if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
-        if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to switch to HTTP"));
-        return 702;
+        if(enableDebug) debugStream->println(F("SIM800L : readDownload() - Invalid end of window"));
+        return 705;
       }
     }
+
+    lastTransferDuration = millis() - timerStart;
+
+    if(enableDebug) {
+      debugStream->print(F("SIM800L : readDownload() - "));
+      debugStream->print(download->offset);
+      debugStream->print(F("/"));
+      debugStream->print(download->totalSize);
+      debugStream->println(F(" bytes committed"));
+    }
   }
 
   return 0;
 }
 
 /**
- * Force a reset of the module
+ * Wait for the result of the HTTP action and extract the HTTP status and the
+ * size of the data available on the module
+ * Returns 0 if OK, the error code elsewhere
  */
-void SIM800L::reset() {
-  if(pinReset != RESET_PIN_NOT_USED)
-  {
-    // Some logging
-    if(enableDebug) debugStream->println(F("SIM800L : Reset"));
-
-    // Reset the device
-    digitalWrite(pinReset, HIGH);
-    delay(500);
-    digitalWrite(pinReset, LOW);
-    delay(500);
-    digitalWrite(pinReset, HIGH);
-    delay(1000);
-  } else {
-    // Some logging
-    if(enableDebug) debugStream->println(F("SIM800L : Reset requested but reset pin undefined"));
-    if(enableDebug) debugStream->println(F("SIM800L : No reset"));
+uint16_t SIM800L::readHTTPAction(uint16_t serverReadTimeoutMs, uint16_t* httpRC, uint32_t* length) {
+  // Wait answer from the server (unless already received by isHTTPAnswerAvailable())
+  if(!httpAnswerReceived && !readHTTPAnswer(serverReadTimeoutMs, true)) {
+    if(enableDebug) debugStream->println(F("SIM800L : readHTTPAction() - Server timeout"));
+    return 408;
   }
+  httpAnswerReceived = false;
 
-  // Purge the serial
-  stream->flush();
-  while (stream->available()) {
-    stream->read();
+  // Extract status information (+HTTPACTION: <method>,<status>,<length>)
+  int16_t idxBase = strIndex(internalBuffer, "+HTTPACTION: ");
+  if(idxBase < 0) {
+    if(enableDebug) debugStream->println(F("SIM800L : readHTTPAction() - Invalid answer on HTTP action"));
+    return 703;
   }
-}
 
-/**
- * Return the size of data received after the last successful HTTP connection
- */
-uint16_t SIM800L::getDataSizeReceived() {
-  return dataSize;
-}
+  char* next = strchr(internalBuffer + idxBase, ',');
+  if(next == NULL) {
+    return 703;
+  }
+  *httpRC = strtoul(next + 1, &next, 10);
+  *length = 0;
+  if(*next == ',') {
+    *length = strtoul(next + 1, NULL, 10);
+  }
 
-/**
- * Return the buffer of data received after the last successful HTTP connection
- */
-char* SIM800L::getDataReceived() {
-  return recvBuffer;
-}
+  if(enableDebug) {
+    debugStream->print(F("SIM800L : readHTTPAction() - HTTP status "));
+    debugStream->print(*httpRC);
+    debugStream->print(F(", "));
+    debugStream->print(*length);
+    debugStream->println(F(" bytes available"));
+  }
 
-/**
- * Status function: Check if AT command works
- */
-bool SIM800L::isReady() {
-  sendCommand_P(AT_CMD_BASE);
-  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
+  return 0;
 }
 
 /**
- * Config function: Enable commande echo mode
+ * Read the messages of the module until the answer of the server (+HTTPACTION), the
+ * unsolicited messages received meanwhile are skipped. Without wait, only the messages
+ * already arriving are read. The latency of the server is measured on its answer only
+ * Returns true if the answer is in the internal buffer
  */
-bool SIM800L::enableEchoMode() {
-  sendCommand_P(AT_CMD_ECHO);
-  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
-}
+bool SIM800L::readHTTPAnswer(uint16_t timeout, bool wait) {
+  TimeoutClass timeoutClass = armedTimeoutClass;
+  armedTimeoutClass = TIMEOUT_NONE;
+  if(timeoutClass != TIMEOUT_NONE && wait) {
+    timeout = computeTimeout(timeoutClass, timeout);
+  }
 
-/**
- * Status function: Check the power mode
- */
-PowerMode SIM800L::getPowerMode() {
-  sendCommand_P(AT_CMD_CFUN_TEST);
-  if(readResponse(DEFAULT_TIMEOUT)) {
-    // Check if there is an error
-    int16_t errIdx = strIndex(internalBuffer, "ERROR");
-    if(errIdx > 0) {
-      return POW_ERROR;
+  uint32_t timerStart = millis();
+  bool received = false;
+  while(!received) {
+    uint32_t elapsed = millis() - timerStart;
+    if((!wait && !isAnswerAvailable()) || elapsed >= timeout || !readResponse(timeout - elapsed)) {
+      break;
     }
+    received = strIndex(internalBuffer, "+HTTPACTION: ") >= 0;
+    if(!received && enableDebug) debugStream->println(F("SIM800L : readHTTPAnswer() - Unsolicited message skipped"));
+  }
 
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "+CFUN: ");
-    char value = internalBuffer[idx + 7];
-
-    // Prepare the clear output
-    switch(value) {
-      case '0' : return MINIMUM;
-      case '1' : return NORMAL;
-      case '4' : return SLEEP;
-      default  : return POW_UNKNOWN;
+  if(received) {
+    if(timeoutClass != TIMEOUT_NONE) {
+      recordLatency(timeoutClass, millis() - armedTimeoutStart, true);
     }
+  } else if(wait) {
+    if(timeoutClass != TIMEOUT_NONE) {
+      recordLatency(timeoutClass, 0, false);
+    }
+  } else {
+    // Still waiting for the server
+    armedTimeoutClass = timeoutClass;
   }
-  return POW_ERROR;
+  return received;
 }
 
 /**
- * Status function: Get version of the module
+ * Meta method to read the HTTP/S results on the module
+ */
+uint16_t SIM800L::readHTTP(uint16_t serverReadTimeoutMs) {
+  // Cleanup the receive buffer
+  initRecvBuffer();
+  dataSize = 0;
+  
+  // Wait answer from the server
+  uint16_t httpRC = 0;
+  uint32_t length = 0;
+  uint16_t rc = readHTTPAction(serverReadTimeoutMs, &httpRC, &length);
+
+  // Read the data (in case of error of the sink, the session is closed anyway)
+  if(rc == 0 && httpRC == 200) {
+    uint32_t offset = 0;
+    rc = readHTTPBody(length, &offset);
+  }
+
+  // Close HTTP connection (also on error, to be able to start the next session)
+  uint16_t termRC = terminateHTTP();
+  if(rc > 0) {
+    return rc;
+  }
+  if(termRC > 0) {
+    return termRC;
+  }
+
+  return httpRC;
+}
+
+/**
+ * Read the body of the HTTP answer (length bytes available on the module) to the
+ * reception buffer or to the response sink, from the offset already written to the sink
+ * Returns 0 if OK, the error code elsewhere
+ */
+uint16_t SIM800L::readHTTPBody(uint32_t length, uint32_t* offset) {
+  // Cleanup the receive buffer
+  initRecvBuffer();
+  dataSize = 0;
+
+  if(enableDebug) {
+    debugStream->print(F("SIM800L : readHTTPBody() - Data size received of "));
+    debugStream->print(length);
+    debugStream->println(F(" bytes"));
+  }
+
+  // Ask for reading (after the data already written to the sink) and detect the start of the reading...
+  if(responseSink != NULL && *offset > 0) {
+    sprintf_P(internalBuffer, PSTR("AT+HTTPREAD=%lu,%lu"), (unsigned long)*offset, (unsigned long)(length - *offset));
+    sendCommand(internalBuffer);
+  } else {
+    sendCommand_P(AT_CMD_HTTPREAD);
+  }
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_HTTPREAD, 2)) {
+    return 705;
+  }
+
+  uint16_t sinkRC = 0;
+  bool cacheComplete = true;
+  if(responseSink != NULL) {
+    // Stream the data to the sink by chunks of the reception buffer
+    while(*offset < length) {
+      uint16_t chunkSize = readData(recvBuffer, length - *offset < recvBufferSize ? length - *offset : recvBufferSize);
+      if(chunkSize == 0) {
+        if(enableDebug) debugStream->println(F("SIM800L : readHTTPBody() - Timeout while reading data from HTTP"));
+        return 705;
+      }
+      // In case of error, the data is still read to stay in sync with the module
+      if(sinkRC == 0 && !responseSink->write(*offset, (uint8_t*)recvBuffer, chunkSize)) {
+        if(enableDebug) debugStream->println(F("SIM800L : readHTTPBody() - Unable to write on the sink"));
+        sinkRC = 708;
+      }
+      if(cacheStoring && cacheComplete && !responseCache->write(*offset, (uint8_t*)recvBuffer, chunkSize)) {
+        cacheComplete = false;
+      }
+      *offset += chunkSize;
+    }
+    initRecvBuffer();
+  } else {
+    // Read the data and purge the serial if buffer is too small
+    dataSize = readData(recvBuffer, length < (uint32_t)(recvBufferSize - 1) ? length : recvBufferSize - 1);
+    if(dataSize < length) {
+      if(enableDebug) {
+        debugStream->println(F("SIM800L : readHTTPBody() - Buffer overflow while loading data from HTTP. Keep only first bytes..."));
+      }
+      uint32_t toRead = length - dataSize;
+      while(toRead > 0) {
+        size_t bytesRead = readData(internalBuffer, toRead < internalBufferSize ? toRead : internalBufferSize);
+        if(bytesRead == 0) {
+          break;
+        }
+        toRead -= bytesRead;
+      }
+    }
+  }
+
+  // We are expecting a final OK
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : readHTTPBody() - Invalid end of data while reading HTTP result from the module"));
+    return 705;
+  }
+
+  dataTransferred += length;
+
+  if(enableDebug) {
+    debugStream->print(F("SIM800L : readHTTPBody() - Received from HTTP call : "));
+    debugStream->println(recvBuffer);
+  }
+
+  // Keep the body in the cache if complete
+  if(cacheStoring) {
+    if(responseSink == NULL) {
+      cacheComplete = dataSize == length && responseCache->write(0, (uint8_t*)recvBuffer, dataSize);
+    }
+    responseCache->end(cacheComplete && sinkRC == 0);
+    cacheStoring = false;
+  }
+
+  return sinkRC;
+}
+
+/**
+ * Close the HTTP session on the module
+ * Returns 0 if OK, the error code elsewhere
+ */
+uint16_t SIM800L::terminateHTTP() {
+  sendCommand_P(AT_CMD_HTTPTERM);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : terminateHTTP() - Unable to close HTTP session"));
+    return 706;
+  }
+  return 0;
+}
+
+/**
+ * Build the headers of a conditional GET in the internal buffer: headers of the caller
+ * followed by the validators of the cached answer
+ * Returns the headers of the caller if the internal buffer is too small
+ */
+const char* SIM800L::buildConditionalHeaders(const char* headers) {
+  const char* etag = cacheValidators;
+  const char* lastModified = cacheValidators + SIM800L_CACHE_VALIDATOR_SIZE;
+
+  uint16_t length = 0;
+  if(headers != NULL) {
+    length = flashParameters & FLASH_HEADERS ? strlen_P(headers) : strlen(headers);
+    if(length >= internalBufferSize) {
+      return headers;
+    }
+    if(flashParameters & FLASH_HEADERS) {
+      strcpy_P(internalBuffer, headers);
+    } else {
+      strcpy(internalBuffer, headers);
+    }
+  }
+
+  // Headers are separated by \r\n (escaped for the module)
+  if(etag[0] != '\0') {
+    int written = snprintf_P(internalBuffer + length, internalBufferSize - length, PSTR("%sIf-None-Match: %s"), length > 0 ? "\\r\\n" : "", etag);
+    if(written < 0 || written >= internalBufferSize - length) {
+      if(enableDebug) debugStream->println(F("SIM800L : buildConditionalHeaders() - Internal buffer too small for the validators"));
+      return headers;
+    }
+    length += written;
+  }
+  if(lastModified[0] != '\0') {
+    int written = snprintf_P(internalBuffer + length, internalBufferSize - length, PSTR("%sIf-Modified-Since: %s"), length > 0 ? "\\r\\n" : "", lastModified);
+    if(written < 0 || written >= internalBufferSize - length) {
+      if(enableDebug) debugStream->println(F("SIM800L : buildConditionalHeaders() - Internal buffer too small for the validators"));
+      return headers;
+    }
+    length += written;
+  }
+
+  return length > 0 ? internalBuffer : headers;
+}
+
+/**
+ * Read the header of the HTTP answer and extract the validators (ETag and Last-Modified)
+ * Returns 0 if OK, the error code elsewhere
+ */
+uint16_t SIM800L::readHTTPValidators() {
+  char* etag = cacheValidators;
+  char* lastModified = cacheValidators + SIM800L_CACHE_VALIDATOR_SIZE;
+  etag[0] = '\0';
+  lastModified[0] = '\0';
+
+  sendCommand_P(AT_CMD_HTTPHEAD);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_HTTPHEAD, 2)) {
+    if(enableDebug) debugStream->println(F("SIM800L : readHTTPValidators() - Unable to read the HTTP header"));
+    return 705;
+  }
+  uint32_t length = strtoul(strstr_P(internalBuffer, AT_RSP_HTTPHEAD) + strlen_P(AT_RSP_HTTPHEAD), NULL, 10);
+
+  // Parse the header line by line in the internal buffer (the end of the long lines is skipped)
+  uint16_t lineLength = 0;
+  while(length > 0) {
+    char c;
+    if(readData(&c, 1) == 0) {
+      if(enableDebug) debugStream->println(F("SIM800L : readHTTPValidators() - Timeout while reading the HTTP header"));
+      return 705;
+    }
+    length--;
+
+    if(c != '\r' && c != '\n' && lineLength < internalBufferSize - 1) {
+      internalBuffer[lineLength++] = c;
+    }
+    if(c == '\n' || length == 0) {
+      internalBuffer[lineLength] = '\0';
+      lineLength = 0;
+
+      // The validators too long are ignored (a truncated validator never matches)
+      const char* value = NULL;
+      char* validator = NULL;
+      if(strncasecmp_P(internalBuffer, PSTR("ETag:"), 5) == 0) {
+        value = internalBuffer + 5;
+        validator = etag;
+      } else if(strncasecmp_P(internalBuffer, PSTR("Last-Modified:"), 14) == 0) {
+        value = internalBuffer + 14;
+        validator = lastModified;
+      }
+      if(value != NULL) {
+        while(*value == ' ') {
+          value++;
+        }
+        if(strlen(value) < SIM800L_CACHE_VALIDATOR_SIZE) {
+          strcpy(validator, value);
+        }
+      }
+    }
+  }
+
+  // We are expecting a final OK
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : readHTTPValidators() - Invalid end of the HTTP header"));
+    return 705;
+  }
+
+  if(enableDebug) {
+    debugStream->print(F("SIM800L : readHTTPValidators() - ETag "));
+    debugStream->print(etag);
+    debugStream->print(F(", Last-Modified "));
+    debugStream->println(lastModified);
+  }
+
+  return 0;
+}
+
+/**
+ * Serve the body cached for the URL to the response sink or to the reception buffer
+ * Returns 0 if OK, the error code elsewhere
+ */
+uint16_t SIM800L::serveCachedAnswer(const char* url) {
+  initRecvBuffer();
+  dataSize = 0;
+  answerFromCache = true;
+
+  if(enableDebug) debugStream->println(F("SIM800L : serveCachedAnswer() - Not modified, serve the cached answer"));
+
+  if(responseSink == NULL) {
+    // Load the body in the reception buffer (keep the last byte for the end of string)
+    uint16_t chunkSize;
+    while(dataSize < recvBufferSize - 1 && (chunkSize = responseCache->read(url, dataSize, (uint8_t*)recvBuffer + dataSize, recvBufferSize - 1 - dataSize)) > 0) {
+      dataSize += chunkSize;
+    }
+    return 0;
+  }
+
+  // Copy the body to the sink by chunks of the reception buffer
+  uint32_t offset = 0;
+  uint16_t chunkSize;
+  while((chunkSize = responseCache->read(url, offset, (uint8_t*)recvBuffer, recvBufferSize)) > 0) {
+    if(!responseSink->write(offset, (uint8_t*)recvBuffer, chunkSize)) {
+      if(enableDebug) debugStream->println(F("SIM800L : serveCachedAnswer() - Unable to write on the sink"));
+      initRecvBuffer();
+      return 708;
+    }
+    offset += chunkSize;
+  }
+  initRecvBuffer();
+
+  return 0;
+}
+
+/**
+ * Meta method to do the HTTP/S GET or POST and retry the transient failures from
+ * the stage which failed (the previous stages are kept by the module)
+ */
+uint16_t SIM800L::doHTTP(bool post, const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs) {
+  ErrorStage stage = STAGE_INIT;
+  uint32_t retryDelay = retryInitialDelay;
+  uint16_t httpRC = 0;
+  uint32_t length = 0;
+  uint32_t offset = 0;
+
+  // Conditional GET with the validators of the answer cached for the URL
+  bool cacheable = !post && responseCache != NULL && !(flashParameters & FLASH_URL);
+  conditionalGet = cacheable && responseCache->lookup(url, cacheValidators, SIM800L_CACHE_VALIDATOR_SIZE, cacheValidators + SIM800L_CACHE_VALIDATOR_SIZE, SIM800L_CACHE_VALIDATOR_SIZE);
+  answerFromCache = false;
+
+  for(uint8_t attempt = 1; ; attempt++) {
+    ErrorStage failedStage = stage;
+    uint16_t rc = 0;
+    uint32_t attemptStart = millis();
+    lastCMECode = -1;
+    if(stage <= STAGE_SERVER) {
+      httpRC = 0;
+    }
+
+    if(stage == STAGE_INIT) {
+      rc = initiateHTTP(url, headers);
+    }
+    if(rc == 0 && post && stage <= STAGE_WRITE) {
+      failedStage = STAGE_WRITE;
+      rc = writeHTTPPayload(contentType, payload, clientWriteTimeoutMs);
+    }
+    if(rc == 0 && stage <= STAGE_ACTION) {
+      failedStage = STAGE_ACTION;
+      rc = startHTTPAction(post);
+    }
+    if(rc == 0 && stage <= STAGE_SERVER) {
+      failedStage = STAGE_SERVER;
+      initRecvBuffer();
+      dataSize = 0;
+      offset = 0;
+      rc = readHTTPAction(serverReadTimeoutMs, &httpRC, &length);
+      // The transient errors of the server are retried like the failures of the module
+      if(rc == 0 && httpRC >= 400 && isTransientError(httpRC, -1)) {
+        rc = httpRC;
+      }
+    }
+    if(rc == 0 && stage <= STAGE_READ && httpRC == 200) {
+      failedStage = STAGE_READ;
+      // Keep the new answer in the cache (only if read from the start)
+      if(cacheable && offset == 0) {
+        rc = readHTTPValidators();
+        cacheStoring = rc == 0 && (cacheValidators[0] != '\0' || cacheValidators[SIM800L_CACHE_VALIDATOR_SIZE] != '\0')
+          && responseCache->begin(url, cacheValidators, cacheValidators + SIM800L_CACHE_VALIDATOR_SIZE);
+      }
+      if(rc == 0) {
+        rc = readHTTPBody(length, &offset);
+      }
+      if(cacheStoring) {
+        responseCache->end(false);
+        cacheStoring = false;
+      }
+    }
+    if(rc == 0) {
+      failedStage = STAGE_TERMINATE;
+      rc = terminateHTTP();
+    }
+
+    // Successful call (the HTTP errors of the server are reported but not retried)
+    if(rc == 0) {
+      // Not modified since the answer cached: serve the cached body
+      if(httpRC == 304 && conditionalGet) {
+        conditionalGet = false;
+        uint16_t cacheRC = serveCachedAnswer(url);
+        if(cacheRC > 0) {
+          recordError(STAGE_READ, cacheRC, httpRC);
+          return cacheRC;
+        }
+        httpRC = 200;
+      }
+      conditionalGet = false;
+      recordError(httpRC >= 400 ? STAGE_SERVER : STAGE_NONE, httpRC, httpRC);
+      recordBearerResult(false, millis() - attemptStart);
+      return httpRC;
+    }
+
+    recordError(failedStage, rc, httpRC);
+
+    // The session is bound to the bearer: a new session is needed after a failover
+    bool failover = isBearerStall(rc, lastCMECode, httpRC) && recordBearerResult(true, millis() - attemptStart);
+    if(!lastError.transient || attempt >= retryAttempts) {
+      conditionalGet = false;
+      // Close the session to be able to start the next one
+      if(failedStage != STAGE_TERMINATE) {
+        terminateHTTP();
+      }
+      return rc;
+    }
+
+    if(enableDebug) {
+      debugStream->print(F("SIM800L : doHTTP() - Transient error "));
+      debugStream->print(rc);
+      debugStream->print(F(" at stage "));
+      debugStream->print(failedStage);
+      debugStream->print(F(", retry in "));
+      debugStream->print(retryDelay);
+      debugStream->println(F(" ms"));
+    }
+    delay(retryDelay);
+    retryDelay = retryDelay * 2 < retryMaxDelay ? retryDelay * 2 : retryMaxDelay;
+
+    // Restart from the stage which failed: a new session if the initiation failed (or on another
+    // bearer), a new action if the answer of the server is lost
+    if(failedStage == STAGE_INIT || failover) {
+      terminateHTTP();
+      failedStage = STAGE_INIT;
+    } else if(failedStage == STAGE_SERVER) {
+      failedStage = STAGE_ACTION;
+    }
+    stage = failedStage;
+  }
+}
+
+/**
+ * Record the details of the last error of an HTTP call (STAGE_NONE if successful)
+ */
+void SIM800L::recordError(ErrorStage stage, uint16_t code, uint16_t httpStatus) {
+  lastError.stage = stage;
+  lastError.code = stage == STAGE_NONE ? 0 : code;
+  lastError.cmeCode = lastCMECode;
+  lastError.httpStatus = httpStatus;
+  lastError.transient = stage != STAGE_NONE && isTransientError(code, lastCMECode);
+
+  if(enableDebug && stage != STAGE_NONE) {
+    debugStream->print(F("SIM800L : recordError() - Error "));
+    debugStream->print(code);
+    debugStream->print(F(" (CME "));
+    debugStream->print(lastCMECode);
+    debugStream->print(F(") at stage "));
+    debugStream->print(stage);
+    debugStream->println(lastError.transient ? F(", transient") : F(", permanent"));
+  }
+}
+
+/**
+ * Check if an error may disappear by itself (network, busy module or server)
+ * The extended error of the module takes precedence over the code of the driver
+ */
+bool SIM800L::isTransientError(uint16_t code, int16_t cmeCode) {
+  if(cmeCode >= 0) {
+    switch(cmeCode) {
+      case 14:  // SIM busy
+      case 30:  // No network service
+      case 31:  // Network timeout
+      case 99:  // Resource limitation
+      case 134: // Service option temporarily out of order
+      case 148: // Unspecified GPRS error
+      case 160: // DNS resolve failed
+      case 161: // Socket open failed
+      case 177: // Connection to the network failed
+      case 180: // GPRS not attached
+      case 181: // TCP/IP stack busy
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  switch(code) {
+    case 408: // Timeout of the server (or of the module)
+    case 429: // Too many requests
+    case 500: // Internal error of the server
+    case 502: // Bad gateway
+    case 503: // Service unavailable
+    case 504: // Gateway timeout
+    case 601: // Network error
+    case 602: // No memory on the module
+    case 603: // DNS error
+    case 604: // Stack busy
+    case 701: // Unable to init the HTTP session
+    case 703: // Unable to start the HTTP action
+    case 705: // Unable to read the data
+    case 706: // Unable to close the HTTP session
+    case 707: // Unable to write the payload
+      return true;
+    default:
+      // Parameters (702), sink (708) and other HTTP statuses are permanent
+      return false;
+  }
+}
+
+/**
+ * Send a command of a bearer profile (the CID is formatted in the command)
+ */
+void SIM800L::sendBearerCommand(const char* command, uint8_t cid, const char* parameter, bool parameterInFlash) {
+  char buffer[40];
+  sprintf_P(buffer, command, cid);
+  sendCommand(buffer, false, parameter, parameterInFlash);
+}
+
+/**
+ * Check if an error shows that the bearer doesn't carry the data anymore
+ * (the errors of the server and of the parameters are not related to the bearer)
+ * The HTTP status is the one received from the module (0 if none), to tell the
+ * timeout of the driver (408 without status) from a 408 answered by the server
+ */
+bool SIM800L::isBearerStall(uint16_t code, int16_t cmeCode, uint16_t httpStatus) {
+  switch(cmeCode) {
+    case 30:  // No network service
+    case 31:  // Network timeout
+    case 148: // Unspecified GPRS error
+    case 160: // DNS resolve failed
+    case 161: // Socket open failed
+    case 177: // Connection to the network failed
+    case 180: // GPRS not attached
+      return true;
+  }
+
+  switch(code) {
+    case 408: // No answer of the server (a slow server answering 408 is not a stall)
+      return httpStatus == 0;
+    case 601: // Network error
+    case 603: // DNS error
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Update the health of the active bearer after an HTTP attempt
+ * After too many consecutive stalls, switch to the healthiest other profile configured
+ * (least consecutive stalls, then lowest latency), opened if needed
+ * Returns true if the active bearer has changed
+ */
+bool SIM800L::recordBearerResult(bool stalled, uint32_t durationMs) {
+  SIM800LBearerStats* stats = &bearerStats[activeBearer - 1];
+  stats->requests++;
+
+  if(!stalled) {
+    stats->consecutiveFailures = 0;
+    if(stats->latencyMs == 0) {
+      stats->latencyMs = durationMs;
+    } else {
+      stats->latencyMs = (stats->latencyMs * 7 + durationMs) / 8;
+    }
+    return false;
+  }
+
+  stats->failures++;
+  if(stats->consecutiveFailures < 255) {
+    stats->consecutiveFailures++;
+  }
+  if(bearerMaxFailures == 0 || stats->consecutiveFailures < bearerMaxFailures) {
+    return false;
+  }
+
+  int8_t best = -1;
+  for(uint8_t i = 0; i < SIM800L_BEARER_COUNT; i++) {
+    if(i == activeBearer - 1 || !bearerStats[i].configured) {
+      continue;
+    }
+    if(best < 0
+      || bearerStats[i].consecutiveFailures < bearerStats[best].consecutiveFailures
+      || (bearerStats[i].consecutiveFailures == bearerStats[best].consecutiveFailures && bearerStats[i].latencyMs < bearerStats[best].latencyMs)) {
+      best = i;
+    }
+  }
+  if(best < 0) {
+    return false;
+  }
+
+  // The parameters of the profile are already in the module, only open it
+  if(!isConnectedBearer(best + 1) && !connectBearer(best + 1)) {
+    if(enableDebug) debugStream->println(F("SIM800L : recordBearerResult() - Unable to open the alternative bearer"));
+    bearerStats[best].failures++;
+    if(bearerStats[best].consecutiveFailures < 255) {
+      bearerStats[best].consecutiveFailures++;
+    }
+    return false;
+  }
+
+  if(enableDebug) {
+    debugStream->print(F("SIM800L : recordBearerResult() - Failover from bearer "));
+    debugStream->print(activeBearer);
+    debugStream->print(F(" to bearer "));
+    debugStream->println(best + 1);
+  }
+  activeBearer = best + 1;
+  return true;
+}
+
+/**
+ * Read the messages of the module during the boot and note the URCs of the boot
+ * Returns true when the expected answer is received (or a new URC of the boot if NULL)
+ */
+bool SIM800L::readBootEvents(uint16_t timeout, const char* expectedAnswer) {
+  uint8_t previousEvents = bootEvents;
+  uint32_t timerStart = millis();
+  uint32_t elapsed;
+  while((elapsed = millis() - timerStart) < timeout) {
+    if(!readResponse(timeout - elapsed)) {
+      return false;
+    }
+
+    if(strstr_P(internalBuffer, AT_RSP_RDY) != NULL) {
+      bootEvents |= BOOT_RDY;
+    }
+    if(strstr_P(internalBuffer, AT_RSP_CALL_READY) != NULL) {
+      bootEvents |= BOOT_CALL_READY;
+    }
+    if(strstr_P(internalBuffer, AT_RSP_SMS_READY) != NULL) {
+      bootEvents |= BOOT_SMS_READY;
+    }
+    if(strstr_P(internalBuffer, AT_RSP_CPIN_NOT_INSERTED) != NULL || strstr_P(internalBuffer, AT_RSP_CPIN_SIM_PIN) != NULL) {
+      bootEvents |= BOOT_SIM_ERROR;
+    }
+
+    if(expectedAnswer == NULL ? bootEvents != previousEvents : strstr_P(internalBuffer, expectedAnswer) != NULL) {
+      return true;
+    }
+    if(strstr_P(internalBuffer, AT_RSP_ERROR) != NULL) {
+      return false;
+    }
+  }
+  return false;
+}
+
+/**
+ * Apply the configuration of the module (extended errors) and the parameters of the
+ * active bearer in one command line, or command by command if too long
+ */
+bool SIM800L::applyBootConfiguration(const char* apn, const char* user, const char* password) {
+  uint16_t length = snprintf_P(internalBuffer, internalBufferSize, AT_CMD_BOOT_CONFIG, activeBearer, activeBearer, apn);
+  if(user != NULL || password != NULL) {
+    if(user == NULL || password == NULL) {
+      length = internalBufferSize;
+    } else if(length < internalBufferSize) {
+      length += snprintf_P(internalBuffer + length, internalBufferSize - length, AT_CMD_BOOT_CREDENTIALS, activeBearer, user, activeBearer, password);
+    }
+  }
+
+  if(length >= internalBufferSize) {
+    sendCommand_P(AT_CMD_CMEE1);
+    return readBootEvents(DEFAULT_TIMEOUT, AT_RSP_OK) && setupBearer(activeBearer, apn, user, password);
+  }
+
+  sendCommand(internalBuffer);
+  if(!readBootEvents(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : applyBootConfiguration() - Configuration not accepted yet"));
+    return false;
+  }
+  bearerStats[activeBearer - 1].configured = true;
+  return true;
+}
+
+/**
+ * Meta method to initiate the HTTP/S session on the module
+ */
+uint16_t SIM800L::initiateHTTP(const char* url, const char* headers) {
+  // Init HTTP connection
+  sendCommand_P(AT_CMD_HTTPINIT);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to init HTTP"));
+    return 701;
+  }
+
+  // Use the active GPRS bearer
+  sendBearerCommand(AT_CMD_HTTPPARA_CID, activeBearer);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to define bearer"));
+    return 702;
+  }
+
+  // Define URL to look for
+  sendCommand_P(AT_CMD_HTTPPARA_URL, url, flashParameters & FLASH_URL);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to define the URL"));
+    return 702;
+  }
+
+  // Set Headers (with the validators of the cached answer for a conditional GET)
+  const char* userData = conditionalGet ? buildConditionalHeaders(headers) : headers;
+  if (userData != NULL) {
+    sendCommand_P(AT_CMD_HTTPPARA_USERDATA, userData, userData == headers && (flashParameters & FLASH_HEADERS));
+    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+      if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to define Headers"));
+      return 702;
+    }
+  }
+
+  // Enable HTTP redirection if HTTP RC 302
+  sendCommand_P(AT_CMD_HTTPPARA_REDIR);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to enable HTTP redirection"));
+    return 702;
+  }
+
+  // Check if the firmware support HTTPSSL command
+  bool isSupportSSL = false;
+  char* version = getVersion();
+  int16_t rIdx = version != NULL ? strIndex(version, "R") : -1;
+  if(rIdx > 0 && isdigit(version[rIdx + 1]) && isdigit(version[rIdx + 2])) {
+    uint8_t releaseInt = (version[rIdx + 1] - '0') * 10 + (version[rIdx + 2] - '0');
+
+    // The release should be greater or equals to 14 to support SSL stack
+    if(releaseInt >= 14) {
+      isSupportSSL = true;
+      if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Support of SSL enabled"));
+    } else {
+      isSupportSSL = false;
+      if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Support of SSL disabled (SIM800L firware below R14)"));
+    }
+  }
+
+  // Send HTTPSSL command only if the version is greater or equals to 14
+  if(isSupportSSL) {
+    // HTTP or HTTPS
+    bool isHTTPS = flashParameters & FLASH_URL ? strncmp_P("https://", url, 8) == 0 : strncmp(url, "https://", 8) == 0;
+    if(isHTTPS) {
+      sendCommand_P(AT_CMD_HTTPSSL_Y);
+      if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+        if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to switch to HTTPS"));
+        return 702;
+      }
+    } else {
+      sendCommand_P(AT_CMD_HTTPSSL_N);
+      if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+        if(enableDebug) debugStream->println(F("SIM800L : initiateHTTP() - Unable to switch to HTTP"));
+        return 702;
+      }
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Force a reset of the module
+ */
+void SIM800L::reset() {
+  if(pinReset != RESET_PIN_NOT_USED)
+  {
+    // Some logging
+    if(enableDebug) debugStream->println(F("SIM800L : Reset"));
+
+    // Reset the device (the module is ready when it answers, see isReady() or begin())
+    digitalWrite(pinReset, LOW);
+    delay(SIM800L_RESET_PULSE);
+    digitalWrite(pinReset, HIGH);
+  } else {
+    // Some logging
+    if(enableDebug) debugStream->println(F("SIM800L : Reset requested but reset pin undefined"));
+    if(enableDebug) debugStream->println(F("SIM800L : No reset"));
+  }
+
+  // Purge the serial
+  stream->flush();
+  while (stream->available()) {
+    stream->read();
+  }
+}
+
+/**
+ * Fast cold start of the module: wait for the module without fixed delays, apply the
+ * configuration in one command line while the module registers, then open the bearer
+ */
+bool SIM800L::begin(const char* apn, const char* user, const char* password, uint32_t timeoutMs) {
+  uint32_t start = millis();
+  uint32_t commandsAtStart = commandCount;
+  bootStats = SIM800LBootStats();
+  bootEvents = 0;
+
+  bool configured = false;
+  bool registered = false;
+  while(millis() - start < timeoutMs) {
+    // The module is ready after RDY (fixed baud rate) or when it answers to AT (auto-bauding)
+    if(!(bootEvents & BOOT_RESPONSIVE)) {
+      sendCommand_P(AT_CMD_BASE);
+      if(!readBootEvents(SIM800L_BOOT_POLL, AT_RSP_OK) && !(bootEvents & BOOT_RDY)) {
+        continue;
+      }
+      bootEvents |= BOOT_RESPONSIVE;
+      bootStats.responsiveMs = millis() - start;
+    }
+
+    if(bootEvents & BOOT_SIM_ERROR) {
+      if(enableDebug) debugStream->println(F("SIM800L : begin() - SIM card missing or locked"));
+      break;
+    }
+
+    // The configuration doesn't depend on the network: applied during the registration
+    if(!configured && applyBootConfiguration(apn, user, password)) {
+      configured = true;
+      bootStats.configuredMs = millis() - start;
+    }
+
+    if(!registered) {
+      NetworkRegistration network = getRegistrationStatus();
+      if(network == DENIED) {
+        if(enableDebug) debugStream->println(F("SIM800L : begin() - Network registration denied"));
+        break;
+      }
+      if(network == REGISTERED_HOME || network == REGISTERED_ROAMING) {
+        registered = true;
+        bootStats.registeredMs = millis() - start;
+      }
+    }
+
+    // Open the bearer as soon as registered (already opened on a warm start), the wait for the
+    // network is limited to the time left before the timeout of begin()
+    if(configured && registered) {
+      bool connected = isConnectedBearer(activeBearer);
+      uint32_t elapsed = millis() - start;
+      if(!connected && elapsed < timeoutMs) {
+        uint32_t remaining = timeoutMs - elapsed;
+        sendBearerCommand(AT_CMD_SAPBR1, activeBearer);
+        armTimeout(TIMEOUT_NETWORK);
+        connected = readResponseCheckAnswer_P(remaining < 65000 ? remaining : 65000, AT_RSP_OK);
+      }
+      if(connected) {
+        bootStats.firstRequestMs = millis() - start;
+        bootStats.commands = commandCount - commandsAtStart;
+        if(enableDebug) {
+          debugStream->print(F("SIM800L : begin() - Ready for the first request in "));
+          debugStream->print(bootStats.firstRequestMs);
+          debugStream->println(F(" ms"));
+        }
+        return true;
+      }
+      if(enableDebug) debugStream->println(F("SIM800L : begin() - Unable to open the bearer"));
+    }
+
+    // Wait for the progress of the module (Call Ready, SMS Ready...) until the next poll
+    readBootEvents(SIM800L_BOOT_POLL, NULL);
+  }
+
+  if(enableDebug) debugStream->println(F("SIM800L : begin() - Module not ready"));
+  bootStats.commands = commandCount - commandsAtStart;
+  return false;
+}
+
+/**
+ * Return the milestones of the last boot (begin())
+ */
+SIM800LBootStats SIM800L::getBootStats() {
+  return bootStats;
+}
+
+/**
+ * Return the size of data received after the last successful HTTP connection
+ */
+uint16_t SIM800L::getDataSizeReceived() {
+  return dataSize;
+}
+
+/**
+ * Return the buffer of data received after the last successful HTTP connection
+ */
+char* SIM800L::getDataReceived() {
+  return recvBuffer;
+}
+
+/**
+ * Status function: Check if AT command works
+ */
+bool SIM800L::isReady() {
+  sendCommand_P(AT_CMD_BASE);
+  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
+}
+
+/**
+ * Config function: Enable commande echo mode
+ */
+bool SIM800L::enableEchoMode() {
+  sendCommand_P(AT_CMD_ECHO);
+  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
+}
+
+/**
+ * Status function: Check the power mode
+ */
+PowerMode SIM800L::getPowerMode() {
+  sendCommand_P(AT_CMD_CFUN_TEST);
+  if(readResponse(DEFAULT_TIMEOUT)) {
+    // Check if there is an error
+    int16_t errIdx = strIndex(internalBuffer, "ERROR");
+    if(errIdx > 0) {
+      return POW_ERROR;
+    }
+
+    // Extract the value
+    int16_t idx = strIndex(internalBuffer, "+CFUN: ");
+    if(idx < 0) {
+      return POW_ERROR;
+    }
+    char value = internalBuffer[idx + 7];
+
+    // Prepare the clear output
+    switch(value) {
+      case '0' : currentPowerMode = MINIMUM; break;
+      case '1' : currentPowerMode = NORMAL; break;
+      case '4' : currentPowerMode = SLEEP; break;
+      default  : currentPowerMode = POW_UNKNOWN;
+    }
+    return currentPowerMode;
+  }
+  return POW_ERROR;
+}
+
+/**
+ * Status function: Get version of the module
+ */
+char* SIM800L::getVersion() {
+  sendCommand_P(AT_CMD_ATI);
+  if(readResponse(DEFAULT_TIMEOUT)) {
+    // Extract the value
+    int16_t idx = strIndex(internalBuffer, "SIM");
+    return extractValue(idx, '\r');
+  } else {
+    return NULL;
+  }
+}
+
+/**
+ * Status function: Get firmware version
+ */
+char* SIM800L::getFirmware() {
+  sendCommand_P(AT_CMD_GMR);
+  if(readResponse(DEFAULT_TIMEOUT)) {
+    // Extract the value (after the echo if enabled)
+    int16_t idx = skipEcho("AT+GMR");
+    return extractValue(idx, '\r');
+  } else {
+    return NULL;
+  }
+}
+
+/**
+ * Status function: Requests the simcard number
+ */
+char* SIM800L::getSimCardNumber() {
+  sendCommand_P(AT_CMD_SIM_CARD);
+  if(readResponse(DEFAULT_TIMEOUT)) {
+    // Extract the value (after the echo if enabled)
+    int16_t idx = skipEcho("AT+CCID");
+    return extractValue(idx, '\r');
+  } else {
+    return NULL;
+  }
+}
+
+/**
+ * Status function: Request the status of the SIM card
+ */
+char* SIM800L::getSimStatus() {
+  sendCommand_P(AT_CMD_CPIN_TEST);
+  if(readResponse(DEFAULT_TIMEOUT)) {
+    // Extract the value
+    int16_t idx = strIndex(internalBuffer, "+CPIN: ");
+    if(idx < 0) {
+      return "ERROR";
+    }
+    return extractValue(idx + 7, '\r');
+  } else {
+    return "ERROR";
+  }
+}
+
+/**
+ * Status function: Requests the IP of the GPRS connection
+ */
+char* SIM800L::getIP() {
+  sendBearerCommand(AT_CMD_SAPBR2, activeBearer);
+  if(readResponse(DEFAULT_TIMEOUT)) {
+    char expected[16];
+    sprintf_P(expected, PSTR("+SAPBR: %u,1,\""), activeBearer);
+    int16_t idx = strIndex(internalBuffer, expected);
+    if(idx < 0) {
+      return "Not connected";
+    }
+    return extractValue(idx + strlen(expected), '"');
+  } else {
+    return "Not connected";
+  }
+}
+
+/**
+ * Status function: Check if the module is registered on the network
+ */
+NetworkRegistration SIM800L::getRegistrationStatus() {
+  sendCommand_P(AT_CMD_CREG_TEST);
+  if(readResponse(DEFAULT_TIMEOUT)) {
+    // Check if there is an error
+    int16_t errIdx = strIndex(internalBuffer, "ERROR");
+    if(errIdx > 0) {
+      return NET_ERROR;
+    }
+
+    // Extract the value (+CREG: <n>,<stat>)
+    int16_t idx = strIndex(internalBuffer, "+CREG: ");
+    if(idx < 0) {
+      return NET_ERROR;
+    }
+    char* separator = strchr(internalBuffer + idx, ',');
+    if(separator == NULL) {
+      return NET_ERROR;
+    }
+    char value = separator[1];
+
+    // Prepare the clear output
+    switch(value) {
+      case '0' : return NOT_REGISTERED;
+      case '1' : return REGISTERED_HOME;
+      case '2' : return SEARCHING;
+      case '3' : return DENIED;
+      case '5' : return REGISTERED_ROAMING;
+      default  : return NET_UNKNOWN;
+    }
+  }
+
+  return NET_ERROR;
+}
+
+/**
+ * Define PIN code to activate SIM card
+ */
+bool SIM800L::setPinCode(const char *pin) {
+  // Set the PIN code to activate the SIM card
+  sendCommand_P(AT_CMD_CPIN_PIN, pin, flashParameters & FLASH_PIN);
+  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
+}
+
+/**
+ * Define PIN code in PROGMEM (F() macro) to activate SIM card
+ */
+bool SIM800L::setPinCode(const __FlashStringHelper* pin) {
+  flashParameters = FLASH_PIN;
+  bool result = setPinCode((const char*)pin);
+  flashParameters = 0;
+  return result;
+}
+
+/**
+ * Setup the GPRS connectivity
+ * As input, give the APN string of the operator
+ */
+bool SIM800L::setupGPRS(const char* apn) {
+  return setupBearer(activeBearer, apn);
+}
+
+/**
+ * Setup the GPRS connectivity with the APN in PROGMEM (F() macro)
+ */
+bool SIM800L::setupGPRS(const __FlashStringHelper* apn) {
+  flashParameters = FLASH_APN;
+  bool result = setupGPRS((const char*)apn);
+  flashParameters = 0;
+  return result;
+}
+
+/**
+ * Setup the GPRS connectivity with user and password
+ * As input, give the APN string of the operator, the user and the password
+ */
+bool SIM800L::setupGPRS(const char* apn, const char* user, const char* password) {
+  return setupBearer(activeBearer, apn, user, password);
+}
+
+/**
+ * Setup the GPRS connectivity with the APN, the user and the password in PROGMEM (F() macro)
+ */
+bool SIM800L::setupGPRS(const __FlashStringHelper* apn, const __FlashStringHelper* user, const __FlashStringHelper* password) {
+  flashParameters = FLASH_APN | FLASH_CREDENTIALS;
+  bool result = setupGPRS((const char*)apn, (const char*)user, (const char*)password);
+  flashParameters = 0;
+  return result;
+}
+
+/**
+ * Open the GPRS connectivity
+ */
+bool SIM800L::connectGPRS() {
+  return connectBearer(activeBearer);
+}
+
+/**
+ * Check if GPRS is connected
+ */
+bool SIM800L::isConnectedGPRS() {
+  return isConnectedBearer(activeBearer);
+}
+
+/**
+ * Close the GPRS connectivity
+ */
+bool SIM800L::disconnectGPRS() {
+  return disconnectBearer(activeBearer);
+}
+
+/**
+ * Setup a bearer profile (CID 1 to 3) with the APN, and optionally the user and the password
+ * The parameters are kept by the module until the next reset
+ */
+bool SIM800L::setupBearer(uint8_t cid, const char* apn, const char* user, const char* password) {
+  if(cid < 1 || cid > SIM800L_BEARER_COUNT) {
+    return false;
+  }
+  bearerStats[cid - 1].configured = false;
+
+  // Prepare the GPRS connection as the bearer
+  sendBearerCommand(AT_CMD_SAPBR_GPRS, cid);
+  if(!readResponseCheckAnswer_P(20000, AT_RSP_OK)) {
+    return false;
+  }
+
+  // Set the config of the bearer with the APN
+  sendBearerCommand(AT_CMD_SAPBR_APN, cid, apn, flashParameters & FLASH_APN);
+  if(!readResponseCheckAnswer_P(20000, AT_RSP_OK)) {
+    return false;
+  }
+
+  if(user != NULL) {
+    // Set the config of the bearer with the USER
+    sendBearerCommand(AT_CMD_SAPBR_USER, cid, user, flashParameters & FLASH_CREDENTIALS);
+    if(!readResponseCheckAnswer_P(20000, AT_RSP_OK)) {
+      return false;
+    }
+  }
+
+  if(password != NULL) {
+    // Set the config of the bearer with the PWD
+    sendBearerCommand(AT_CMD_SAPBR_PWD, cid, password, flashParameters & FLASH_CREDENTIALS);
+    if(!readResponseCheckAnswer_P(20000, AT_RSP_OK)) {
+      return false;
+    }
+  }
+
+  bearerStats[cid - 1].configured = true;
+  return true;
+}
+
+/**
+ * Open a bearer profile
+ */
+bool SIM800L::connectBearer(uint8_t cid) {
+  if(cid < 1 || cid > SIM800L_BEARER_COUNT) {
+    return false;
+  }
+
+  sendBearerCommand(AT_CMD_SAPBR1, cid);
+  armTimeout(TIMEOUT_NETWORK);
+  // Timout is max 85 seconds according to SIM800 specifications
+  // We will wait for 65s to be within uint16_t
+  return readResponseCheckAnswer_P(65000, AT_RSP_OK);
+}
+
+/**
+ * Check if a bearer profile is connected (+SAPBR: <cid>,1,<ip>)
+ */
+bool SIM800L::isConnectedBearer(uint8_t cid) {
+  if(cid < 1 || cid > SIM800L_BEARER_COUNT) {
+    return false;
+  }
+
+  sendBearerCommand(AT_CMD_SAPBR2, cid);
+  if(!readResponse(DEFAULT_TIMEOUT)) {
+    return false;
+  }
+  char expected[16];
+  sprintf_P(expected, AT_RSP_SAPBR, cid);
+  return strIndex(internalBuffer, expected) > 0;
+}
+
+/**
+ * Close a bearer profile
+ */
+bool SIM800L::disconnectBearer(uint8_t cid) {
+  if(cid < 1 || cid > SIM800L_BEARER_COUNT) {
+    return false;
+  }
+
+  sendBearerCommand(AT_CMD_SAPBR0, cid);
+  armTimeout(TIMEOUT_NETWORK);
+  // Timout is max 65 seconds according to SIM800 specifications
+  return readResponseCheckAnswer_P(65000, AT_RSP_OK);
+}
+
+/**
+ * Define the bearer profile used by HTTP, FTP and the GPRS methods
+ */
+bool SIM800L::setActiveBearer(uint8_t cid) {
+  if(cid < 1 || cid > SIM800L_BEARER_COUNT) {
+    return false;
+  }
+  activeBearer = cid;
+  return true;
+}
+
+/**
+ * Return the bearer profile used by HTTP, FTP and the GPRS methods
+ */
+uint8_t SIM800L::getActiveBearer() {
+  return activeBearer;
+}
+
+/**
+ * Return the health of a bearer profile (NULL if the CID is invalid)
+ */
+SIM800LBearerStats* SIM800L::getBearerStats(uint8_t cid) {
+  if(cid < 1 || cid > SIM800L_BEARER_COUNT) {
+    return NULL;
+  }
+  return &bearerStats[cid - 1];
+}
+
+/**
+ * Enable the failover to another bearer profile configured after maxFailures
+ * consecutive stalls of the active one (0 to disable)
+ */
+void SIM800L::enableBearerFailover(uint8_t maxFailures) {
+  bearerMaxFailures = maxFailures;
+}
+
+/**
+ * Setup the FTP service (server, port, user and password)
+ * Binary and passive mode are used for all transfers
+ */
+bool SIM800L::setupFTP(const char* server, uint16_t port, const char* user, const char* password) {
+  // Use the active GPRS bearer
+  sendBearerCommand(AT_CMD_FTPCID, activeBearer);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    return false;
+  }
+
+  // Define the server
+  sendCommand_P(AT_CMD_FTPSERV, server);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    return false;
+  }
+
+  sprintf_P(internalBuffer, PSTR("AT+FTPPORT=%u"), port);
+  sendCommand(internalBuffer);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    return false;
+  }
+
+  // Define the credentials
+  sendCommand_P(AT_CMD_FTPUN, user);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    return false;
+  }
+
+  sendCommand_P(AT_CMD_FTPPW, password);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    return false;
+  }
+
+  // Binary transfers in passive mode
+  sendCommand_P(AT_CMD_FTPTYPE_I);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    return false;
+  }
+
+  sendCommand_P(AT_CMD_FTPMODE_PASSIVE);
+  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
+}
+
+/**
+ * Download a file from the FTP server and stream it to the sink by chunks
+ * Returns 0 if OK, the FTP error code or the error code of the driver elsewhere
+ */
+uint16_t SIM800L::ftpGet(const char* path, const char* filename, SIM800LSink* sink, uint16_t chunkSize, uint16_t serverTimeoutMs) {
+  // The chunk is read in the reception buffer (1460 bytes max for the module)
+  if(chunkSize == 0 || chunkSize > recvBufferSize) {
+    chunkSize = recvBufferSize;
+  }
+  if(chunkSize > 1460) {
+    chunkSize = 1460;
+  }
+
+  // Define the file to download
+  sendCommand_P(AT_CMD_FTPGETNAME, filename);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpGet() - Unable to define the file name"));
+    return 702;
+  }
+
+  sendCommand_P(AT_CMD_FTPGETPATH, path);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpGet() - Unable to define the path"));
+    return 702;
+  }
+
+  // Open the session
+  lastTransferSize = 0;
+  lastTransferDuration = 0;
+  uint32_t timerStart = millis();
+
+  sendCommand_P(AT_CMD_FTPGET1);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpGet() - Unable to open the FTP session"));
+    return 701;
+  }
+
+  // Wait for the server (+FTPGET: 1,1 when data is available, +FTPGET: 1,0 at the end)
+  uint16_t mode = 0;
+  uint16_t status = 0;
+  uint16_t length = 0;
+  armTimeout(TIMEOUT_SERVER);
+  if(!readResponse(serverTimeoutMs) || !parseFTPAnswer_P(AT_RSP_FTPGET, &mode, &status, &length)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpGet() - Server timeout"));
+    return closeFTP(408);
+  }
+
+  while(status == 1) {
+    // The module could announce the end of the transfer at any time
+    if(isAnswerAvailable() && readResponse(DEFAULT_TIMEOUT) && parseFTPAnswer_P(AT_RSP_FTPGET, &mode, &status, &length) && mode == 1) {
+      continue;
+    }
+
+    // Ask for the next chunk
+    sprintf_P(internalBuffer, PSTR("AT+FTPGET=2,%u"), chunkSize);
+    sendCommand(internalBuffer);
+    uint16_t unused = 0;
+    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_FTPGET) || !parseFTPAnswer_P(AT_RSP_FTPGET, &mode, &length, &unused) || mode != 2) {
+      if(enableDebug) debugStream->println(F("SIM800L : ftpGet() - Unable to read data"));
+      return closeFTP(705);
+    }
+
+    if(length > chunkSize || readData(recvBuffer, length) != length) {
+      if(enableDebug) debugStream->println(F("SIM800L : ftpGet() - Invalid chunk received"));
+      return closeFTP(705);
+    }
+
+    if(length > 0 && !sink->write(lastTransferSize, (uint8_t*)recvBuffer, length)) {
+      if(enableDebug) debugStream->println(F("SIM800L : ftpGet() - Unable to write on the sink"));
+      return closeFTP(708);
+    }
+    lastTransferSize += length;
+    dataTransferred += length;
+
+    // We are expecting a final OK
+    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+      if(enableDebug) debugStream->println(F("SIM800L : ftpGet() - Invalid end of data"));
+      return closeFTP(705);
+    }
+
+    // No more data for now, wait for the server
+    if(length == 0) {
+      armTimeout(TIMEOUT_SERVER);
+      if(!readResponse(serverTimeoutMs) || !parseFTPAnswer_P(AT_RSP_FTPGET, &mode, &status, &length)) {
+        if(enableDebug) debugStream->println(F("SIM800L : ftpGet() - Server timeout"));
+        return closeFTP(408);
+      }
+    }
+  }
+
+  lastTransferDuration = millis() - timerStart;
+
+  if(enableDebug) {
+    debugStream->print(F("SIM800L : ftpGet() - End of transfer with status "));
+    debugStream->print(status);
+    debugStream->print(F(" ("));
+    debugStream->print(lastTransferSize);
+    debugStream->println(F(" bytes)"));
+  }
+
+  // Status 0 means the transfer is finished, the session is closed by the module
+  return status;
+}
+
+/**
+ * Upload a file on the FTP server, the data is provided by the source by chunks
+ * Returns 0 if OK, the FTP error code or the error code of the driver elsewhere
+ */
+uint16_t SIM800L::ftpPut(const char* path, const char* filename, SIM800LSource* source, uint16_t chunkSize, bool append, uint16_t serverTimeoutMs) {
+  // The chunk is prepared in the reception buffer
+  if(chunkSize == 0 || chunkSize > recvBufferSize) {
+    chunkSize = recvBufferSize;
+  }
+
+  // Define the file to upload
+  if(!defineFTPUpload(path, filename, append)) {
+    return 702;
+  }
+
+  // Open the session
+  lastTransferSize = 0;
+  lastTransferDuration = 0;
+  uint32_t timerStart = millis();
+
+  sendCommand_P(AT_CMD_FTPPUT1);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpPut() - Unable to open the FTP session"));
+    return 701;
+  }
+
+  // Bytes of the reception buffer prepared but not yet accepted by the module
+  uint16_t pending = 0;
+  bool endOfData = false;
+
+  while(1) {
+    // Wait for the module to be ready (+FTPPUT: 1,1,<maxlength>)
+    uint16_t mode = 0;
+    uint16_t status = 0;
+    uint16_t maxLength = 0;
+    armTimeout(TIMEOUT_SERVER);
+    if(!readResponse(serverTimeoutMs) || !parseFTPAnswer_P(AT_RSP_FTPPUT, &mode, &status, &maxLength)) {
+      if(enableDebug) debugStream->println(F("SIM800L : ftpPut() - Server timeout"));
+      return closeFTP(408);
+    }
+    if(status != 1) {
+      if(enableDebug) {
+        debugStream->print(F("SIM800L : ftpPut() - FTP error "));
+        debugStream->println(status);
+      }
+      return status;
+    }
+
+    // Prepare the next chunk
+    if(!endOfData && pending < chunkSize) {
+      uint16_t provided = source->read((uint8_t*)recvBuffer + pending, chunkSize - pending);
+      endOfData = provided == 0;
+      pending += provided;
+    }
+
+    if(pending == 0) {
+      break;
+    }
+
+    // Send the chunk (the module could accept less than requested)
+    uint16_t toSend = pending < maxLength ? pending : maxLength;
+    sprintf_P(internalBuffer, PSTR("AT+FTPPUT=2,%u"), toSend);
+    sendCommand(internalBuffer);
+    uint16_t accepted = 0;
+    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_FTPPUT) || !parseFTPAnswer_P(AT_RSP_FTPPUT, &mode, &accepted, &maxLength) || mode != 2 || accepted > toSend) {
+      if(enableDebug) debugStream->println(F("SIM800L : ftpPut() - Unable to send data to module"));
+      return closeFTP(707);
+    }
+
+    stream->write((uint8_t*)recvBuffer, accepted);
+    stream->flush();
+    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+      if(enableDebug) debugStream->println(F("SIM800L : ftpPut() - Invalid end of data"));
+      return closeFTP(707);
+    }
+
+    lastTransferSize += accepted;
+    dataTransferred += accepted;
+    pending -= accepted;
+    memmove(recvBuffer, recvBuffer + accepted, pending);
+  }
+
+  // End of the data, the module closes the session (+FTPPUT: 1,0)
+  sendCommand_P(AT_CMD_FTPPUT20);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpPut() - Unable to end the upload"));
+    return closeFTP(707);
+  }
+
+  uint16_t mode = 0;
+  uint16_t status = 0;
+  uint16_t length = 0;
+  armTimeout(TIMEOUT_SERVER);
+  if(!readResponse(serverTimeoutMs) || !parseFTPAnswer_P(AT_RSP_FTPPUT, &mode, &status, &length)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpPut() - Server timeout"));
+    return closeFTP(408);
+  }
+
+  lastTransferDuration = millis() - timerStart;
+
+  if(enableDebug) {
+    debugStream->print(F("SIM800L : ftpPut() - End of transfer with status "));
+    debugStream->print(status);
+    debugStream->print(F(" ("));
+    debugStream->print(lastTransferSize);
+    debugStream->println(F(" bytes)"));
+  }
+
+  return status;
+}
+
+/**
+ * Create an empty file on the flash of the module (in C:\User\)
+ * Fails if the file already exists
+ */
+bool SIM800L::createFile(const char* filename) {
+  if(!prepareFileCommand(AT_CMD_FSCREATE, filename, 0)) {
+    if(enableDebug) debugStream->println(F("SIM800L : createFile() - File name too long"));
+    return false;
+  }
+
+  sendCommand(internalBuffer);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : createFile() - Unable to create the file"));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Append data at the end of a file of the module
+ * The data is written by chunks of SIM800L_FS_CHUNK_SIZE bytes, so records
+ * can be staged over time without keeping them in the RAM of the MCU
+ */
+bool SIM800L::appendFile(const char* filename, const uint8_t* data, uint16_t length) {
+  while(length > 0) {
+    uint16_t toWrite = length < SIM800L_FS_CHUNK_SIZE ? length : SIM800L_FS_CHUNK_SIZE;
+    if(!prepareFileCommand(AT_CMD_FSWRITE, filename, toWrite)) {
+      if(enableDebug) debugStream->println(F("SIM800L : appendFile() - File name too long"));
+      return false;
+    }
+
+    sendCommand(internalBuffer);
+    if(!waitPrompt(DEFAULT_TIMEOUT)) {
+      if(enableDebug) debugStream->println(F("SIM800L : appendFile() - Unable to write the file"));
+      return false;
+    }
+
+    stream->write(data, toWrite);
+    stream->flush();
+    if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+      if(enableDebug) debugStream->println(F("SIM800L : appendFile() - Invalid end of data"));
+      return false;
+    }
+
+    data += toWrite;
+    length -= toWrite;
+  }
+  return true;
+}
+
+/**
+ * Return the size of a file of the module in bytes (-1 if the file does not exist)
+ */
+int32_t SIM800L::getFileSize(const char* filename) {
+  if(!prepareFileCommand(AT_CMD_FSFLSIZE, filename, 0)) {
+    if(enableDebug) debugStream->println(F("SIM800L : getFileSize() - File name too long"));
+    return -1;
+  }
+
+  sendCommand(internalBuffer);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_FSFLSIZE)) {
+    if(enableDebug) debugStream->println(F("SIM800L : getFileSize() - Unable to get the size of the file"));
+    return -1;
+  }
+
+  return strtoul(strstr_P(internalBuffer, AT_RSP_FSFLSIZE) + strlen_P(AT_RSP_FSFLSIZE), NULL, 10);
+}
+
+/**
+ * Delete a file of the module
+ */
+bool SIM800L::deleteFile(const char* filename) {
+  if(!prepareFileCommand(AT_CMD_FSDEL, filename, 0)) {
+    if(enableDebug) debugStream->println(F("SIM800L : deleteFile() - File name too long"));
+    return false;
+  }
+
+  sendCommand(internalBuffer);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : deleteFile() - Unable to delete the file"));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Upload a file of the module to the FTP server in one session (setupFTP first)
+ * The module reads the file itself: nothing goes through the serial link
+ */
+uint16_t SIM800L::ftpPutFile(const char* path, const char* filename, const char* localFile, bool append, uint16_t serverTimeoutMs) {
+  if(!prepareFileCommand(AT_CMD_FTPPUTFRMFS, localFile, 0)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpPutFile() - File name too long"));
+    return 702;
+  }
+
+  // Define the file to upload (this overwrites the internal buffer, the command is prepared again below)
+  if(!defineFTPUpload(path, filename, append)) {
+    return 702;
+  }
+
+  lastTransferSize = 0;
+  lastTransferDuration = 0;
+  uint32_t timerStart = millis();
+
+  prepareFileCommand(AT_CMD_FTPPUTFRMFS, localFile, 0);
+  sendCommand(internalBuffer);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpPutFile() - Unable to open the FTP session"));
+    return 701;
+  }
+
+  // End of the upload (+FTPPUTFRMFS: 0,<total length>) or error (+FTPPUTFRMFS: <error>)
+  armTimeout(TIMEOUT_SERVER);
+  if(!readResponseCheckAnswer_P(serverTimeoutMs, AT_RSP_FTPPUTFRMFS)) {
+    if(enableDebug) debugStream->println(F("SIM800L : ftpPutFile() - Server timeout"));
+    return closeFTP(408);
+  }
+
+  char* next = strstr_P(internalBuffer, AT_RSP_FTPPUTFRMFS) + strlen_P(AT_RSP_FTPPUTFRMFS);
+  uint16_t status = strtoul(next, &next, 10);
+  if(*next == ',') {
+    lastTransferSize = strtoul(next + 1, NULL, 10);
+    dataTransferred += lastTransferSize;
+  }
+
+  lastTransferDuration = millis() - timerStart;
+
+  if(enableDebug) {
+    debugStream->print(F("SIM800L : ftpPutFile() - End of transfer with status "));
+    debugStream->print(status);
+    debugStream->print(F(" ("));
+    debugStream->print(lastTransferSize);
+    debugStream->println(F(" bytes)"));
+  }
+
+  return status;
+}
+
+/**
+ * Setup the SMS service: PDU mode, notification of the new messages (+CMTI) and capacity
+ * of the storage (+CPMS: <mem1>,<used1>,<total1>,...)
+ */
+bool SIM800L::setupSMS() {
+  sendCommand_P(AT_CMD_CMGF0);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    return false;
+  }
+
+  sendCommand_P(AT_CMD_CNMI);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    return false;
+  }
+
+  sendCommand_P(AT_CMD_CPMS_TEST);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_CPMS)) {
+    if(enableDebug) debugStream->println(F("SIM800L : setupSMS() - Unable to get the capacity of the storage"));
+    return false;
+  }
+  char* next = strchr(strstr_P(internalBuffer, AT_RSP_CPMS), ',');
+  if(next != NULL) {
+    next = strchr(next + 1, ',');
+  }
+  uint16_t capacity = next != NULL ? strtoul(next + 1, NULL, 10) : 0;
+  if(capacity == 0) {
+    if(enableDebug) debugStream->println(F("SIM800L : setupSMS() - Invalid capacity of the storage"));
+    return false;
+  }
+
+  // Track the messages delivered by index (from 1 to the capacity)
+  if(capacity != smsCapacity) {
+    free(smsDelivered);
+    smsDelivered = (uint8_t*) malloc(capacity / 8 + 1);
+    smsCapacity = smsDelivered != NULL ? capacity : 0;
+  }
+  return smsDelivered != NULL;
+}
+
+/**
+ * Send a text SMS (GSM 7 bits alphabet, unsupported characters are replaced by '?')
+ * Texts longer than 160 characters are sent in concatenated parts of 153 characters
+ */
+bool SIM800L::sendSMS(const char* number, const char* text) {
+  uint16_t length = strlen(text);
+  if(length <= 160) {
+    return sendSMSPart(number, (const uint8_t*)text, length, false, 0, 0);
+  }
+
+  uint16_t partCount = (length + 152) / 153;
+  if(partCount > 255) {
+    if(enableDebug) debugStream->println(F("SIM800L : sendSMS() - Text too long"));
+    return false;
+  }
+
+  smsReference++;
+  for(uint16_t part = 0; part < partCount; part++) {
+    uint16_t partLength = length - part * 153 < 153 ? length - part * 153 : 153;
+    if(!sendSMSPart(number, (const uint8_t*)text + part * 153, partLength, false, partCount, part + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Send a binary SMS (8 bits coding)
+ * Data longer than 140 bytes is sent in concatenated parts of 134 bytes
+ */
+bool SIM800L::sendBinarySMS(const char* number, const uint8_t* data, uint16_t length) {
+  if(length <= 140) {
+    return sendSMSPart(number, data, length, true, 0, 0);
+  }
+
+  uint16_t partCount = (length + 133) / 134;
+  if(partCount > 255) {
+    if(enableDebug) debugStream->println(F("SIM800L : sendBinarySMS() - Data too long"));
+    return false;
+  }
+
+  smsReference++;
+  for(uint16_t part = 0; part < partCount; part++) {
+    uint16_t partLength = length - part * 134 < 134 ? length - part * 134 : 134;
+    if(!sendSMSPart(number, data + part * 134, partLength, true, partCount, part + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Read all the SMS stored in one batch, the callback is called for each message
+ * The read messages can be deleted at the end of the batch
+ * Returns the number of messages read, -1 in case of error
+ */
+int16_t SIM800L::readAllSMS(SIM800LSMSCallback callback, void* context, bool deleteAfterRead) {
+  // Timeout is max 20 seconds according to SIM800 specifications
+  sendCommand_P(AT_CMD_CMGL4);
+  armTimeout(TIMEOUT_SMS);
+
+  if(smsDelivered != NULL) {
+    memset(smsDelivered, 0, smsCapacity / 8 + 1);
+  }
+
+  int16_t count = 0;
+  uint16_t invalid = 0;
+  while(1) {
+    // Read line by line (+CMGL: <index>,<stat>,[<alpha>],<length> followed by the PDU)
+    if(!readResponse(20000, 1)) {
+      if(enableDebug) debugStream->println(F("SIM800L : readAllSMS() - Unable to list the messages"));
+      return -1;
+    }
+
+    int16_t idx = strIndex(internalBuffer, "+CMGL:");
+    if(idx < 0) {
+      if(strIndex(internalBuffer, "ERROR") >= 0) {
+        if(enableDebug) debugStream->println(F("SIM800L : readAllSMS() - Unable to list the messages"));
+        return -1;
+      }
+      if(strIndex(internalBuffer, "OK") >= 0) {
+        break;
+      }
+      continue;
+    }
+
+    SIM800LSMS sms;
+    sms.index = strtoul(internalBuffer + idx + 6, NULL, 10);
+    uint16_t pduLength = readHexLine((uint8_t*)recvBuffer, recvBufferSize, DEFAULT_TIMEOUT);
+    if(pduLength == 0 || !decodeSMS(pduLength, &sms)) {
+      if(enableDebug) {
+        debugStream->print(F("SIM800L : readAllSMS() - Invalid message at index "));
+        debugStream->println(sms.index);
+      }
+      invalid++;
+      continue;
+    }
+
+    dataTransferred += sms.length;
+    callback(&sms, context);
+    count++;
+    if(smsDelivered != NULL && sms.index <= smsCapacity) {
+      smsDelivered[sms.index / 8] |= 1 << (sms.index % 8);
+    }
+  }
+
+  if(enableDebug) {
+    debugStream->print(F("SIM800L : readAllSMS() - Messages read: "));
+    debugStream->println(count);
+  }
+
+  if(!deleteAfterRead || count == 0) {
+    return count;
+  }
+
+  // The listing marks the messages as read: they are deleted in one command, the new messages
+  // received in the meantime are still unread and kept
+  if(invalid == 0) {
+    sendCommand_P(AT_CMD_CMGD_READ);
+    armTimeout(TIMEOUT_SMS);
+    // Timout is max 25 seconds according to SIM800 specifications
+    if(!readResponseCheckAnswer_P(25000, AT_RSP_OK)) {
+      if(enableDebug) debugStream->println(F("SIM800L : readAllSMS() - Unable to delete the messages"));
+      return -1;
+    }
+    return count;
+  }
+
+  // The messages which cannot be decoded are read as well, so they are kept by deleting
+  // only the messages given to the callback, one by one
+  if(smsDelivered == NULL) {
+    if(enableDebug) debugStream->println(F("SIM800L : readAllSMS() - Messages kept, call setupSMS() first"));
+    return count;
+  }
+  for(uint16_t index = 1; index <= smsCapacity; index++) {
+    if((smsDelivered[index / 8] & (1 << (index % 8))) && !deleteSMS(index)) {
+      if(enableDebug) debugStream->println(F("SIM800L : readAllSMS() - Unable to delete the messages"));
+      return -1;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * Check if a new SMS has been notified by the module (+CMTI URC)
+ * Returns the index of the new message, -1 if there is no new message
+ */
+int16_t SIM800L::checkNewSMS() {
+  if(!stream->available() || !readResponse(DEFAULT_TIMEOUT)) {
+    return -1;
+  }
+
+  int16_t idx = strIndex(internalBuffer, "+CMTI:");
+  if(idx < 0) {
+    return -1;
+  }
+
+  char* separator = strchr(internalBuffer + idx, ',');
+  if(separator == NULL) {
+    return -1;
+  }
+  return strtoul(separator + 1, NULL, 10);
+}
+
+/**
+ * Delete the SMS stored at a specific index
+ */
+bool SIM800L::deleteSMS(uint16_t index) {
+  sprintf_P(internalBuffer, PSTR("AT+CMGD=%u"), index);
+  sendCommand(internalBuffer);
+  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
+}
+
+/**
+ * Delete all the SMS stored
+ */
+bool SIM800L::deleteAllSMS() {
+  sendCommand_P(AT_CMD_CMGD_ALL);
+  armTimeout(TIMEOUT_SMS);
+  // Timout is max 25 seconds according to SIM800 specifications
+  return readResponseCheckAnswer_P(25000, AT_RSP_OK);
+}
+
+/**
+ * Enable the timeouts derived from the latency measured for each class of command
+ * (as long as enough answers have not been measured, the maximum timeout is used)
+ */
+void SIM800L::enableAdaptiveTimeouts(bool enable) {
+  adaptiveTimeouts = enable;
+}
+
+/**
+ * Force the timeout of a class of command in millisec (0 to go back to the default timeout)
+ */
+void SIM800L::setTimeoutOverride(TimeoutClass timeoutClass, uint16_t timeoutMs) {
+  if(timeoutClass < TIMEOUT_NONE) {
+    latency[timeoutClass].overrideMs = timeoutMs;
+  }
+}
+
+/**
+ * Return the average latency in millisec of a class of command
+ */
+uint32_t SIM800L::getAverageLatency(TimeoutClass timeoutClass) {
+  return timeoutClass < TIMEOUT_NONE ? latency[timeoutClass].average : 0;
+}
+
+/**
+ * Define the cache of the answers of doGet() (NULL to disable the cache)
+ * Returns false if the memory for the validators can't be allocated
+ */
+bool SIM800L::setResponseCache(SIM800LCache* cache) {
+  if(cache != NULL && cacheValidators == NULL) {
+    cacheValidators = (char*) malloc(2 * SIM800L_CACHE_VALIDATOR_SIZE);
+    if(cacheValidators == NULL) {
+      responseCache = NULL;
+      return false;
+    }
+  }
+  responseCache = cache;
+  return true;
+}
+
+/**
+ * Check if the answer of the last doGet() was served from the cache
+ */
+bool SIM800L::isAnswerFromCache() {
+  return answerFromCache;
+}
+
+/**
+ * Report the errors of the module with numeric codes (+CME ERROR: <err>) instead of ERROR
+ */
+bool SIM800L::enableExtendedErrors() {
+  sendCommand_P(AT_CMD_CMEE1);
+  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
+}
+
+/**
+ * Details of the last error of an HTTP call (stage STAGE_NONE if successful)
  */
-char* SIM800L::getVersion() {
-  sendCommand_P(AT_CMD_ATI);
-  if(readResponse(DEFAULT_TIMEOUT)) {
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "SIM");
-    int16_t idxEnd = strIndex(internalBuffer, "\r", idx+1);
+SIM800LError SIM800L::getLastError() {
+  return lastError;
+}
 
-    // Store it on the recv buffer (not used at the moment)
-    initRecvBuffer();
-    for(uint16_t i = 0; i < idxEnd - idx; i++) {
-      recvBuffer[i] = internalBuffer[idx + i];
-    }
-    return getDataReceived();
+/**
+ * Define the number of attempts of doGet()/doPost() on transient errors and the delay
+ * between the attempts (doubled after each retry up to the maximum delay)
+ */
+void SIM800L::setRetryPolicy(uint8_t maxAttempts, uint16_t initialDelayMs, uint16_t maxDelayMs) {
+  retryAttempts = maxAttempts > 0 ? maxAttempts : 1;
+  retryInitialDelay = initialDelayMs;
+  retryMaxDelay = maxDelayMs;
+}
+
+/**
+ * Define the sink receiving the body of the HTTP answers by chunks (NULL to keep
+ * the body in the reception buffer). With a sink, the size of the body is not limited
+ * by the reception buffer and getDataReceived() is empty
+ */
+void SIM800L::setResponseSink(SIM800LSink* sink) {
+  responseSink = sink;
+}
+
+/**
+ * Return the number of commands sent to the module since the last reset
+ */
+uint32_t SIM800L::getCommandCount() {
+  return commandCount;
+}
+
+/**
+ * Reset the number of commands sent to the module
+ */
+void SIM800L::resetCommandCount() {
+  commandCount = 0;
+}
+
+/**
+ * Return the size in bytes of the last streamed transfer
+ */
+uint32_t SIM800L::getLastTransferSize() {
+  return lastTransferSize;
+}
+
+/**
+ * Return the duration in millisec of the last streamed transfer
+ */
+uint32_t SIM800L::getLastTransferDuration() {
+  return lastTransferDuration;
+}
+
+/**
+ * Return the throughput in bytes per second of the last streamed transfer
+ */
+uint32_t SIM800L::getLastTransferThroughput() {
+  if(lastTransferDuration == 0) {
+    return 0;
+  }
+  return (uint64_t)lastTransferSize * 1000 / lastTransferDuration;
+}
+
+/**
+ * Define the power mode
+ * Available : MINIMUM, NORMAL, SLEEP
+ * Return true is the mode is correctly switched
+ */
+bool SIM800L::setPowerMode(PowerMode powerMode) {
+  // Check if the power mode requested is not ERROR or UNKNOWN
+  if(powerMode == POW_ERROR || powerMode == POW_UNKNOWN) {
+    return false;
+  }
+
+  // Check the current power mode (only once, the mode is kept after each switch)
+  if(currentPowerMode == POW_ERROR || currentPowerMode == POW_UNKNOWN) {
+    getPowerMode();
+  }
+
+  // If the current power mode is undefined, abord
+  if(currentPowerMode == POW_ERROR || currentPowerMode == POW_UNKNOWN) {
+    return false;
+  }
+
+  // If the current power mode is the same that the requested power mode, say it's OK
+  if(currentPowerMode == powerMode) {
+    return true;
+  }
+
+  // If SLEEP or MINIMUM, only NORMAL is allowed
+  if((currentPowerMode == SLEEP || currentPowerMode == MINIMUM) && (powerMode != NORMAL)) {
+    return false;
+  }
+
+  // Send the command
+  switch(powerMode) {
+    case MINIMUM :
+      sendCommand_P(AT_CMD_CFUN0);
+      break;
+    case SLEEP :
+      sendCommand_P(AT_CMD_CFUN4);
+      break;
+    case NORMAL :
+    default :
+      sendCommand_P(AT_CMD_CFUN1);
+  }
+
+  // Timeout is max 10 seconds according to SIM800 specifications
+  armTimeout(TIMEOUT_NETWORK);
+  if(!readResponseCheckAnswer_P(10000, AT_RSP_OK)) {
+    // The mode is not known anymore, it will be checked on the next call
+    currentPowerMode = POW_UNKNOWN;
+    return false;
+  }
+
+  currentPowerMode = powerMode;
+  return true;
+}
+
+/**
+ * Enable the sleep mode with the slow clock
+ * If the pin DTR is defined, the module sleeps when DTR is high (AT+CSCLK=1)
+ * Elsewhere, the module sleeps automatically when idle and is woken up by the serial line (AT+CSCLK=2)
+ */
+bool SIM800L::enableSleep(int8_t _pinDTR) {
+  pinDTR = _pinDTR;
+  if(pinDTR != DTR_PIN_NOT_USED) {
+    pinMode(pinDTR, OUTPUT);
+    digitalWrite(pinDTR, LOW);
+  }
+
+  sendCommand_P(pinDTR != DTR_PIN_NOT_USED ? AT_CMD_CSCLK1 : AT_CMD_CSCLK2);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : enableSleep() - Unable to enable the slow clock"));
+    return false;
+  }
+
+  slowClockMode = pinDTR != DTR_PIN_NOT_USED ? 1 : 2;
+  lastActivity = millis();
+  return true;
+}
+
+/**
+ * Disable the sleep mode (the module is woken up first)
+ */
+bool SIM800L::disableSleep() {
+  if(slowClockMode == 0) {
+    return true;
+  }
+
+  // The module is woken up by sendCommand
+  sendCommand_P(AT_CMD_CSCLK0);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : disableSleep() - Unable to disable the slow clock"));
+    return false;
+  }
+
+  slowClockMode = 0;
+  return true;
+}
+
+/**
+ * Let the module sleep until the next command
+ */
+void SIM800L::sleep() {
+  if(slowClockMode == 0 || sleeping) {
+    return;
+  }
+
+  if(slowClockMode == 1) {
+    digitalWrite(pinDTR, HIGH);
+  }
+
+  updatePowerStats();
+  sleeping = true;
+}
+
+/**
+ * Wake up the module with the minimum guard time
+ * DTR: the serial line is active 50ms after DTR low
+ * Serial line: the waking characters need 100ms to be discarded by the module
+ */
+void SIM800L::wakeUp() {
+  updatePowerStats();
+  if(!sleeping) {
+    return;
+  }
+
+  if(slowClockMode == 1) {
+    digitalWrite(pinDTR, LOW);
+    delay(50);
   } else {
-    return NULL;
+    stream->write("AT\r\n");
+    stream->flush();
+    delay(100);
   }
+
+  updatePowerStats();
+  sleeping = false;
+  lastActivity = millis();
 }
 
 /**
- * Status function: Get firmware version
+ * Return true if the module has been put to sleep or sleeps by itself (idle serial line)
  */
-char* SIM800L::getFirmware() {
-  sendCommand_P(AT_CMD_GMR);
+bool SIM800L::isSleeping() {
+  updatePowerStats();
+  return sleeping;
+}
+
+/**
+ * Define the average currents of the module in uA (awake and sleeping)
+ * to estimate the charge consumed
+ */
+void SIM800L::setPowerProfile(uint32_t _awakeCurrent, uint32_t _sleepCurrent) {
+  awakeCurrent = _awakeCurrent;
+  sleepCurrent = _sleepCurrent;
+}
+
+/**
+ * Return the time in millisec spent awake since the last reset of the statistics
+ */
+uint32_t SIM800L::getTimeAwake() {
+  updatePowerStats();
+  return timeAwake;
+}
+
+/**
+ * Return the time in millisec spent sleeping since the last reset of the statistics
+ */
+uint32_t SIM800L::getTimeSleeping() {
+  updatePowerStats();
+  return timeSleeping;
+}
+
+/**
+ * Return the number of bytes of data sent and received (payloads, transfers and SMS)
+ * since the last reset of the statistics
+ */
+uint32_t SIM800L::getDataTransferred() {
+  return dataTransferred;
+}
+
+/**
+ * Return the estimated charge consumed in uAh since the last reset of the statistics
+ * (divided by getDataTransferred(), it gives the cost of each byte transmitted)
+ */
+uint32_t SIM800L::getEstimatedCharge() {
+  updatePowerStats();
+  return ((uint64_t)timeAwake * awakeCurrent + (uint64_t)timeSleeping * sleepCurrent) / 3600000UL;
+}
+
+/**
+ * Reset the energy accounting
+ */
+void SIM800L::resetPowerStats() {
+  timeAwake = 0;
+  timeSleeping = 0;
+  dataTransferred = 0;
+  lastPowerStateChange = millis();
+}
+
+/**
+ * Status function: Check the strengh of the signal
+ */
+uint8_t SIM800L::getSignal() {
+  sendCommand_P(AT_CMD_CSQ);
   if(readResponse(DEFAULT_TIMEOUT)) {
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "AT+GMR") + 9;
-    int16_t idxEnd = strIndex(internalBuffer, "\r", idx+1);
+    // Extract the value (+CSQ: <rssi>,<ber>), with or without echo
+    int16_t idx = strIndex(internalBuffer, "+CSQ: ");
+    if(idx < 0) {
+      return 0;
+    }
+    char* end = NULL;
+    uint32_t value = strtoul(internalBuffer + idx + 6, &end, 10);
+    if(*end != ',' || value > 31) {
+      return 0;
+    }
+    return value;
+  }
+  return 0;
+}
+
+/*****************************************************************************************
+ * HELPERS
+ *****************************************************************************************/
+/**
+ * Read up to length bytes from the module (by spans of the ring buffer if defined)
+ * Returns the number of bytes read before the timeout of the stream
+ */
+size_t SIM800L::readData(char* buffer, size_t length) {
+  if(ring != NULL) {
+    return ring->read((uint8_t*)buffer, length, SIM800L_READ_TIMEOUT);
+  }
+  return stream->readBytes(buffer, length);
+}
+
+/**
+ * Find string "findStr" in another string "str" (from startIdx)
+ * Returns the index if found, -1 elsewhere
+ */
+int16_t SIM800L::strIndex(const char* str, const char* findStr, uint16_t startIdx) {
+  if(startIdx > strlen(str)) {
+    return -1;
+  }
+
+  const char* found = strstr(str + startIdx, findStr);
+  if(found == NULL) {
+    return -1;
+  }
+  return found - str;
+}
+
+/**
+ * Return the index of the answer in the internal buffer, after the echo
+ * of the command if the echo mode is enabled
+ */
+int16_t SIM800L::skipEcho(const char* command) {
+  int16_t idx = strIndex(internalBuffer, command);
+  idx = idx < 0 ? 0 : idx + strlen(command);
+  while(internalBuffer[idx] == '\r' || internalBuffer[idx] == '\n') {
+    idx++;
+  }
+  return idx;
+}
+
+/**
+ * Copy the value located at idx in the internal buffer to the reception buffer,
+ * until the end character (or the end of the line). Returns NULL if idx is invalid
+ */
+char* SIM800L::extractValue(int16_t idx, char endChar) {
+  if(idx < 0 || idx > (int16_t)strlen(internalBuffer)) {
+    return NULL;
+  }
+
+  initRecvBuffer();
+  uint16_t i = 0;
+  for(const char* c = internalBuffer + idx; *c != '\0' && *c != endChar && *c != '\r' && i < recvBufferSize - 1; c++) {
+    recvBuffer[i++] = *c;
+  }
+  return getDataReceived();
+}
+
+/**
+ * Extract the values of an FTP answer (+FTPxxx: <mode>,<status>[,<length>])
+ * (answer stored in flash) from the internal buffer. Returns false if the answer is not found
+ */
+bool SIM800L::parseFTPAnswer_P(const char* answer, uint16_t* mode, uint16_t* status, uint16_t* length) {
+  char* next = strstr_P(internalBuffer, answer);
+  if(next == NULL) {
+    return false;
+  }
+
+  next += strlen_P(answer);
+  *mode = strtoul(next, &next, 10);
+  if(*next != ',') {
+    return false;
+  }
+  *status = strtoul(next + 1, &next, 10);
+  *length = 0;
+  if(*next == ',') {
+    *length = strtoul(next + 1, NULL, 10);
+  }
+  return true;
+}
+
+/**
+ * Quit the current FTP session after an error and return the error code
+ */
+uint16_t SIM800L::closeFTP(uint16_t errorCode) {
+  sendCommand_P(AT_CMD_FTPQUIT);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : closeFTP() - Unable to quit the FTP session"));
+  }
+  return errorCode;
+}
+
+/**
+ * Define the name, the path and the type of the next FTP upload
+ */
+bool SIM800L::defineFTPUpload(const char* path, const char* filename, bool append) {
+  sendCommand_P(AT_CMD_FTPPUTNAME, filename);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : defineFTPUpload() - Unable to define the file name"));
+    return false;
+  }
+
+  sendCommand_P(AT_CMD_FTPPUTPATH, path);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : defineFTPUpload() - Unable to define the path"));
+    return false;
+  }
+
+  sendCommand_P(append ? AT_CMD_FTPPUTOPT_APPE : AT_CMD_FTPPUTOPT_STOR);
+  if(!readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK)) {
+    if(enableDebug) debugStream->println(F("SIM800L : defineFTPUpload() - Unable to define the upload type"));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Prepare a file command of the module in the internal buffer
+ * The format takes the file name, then optionally the length and the input time of FSWRITE
+ */
+bool SIM800L::prepareFileCommand(const char* format, const char* filename, uint16_t length) {
+  // Room for the numbers of FSWRITE and the NUL
+  if(strlen_P(format) + strlen(filename) + 10 > internalBufferSize) {
+    return false;
+  }
+  sprintf_P(internalBuffer, format, filename, length, SIM800L_FS_INPUT_TIME);
+  return true;
+}
+
+/**
+ * Send one part of an SMS (SMS-SUBMIT PDU), partCount is 0 for a single message
+ * Text is packed in GSM 7 bits alphabet, binary data is sent with 8 bits coding
+ */
+bool SIM800L::sendSMSPart(const char* number, const uint8_t* data, uint8_t length, bool binary, uint8_t partCount, uint8_t partNumber) {
+  // Keep only the digits of the phone number
+  bool international = *number == '+';
+  if(international) {
+    number++;
+  }
+  uint8_t digits = strlen(number);
+  if(digits == 0 || digits > 20 || strspn(number, "0123456789") != digits) {
+    if(enableDebug) debugStream->println(F("SIM800L : sendSMSPart() - Invalid phone number"));
+    return false;
+  }
+
+  // Size of the user data: in septets for a text, in bytes for binary data
+  // (the header of the concatenated messages takes 6 bytes, 7 septets with the fill bit)
+  bool concatenated = partCount > 0;
+  uint8_t dataLength = 0;
+  uint8_t userDataLength = 0;
+  if(binary) {
+    dataLength = (concatenated ? 6 : 0) + length;
+    userDataLength = dataLength;
+  } else {
+    dataLength = (concatenated ? 7 : 0) + length;
+    userDataLength = (dataLength * 7 + 7) / 8;
+  }
+
+  // Size of the TPDU (without the service center address)
+  uint8_t tpduLength = 7 + (digits + 1) / 2 + userDataLength;
+  sprintf_P(internalBuffer, PSTR("AT+CMGS=%u"), tpduLength);
+  sendCommand(internalBuffer);
+  if(!waitPrompt(DEFAULT_TIMEOUT)) {
+    if(enableDebug) debugStream->println(F("SIM800L : sendSMSPart() - Unable to send the message to module"));
+    return false;
+  }
+
+  // Default service center, SMS-SUBMIT (with user data header if concatenated), message reference by the module
+  writeHex(0x00);
+  writeHex(concatenated ? 0x41 : 0x01);
+  writeHex(0x00);
+
+  // Destination address (international or unknown format, swapped digits)
+  writeHex(digits);
+  writeHex(international ? 0x91 : 0x81);
+  for(uint8_t i = 0; i < digits; i += 2) {
+    uint8_t high = i + 1 < digits ? number[i + 1] - '0' : 0x0F;
+    writeHex((high << 4) | (number[i] - '0'));
+  }
+
+  // Protocol identifier, data coding scheme and user data length
+  writeHex(0x00);
+  writeHex(binary ? 0x04 : 0x00);
+  writeHex(dataLength);
+
+  // Header of the concatenated messages
+  if(concatenated) {
+    writeHex(0x05);
+    writeHex(0x00);
+    writeHex(0x03);
+    writeHex(smsReference);
+    writeHex(partCount);
+    writeHex(partNumber);
+  }
 
-    // Store it on the recv buffer (not used at the moment)
-    initRecvBuffer();
-    for(uint16_t i = 0; i < idxEnd - idx; i++) {
-      recvBuffer[i] = internalBuffer[idx + i];
+  // User data
+  if(binary) {
+    for(uint8_t i = 0; i < length; i++) {
+      writeHex(data[i]);
     }
-    return getDataReceived();
   } else {
-    return NULL;
+    // Pack the septets (the header is followed by a fill bit to align the text on a septet)
+    uint16_t bits = 0;
+    uint8_t bitCount = concatenated ? 1 : 0;
+    for(uint8_t i = 0; i < length; i++) {
+      bits |= (uint16_t)toGSM7(data[i]) << bitCount;
+      bitCount += 7;
+      while(bitCount >= 8) {
+        writeHex(bits & 0xFF);
+        bits >>= 8;
+        bitCount -= 8;
+      }
+    }
+    if(bitCount > 0) {
+      writeHex(bits & 0xFF);
+    }
   }
-}
 
-/**
- * Status function: Requests the simcard number
- */
-char* SIM800L::getSimCardNumber() {
-  sendCommand_P(AT_CMD_SIM_CARD);
-  if(readResponse(DEFAULT_TIMEOUT)) {
-    int16_t idx = strIndex(internalBuffer, "AT+CCID") + 10;
-    int16_t idxEnd = strIndex(internalBuffer, "\r", idx+1);
+  // End of the message
+  stream->write(0x1A);
+  stream->flush();
 
-    // Store it on the recv buffer (not used at the moment)
-    initRecvBuffer();
-    for(uint16_t i = 0; i < idxEnd - idx; i++) {
-      recvBuffer[i] = internalBuffer[idx + i];
-    }
-    return getDataReceived();
-  } else {
-    return NULL;
+  // Timeout is max 60 seconds according to SIM800 specifications
+  armTimeout(TIMEOUT_SMS);
+  if(!readResponseCheckAnswer_P(60000, AT_RSP_CMGS)) {
+    if(enableDebug) debugStream->println(F("SIM800L : sendSMSPart() - Message not sent"));
+    return false;
   }
+  dataTransferred += length;
+  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
 }
 
 /**
- * Status function: Request the status of the SIM card
+ * Decode an SMS-DELIVER PDU located in the reception buffer
+ * The content is decoded in place, the text is NUL terminated
  */
-char* SIM800L::getSimStatus() {
-  sendCommand_P(AT_CMD_CPIN_TEST);
-  if(readResponse(DEFAULT_TIMEOUT)) {
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "+CPIN:");
-    if(idx > 0) {
-      idx = idx + 7;
-    } else {
-      return "ERROR";
-    }
-    int16_t idxEnd = strIndex(internalBuffer, "\r", idx+1);
+bool SIM800L::decodeSMS(uint16_t pduLength, SIM800LSMS* sms) {
+  uint8_t* pdu = (uint8_t*)recvBuffer;
 
-    // Store it on the recv buffer (not used at the moment)
-    initRecvBuffer();
-    for(uint16_t i = 0; i < idxEnd - idx; i++) {
-      recvBuffer[i] = internalBuffer[idx + i];
+  // Skip the service center address
+  uint16_t pos = 1 + pdu[0];
+  if(pos + 2 > pduLength) {
+    return false;
+  }
+
+  // Only SMS-DELIVER are supported
+  uint8_t firstOctet = pdu[pos++];
+  if((firstOctet & 0x03) != 0x00) {
+    return false;
+  }
+  bool hasHeader = firstOctet & 0x40;
+
+  // Originating address (phone number or alphanumeric)
+  uint8_t addressLength = pdu[pos++];
+  if(addressLength > 20 || pos + 1 + (addressLength + 1) / 2 + 10 > pduLength) {
+    return false;
+  }
+  uint8_t addressType = pdu[pos++];
+  if((addressType & 0x70) == 0x50) {
+    uint8_t count = addressLength * 4 / 7;
+    unpackSeptets(pdu + pos, (uint8_t*)sms->sender, count);
+    for(uint8_t i = 0; i < count; i++) {
+      sms->sender[i] = fromGSM7(sms->sender[i]);
     }
-    return getDataReceived();
+    sms->sender[count] = '\0';
   } else {
-    return "ERROR";
+    uint8_t count = 0;
+    if(addressType == 0x91) {
+      sms->sender[count++] = '+';
+    }
+    for(uint8_t i = 0; i < addressLength; i++) {
+      uint8_t digit = (i % 2 == 0) ? pdu[pos + i / 2] & 0x0F : pdu[pos + i / 2] >> 4;
+      sms->sender[count++] = digit < 10 ? '0' + digit : '?';
+    }
+    sms->sender[count] = '\0';
+  }
+  pos += (addressLength + 1) / 2;
+
+  // Data coding scheme (7 bits, 8 bits or UCS2)
+  pos++;
+  uint8_t dataCoding = pdu[pos++];
+  uint8_t alphabet = 0;
+  if((dataCoding & 0xC0) == 0x00) {
+    alphabet = (dataCoding >> 2) & 0x03;
+  } else if((dataCoding & 0xF0) == 0xF0) {
+    alphabet = (dataCoding >> 2) & 0x01;
+  } else if((dataCoding & 0xF0) == 0xE0) {
+    alphabet = 2;
   }
-}
 
-/**
- * Status function: Requests the IP of the GPRS connection
- */
-char* SIM800L::getIP() {
-  sendCommand_P(AT_CMD_SAPBR2);
-  if(readResponse(DEFAULT_TIMEOUT)) {
-    int16_t idx = strIndex(internalBuffer, "+SAPBR: 1,1");
-    if(idx > 0) {
-      idx = idx + 13;
-    } else {
-      return "Not connected";
+  // Time stamp of the service center (swapped digits, the time zone is ignored)
+  char* ts = sms->timestamp;
+  for(uint8_t i = 0; i < 6; i++) {
+    uint8_t value = pdu[pos + i];
+    *ts++ = '0' + (value & 0x0F);
+    *ts++ = '0' + (value >> 4);
+    *ts++ = i < 2 ? '/' : (i == 2 ? ',' : ':');
+  }
+  sms->timestamp[17] = '\0';
+  pos += 7;
+
+  // User data
+  uint8_t userDataLength = pdu[pos++];
+  uint8_t* userData = pdu + pos;
+  uint16_t size = alphabet == 0 ? (userDataLength * 7 + 7) / 8 : userDataLength;
+  if(pos + size > pduLength || pos + userDataLength >= recvBufferSize) {
+    return false;
+  }
+
+  // Header of the user data (information of the concatenated messages)
+  sms->partReference = 0;
+  sms->partCount = 0;
+  sms->partNumber = 0;
+  uint8_t headerLength = 0;
+  if(hasHeader) {
+    headerLength = userData[0] + 1;
+    if(headerLength > size) {
+      return false;
+    }
+    for(uint8_t i = 1; i + 1 < headerLength; i += 2 + userData[i + 1]) {
+      uint8_t* element = userData + i;
+      if(i + 2 + element[1] > headerLength) {
+        break;
+      }
+      if(element[0] == 0x00 && element[1] == 3) {
+        sms->partReference = element[2];
+        sms->partCount = element[3];
+        sms->partNumber = element[4];
+      } else if(element[0] == 0x08 && element[1] == 4) {
+        sms->partReference = element[3];
+        sms->partCount = element[4];
+        sms->partNumber = element[5];
+      }
     }
-    int16_t idxEnd = strIndex(internalBuffer, "\"", idx+1);
+  }
 
-    // Store it on the recv buffer (not used at the moment)
-    initRecvBuffer();
-    for(uint16_t i = 0; i < idxEnd - idx; i++) {
-      recvBuffer[i] = internalBuffer[idx + i];
+  if(alphabet == 0) {
+    // Unpack the septets in place, the text starts at the septet following the header
+    unpackSeptets(userData, userData, userDataLength);
+    uint8_t skip = (headerLength * 8 + 6) / 7;
+    if(skip > userDataLength) {
+      return false;
     }
-    return getDataReceived();
+    for(uint8_t i = skip; i < userDataLength; i++) {
+      userData[i] = fromGSM7(userData[i]);
+    }
+    userData[userDataLength] = '\0';
+    sms->data = userData + skip;
+    sms->length = userDataLength - skip;
+    sms->binary = false;
   } else {
-    return "Not connected";
+    sms->data = userData + headerLength;
+    sms->length = userDataLength - headerLength;
+    sms->binary = true;
   }
+
+  return true;
 }
 
 /**
- * Status function: Check if the module is registered on the network
+ * Unpack GSM 7 bits septets, from the last one to the first one to allow
+ * the unpacking in place (dst == src)
  */
-NetworkRegistration SIM800L::getRegistrationStatus() {
-  sendCommand_P(AT_CMD_CREG_TEST);
-  if(readResponse(DEFAULT_TIMEOUT)) {
-    // Check if there is an error
-    int16_t errIdx = strIndex(internalBuffer, "ERROR");
-    if(errIdx > 0) {
-      return NET_ERROR;
-    }
-
-    // Extract the value
-    int16_t idx = strIndex(internalBuffer, "+CREG: ");
-    char value = internalBuffer[idx + 9];
-
-    // Prepare the clear output
-    switch(value) {
-      case '0' : return NOT_REGISTERED;
-      case '1' : return REGISTERED_HOME;
-      case '2' : return SEARCHING;
-      case '3' : return DENIED;
-      case '5' : return REGISTERED_ROAMING;
-      default  : return NET_UNKNOWN;
+void SIM800L::unpackSeptets(const uint8_t* src, uint8_t* dst, uint16_t count) {
+  for(int16_t i = count - 1; i >= 0; i--) {
+    uint16_t bit = i * 7;
+    uint8_t shift = bit % 8;
+    uint8_t value = src[bit / 8] >> shift;
+    if(shift > 1) {
+      value |= src[bit / 8 + 1] << (8 - shift);
     }
+    dst[i] = value & 0x7F;
   }
-
-  return NET_ERROR;
 }
 
 /**
- * Define PIN code to activate SIM card
+ * Convert an ASCII character to the GSM 7 bits default alphabet ('?' if not available)
  */
-bool SIM800L::setPinCode(const char *pin) {
-  // Set the PIN code to activate the SIM card
-  sendCommand_P(AT_CMD_CPIN_PIN, pin);
-  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_OK);
+uint8_t SIM800L::toGSM7(char c) {
+  if(c == '@') {
+    return 0x00;
+  } else if(c == '$') {
+    return 0x02;
+  } else if(c == '_') {
+    return 0x11;
+  } else if(c == '\n' || c == '\r' || (c >= ' ' && c <= '#') || (c >= '%' && c <= '?') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+    return c;
+  }
+  return '?';
 }
 
 /**
- * Setup the GPRS connectivity
- * As input, give the APN string of the operator
+ * Convert a character of the GSM 7 bits default alphabet to ASCII ('?' if not available)
  */
-bool SIM800L::setupGPRS(const char* apn) {
-  // Prepare the GPRS connection as the bearer
-  sendCommand_P(AT_CMD_SAPBR_GPRS);
-  if(!readResponseCheckAnswer_P(20000, AT_RSP_OK)) {
-    return false;
+char SIM800L::fromGSM7(uint8_t c) {
+  if(c == 0x00) {
+    return '@';
+  } else if(c == 0x02) {
+    return '$';
+  } else if(c == 0x11) {
+    return '_';
   }
-
-  // Set the config of the bearer with the APN
-  sendCommand_P(AT_CMD_SAPBR_APN, apn);
-  return readResponseCheckAnswer_P(20000, AT_RSP_OK);
+  return toGSM7(c) == c ? c : '?';
 }
 
 /**
- * Setup the GPRS connectivity with user and password
- * As input, give the APN string of the operator, the user and the password
+ * Read a line of hexadecimal digits from the module and decode it in the buffer
+ * Returns the number of bytes decoded, 0 if the line is invalid or too long
  */
-bool SIM800L::setupGPRS(const char* apn, const char* user, const char* password) {
-  // Prepare the GPRS connection as the bearer
-  sendCommand_P(AT_CMD_SAPBR_GPRS);
-  if(!readResponseCheckAnswer_P(20000, AT_RSP_OK)) {
-    return false;
-  }
+uint16_t SIM800L::readHexLine(uint8_t* buffer, uint16_t maxLength, uint16_t timeout) {
+  uint16_t length = 0;
+  uint8_t nibbles = 0;
+  bool valid = true;
 
-  // Set the config of the bearer with the APN
-  sendCommand_P(AT_CMD_SAPBR_APN, apn);
-  if(!readResponseCheckAnswer_P(20000, AT_RSP_OK)) {
-    return false;
-  }
+  uint32_t timerStart = millis();
 
-  // Set the config of the bearer with the USER
-  sendCommand_P(AT_CMD_SAPBR_USER, user);
-  if(!readResponseCheckAnswer_P(20000, AT_RSP_OK)) {
-    return false;
+  while(1) {
+    if(stream->available()) {
+      char c = stream->read();
+      if(c == '\n') {
+        break;
+      }
+
+      uint8_t value = 0;
+      if(c >= '0' && c <= '9') {
+        value = c - '0';
+      } else if(c >= 'A' && c <= 'F') {
+        value = c - 'A' + 10;
+      } else if(c >= 'a' && c <= 'f') {
+        value = c - 'a' + 10;
+      } else {
+        // Ignore the end of line, any other character invalidates the line
+        valid = valid && c == '\r';
+        continue;
+      }
+
+      if(length >= maxLength) {
+        valid = false;
+      } else if(nibbles++ % 2 == 0) {
+        buffer[length] = value << 4;
+      } else {
+        buffer[length++] |= value;
+      }
+    }
+
+    // If timeout, abord the reading
+    if(millis() - timerStart > timeout) {
+      if(enableDebug) debugStream->println(F("SIM800L : readHexLine() - Receive timeout"));
+      return 0;
+    }
   }
 
-  // Set the config of the bearer with the PWD
-  sendCommand_P(AT_CMD_SAPBR_PWD, password);
-  return readResponseCheckAnswer_P(20000, AT_RSP_OK);
+  return valid && nibbles % 2 == 0 ? length : 0;
 }
 
 /**
- * Open the GPRS connectivity
+ * Wait for the prompt of the module ("> ") to send data
  */
-bool SIM800L::connectGPRS() {
-  sendCommand_P(AT_CMD_SAPBR1);
-  // Timout is max 85 seconds according to SIM800 specifications
-  // We will wait for 65s to be within uint16_t
-  return readResponseCheckAnswer_P(65000, AT_RSP_OK);
+bool SIM800L::waitPrompt(uint16_t timeout) {
+  uint32_t timerStart = millis();
+  while(millis() - timerStart <= timeout) {
+    if(stream->available() && stream->read() == '>') {
+      return true;
+    }
+  }
+  return false;
 }
 
 /**
- * Check if GPRS is connected
+ * Write a byte to the module in hexadecimal (2 digits)
  */
-bool SIM800L::isConnectedGPRS() {
-  sendCommand_P(AT_CMD_SAPBR2);
-  return readResponseCheckAnswer_P(DEFAULT_TIMEOUT, AT_RSP_SAPBR);
+void SIM800L::writeHex(uint8_t value) {
+  const char digits[] = "0123456789ABCDEF";
+  stream->write(digits[value >> 4]);
+  stream->write(digits[value & 0x0F]);
 }
 
 /**
- * Close the GPRS connectivity
+ * Arm the measure of the latency of the next answer for a class of command
  */
-bool SIM800L::disconnectGPRS() {
-  sendCommand_P(AT_CMD_SAPBR0);
-  // Timout is max 65 seconds according to SIM800 specifications
-  return readResponseCheckAnswer_P(65000, AT_RSP_OK);
+void SIM800L::armTimeout(TimeoutClass timeoutClass) {
+  armedTimeoutClass = timeoutClass;
+  armedTimeoutStart = millis();
 }
 
 /**
- * Define the power mode
- * Available : MINIMUM, NORMAL, SLEEP
- * Return true is the mode is correctly switched
+ * Derive the timeout of a class of command like the retransmission timeout of TCP
+ * (average + 4 x variation, doubled after each timeout), clamped to the maximum timeout
  */
-bool SIM800L::setPowerMode(PowerMode powerMode) {
-  // Check if the power mode requested is not ERROR or UNKNOWN
-  if(powerMode == POW_ERROR || powerMode == POW_UNKNOWN) {
-    return false;
-  }
-
-  // Check the current power mode
-  PowerMode currentPowerMode = getPowerMode();
-
-  // If the current power mode is undefined, abord
-  if(currentPowerMode == POW_ERROR || currentPowerMode == POW_UNKNOWN) {
-    return false;
+uint16_t SIM800L::computeTimeout(TimeoutClass timeoutClass, uint16_t maxTimeout) {
+  SIM800LLatency* stats = &latency[timeoutClass];
+  if(stats->overrideMs > 0) {
+    return stats->overrideMs;
   }
-
-  // If the current power mode is the same that the requested power mode, say it's OK
-  if(currentPowerMode == powerMode) {
-    return true;
+  if(!adaptiveTimeouts || stats->samples < SIM800L_TIMEOUT_MIN_SAMPLES) {
+    return maxTimeout;
   }
 
-  // If SLEEP or MINIMUM, only NORMAL is allowed
-  if((currentPowerMode == SLEEP || currentPowerMode == MINIMUM) && (powerMode != NORMAL)) {
-    return false;
+  uint32_t timeout = (stats->average + 4 * stats->variation) << stats->backoff;
+  if(timeout < SIM800L_TIMEOUT_MIN) {
+    timeout = SIM800L_TIMEOUT_MIN;
   }
-
-  // Send the command
-  char value;
-  switch(powerMode) {
-    case MINIMUM :
-      sendCommand_P(AT_CMD_CFUN0);
-      break;
-    case SLEEP :
-      sendCommand_P(AT_CMD_CFUN4);
-      break;
-    case NORMAL :
-    default :
-      sendCommand_P(AT_CMD_CFUN1);
+  if(timeout > maxTimeout) {
+    timeout = maxTimeout;
   }
-
-  // Read but don't care about the result
-  purgeSerial();
-
-  // Check the current power mode
-  currentPowerMode = getPowerMode();
-
-  // If the current power mode is the same that the requested power mode, say it's OK
-  return currentPowerMode == powerMode;
+  return timeout;
 }
 
 /**
- * Status function: Check the strengh of the signal
+ * Update the latency of a class of command with a new measure (EWMA of the latency and of its variation)
  */
-uint8_t SIM800L::getSignal() {
-  sendCommand_P(AT_CMD_CSQ);
-  if(readResponse(DEFAULT_TIMEOUT)) {
-    int16_t idxBase = strIndex(internalBuffer, "AT+CSQ");
-    if(idxBase != 0) {
-      return 0;
-    }
-    int16_t idxEnd = strIndex(internalBuffer, ",", idxBase);
-    uint8_t value = internalBuffer[idxEnd - 1] - '0';
-    if(internalBuffer[idxEnd - 2] != ' ') {
-      value += (internalBuffer[idxEnd - 2] - '0') * 10;
-    }
-    if(value > 31) {
-      return 0;
+void SIM800L::recordLatency(TimeoutClass timeoutClass, uint32_t latencyMs, bool answered) {
+  SIM800LLatency* stats = &latency[timeoutClass];
+
+  // No answer, back off until the next answer
+  if(!answered) {
+    if(stats->backoff < 4) {
+      stats->backoff++;
     }
-    return value;
+    return;
+  }
+  stats->backoff = 0;
+
+  if(stats->samples == 0) {
+    stats->average = latencyMs;
+    stats->variation = latencyMs / 2;
+  } else {
+    uint32_t delta = latencyMs > stats->average ? latencyMs - stats->average : stats->average - latencyMs;
+    stats->variation = (3 * stats->variation + delta) / 4;
+    stats->average = (7 * stats->average + latencyMs) / 8;
+  }
+  if(stats->samples < 0xFFFF) {
+    stats->samples++;
   }
-  return 0;
 }
 
-/*****************************************************************************************
- * HELPERS
- *****************************************************************************************/
 /**
- * Find string "findStr" in another string "str"
- * Returns true if found, false elsewhere
+ * Add the time elapsed since the last change to the current power state
  */
-int16_t SIM800L::strIndex(const char* str, const char* findStr, uint16_t startIdx) {
-  int16_t firstIndex = -1;
-  int16_t sizeMatch = 0;
-  for(int16_t i = startIdx; i < strlen(str); i++) {
-    if(sizeMatch >= strlen(findStr)) {
-      break;
-    }
-    if(str[i] == findStr[sizeMatch]) {
-      if(firstIndex < 0) {
-        firstIndex = i;
-      }
-      sizeMatch++;
-    } else {
-      firstIndex = -1;
-      sizeMatch = 0;
+void SIM800L::updatePowerStats() {
+  uint32_t now = millis();
+
+  // With the automatic slow clock, the module fell asleep once the serial line was idle
+  if(!sleeping && slowClockMode == 2 && now - lastActivity >= SIM800L_SLEEP_IDLE_DELAY) {
+    uint32_t asleepSince = lastActivity + SIM800L_SLEEP_IDLE_DELAY;
+    if((int32_t)(asleepSince - lastPowerStateChange) > 0) {
+      timeAwake += asleepSince - lastPowerStateChange;
+      lastPowerStateChange = asleepSince;
     }
+    sleeping = true;
   }
 
-  if(sizeMatch >= strlen(findStr)) {
-    return firstIndex;
+  if(sleeping) {
+    timeSleeping += now - lastPowerStateChange;
   } else {
-    return -1;
+    timeAwake += now - lastPowerStateChange;
+  }
+  lastPowerStateChange = now;
+}
+
+/**
+ * Update a CRC32 (IEEE 802.3) with a new chunk of data
+ * Bitwise computation to avoid a lookup table in memory
+ */
+uint32_t SIM800L::updateCRC32(uint32_t crc, const uint8_t* data, uint16_t length) {
+  crc = ~crc;
+  for(uint16_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for(uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+    }
   }
+  return ~crc;
 }
 
 /**
@@ -819,56 +3412,86 @@ void SIM800L::initRecvBuffer() {
  * Send AT command to the module
  */
 void SIM800L::sendCommand(const char* command) {
-  if(enableDebug) {
-    debugStream->print(F("SIM800L : Send \""));
-    debugStream->print(command);
-    debugStream->println(F("\""));
-  }
-
-  purgeSerial();
-  stream->write(command);
-  stream->write("\r\n");
-  purgeSerial();
+  sendCommand(command, false, NULL, false);
 }
 
 /**
  * Send AT command coming from the PROGMEM
  */
 void SIM800L::sendCommand_P(const char* command) {
-  char cmdBuff[32];
-  strcpy_P(cmdBuff, command);
-  sendCommand(cmdBuff);
+  sendCommand(command, true, NULL, false);
 }
 
 /**
  * Send AT command to the module with a parameter
  */
 void SIM800L::sendCommand(const char* command, const char* parameter) {
+  sendCommand(command, false, parameter, false);
+}
+
+/**
+ * Send AT command coming from the PROGMEM with a parameter (in RAM or in PROGMEM)
+ */
+void SIM800L::sendCommand_P(const char* command, const char* parameter, bool parameterInFlash) {
+  sendCommand(command, true, parameter, parameterInFlash);
+}
+
+/**
+ * Send AT command to the module with an optional parameter within quotes
+ * The strings in PROGMEM are streamed directly from the flash
+ */
+void SIM800L::sendCommand(const char* command, bool commandInFlash, const char* parameter, bool parameterInFlash) {
+  wakeUp();
+  commandCount++;
+  armTimeout(TIMEOUT_COMMAND);
+
   if(enableDebug) {
     debugStream->print(F("SIM800L : Send \""));
-    debugStream->print(command);
-    debugStream->print(F("\""));
-    debugStream->print(parameter);
-    debugStream->print(F("\""));
+    printString(command, commandInFlash);
+    if(parameter != NULL) {
+      debugStream->print(F("\""));
+      printString(parameter, parameterInFlash);
+      debugStream->print(F("\""));
+    }
     debugStream->println(F("\""));
   }
 
   purgeSerial();
-  stream->write(command);
-  stream->write("\"");
-  stream->write(parameter);
-  stream->write("\"");
+  writeString(command, commandInFlash);
+  if(parameter != NULL) {
+    stream->write("\"");
+    writeString(parameter, parameterInFlash);
+    stream->write("\"");
+  }
   stream->write("\r\n");
   purgeSerial();
+  lastActivity = millis();
 }
 
 /**
- * Send AT command coming from the PROGMEM with a parameter
+ * Write a string to the module (from the RAM or the PROGMEM)
  */
-void SIM800L::sendCommand_P(const char* command, const char* parameter) {
-  char cmdBuff[32];
-  strcpy_P(cmdBuff, command);
-  sendCommand(cmdBuff, parameter);
+void SIM800L::writeString(const char* str, bool inFlash) {
+  if(!inFlash) {
+    stream->write(str);
+    return;
+  }
+
+  char c;
+  while((c = pgm_read_byte(str++)) != '\0') {
+    stream->write(c);
+  }
+}
+
+/**
+ * Print a string on the debug console (from the RAM or the PROGMEM)
+ */
+void SIM800L::printString(const char* str, bool inFlash) {
+  if(inFlash) {
+    debugStream->print((const __FlashStringHelper*)str);
+  } else {
+    debugStream->print(str);
+  }
 }
 
 /**
@@ -887,15 +3510,17 @@ void SIM800L::purgeSerial() {
  */
 bool SIM800L::readResponseCheckAnswer_P(uint16_t timeout, const char* expectedAnswer, uint8_t crlfToWait) {
   if(readResponse(timeout, crlfToWait)) {
-    // Prepare the local expected answer
-    char rspBuff[16];
-    strcpy_P(rspBuff, expectedAnswer);
-
-    // Check if it's the expected answer
-    int16_t idx = strIndex(internalBuffer, rspBuff);
-    if(idx > 0) {
+    // Check if it's the expected answer (compared directly from the PROGMEM)
+    const char* found = strstr_P(internalBuffer, expectedAnswer);
+    if(found != NULL && found > internalBuffer) {
       return true;
     }
+
+    // Keep the extended error reported by the module (see enableExtendedErrors())
+    const char* cmeError = strstr_P(internalBuffer, AT_RSP_CME_ERROR);
+    if(cmeError != NULL) {
+      lastCMECode = atoi(cmeError + strlen_P(AT_RSP_CME_ERROR));
+    }
   }
   return false;
 }
@@ -909,16 +3534,37 @@ bool SIM800L::readResponse(uint16_t timeout, uint8_t crlfToWait) {
   bool seenCR = false;
   uint8_t countCRLF = 0;
 
+  // Only the first answer after the command is measured (the timeout requested is the maximum)
+  TimeoutClass timeoutClass = armedTimeoutClass;
+  armedTimeoutClass = TIMEOUT_NONE;
+  if(timeoutClass != TIMEOUT_NONE) {
+    timeout = computeTimeout(timeoutClass, timeout);
+  }
+
   // First of all, cleanup the buffer
   initInternalBuffer();
 
   uint32_t timerStart = millis();
 
   while(1) {
-    // While there is data available on the buffer, read it until the max size of the response
-    if(stream->available()) {
+    // Data available: contiguous span of the ring buffer or next byte of the stream
+    const uint8_t* data = NULL;
+    uint16_t length = 0;
+    uint8_t c;
+    if(ring != NULL) {
+      length = ring->span(&data);
+    } else if(stream->available()) {
+      c = stream->read();
+      data = &c;
+      length = 1;
+    }
+
+    // Read the data until the end of the answer or the max size of the response
+    uint16_t used = 0;
+    bool complete = false;
+    while(used < length && !complete) {
       // Load the next char
-      internalBuffer[currentSizeResponse] = stream->read();
+      internalBuffer[currentSizeResponse] = data[used++];
 
       // Detect end of transmission (CRLF)
       if(internalBuffer[currentSizeResponse] == '\r') {
@@ -927,6 +3573,7 @@ bool SIM800L::readResponse(uint16_t timeout, uint8_t crlfToWait) {
         countCRLF++;
         if(countCRLF == crlfToWait) {
           if(enableDebug) debugStream->println(F("SIM800L : End of transmission"));
+          complete = true;
           break;
         }
       } else {
@@ -936,21 +3583,35 @@ bool SIM800L::readResponse(uint16_t timeout, uint8_t crlfToWait) {
       // Prepare for next read
       currentSizeResponse++;
 
-      // Avoid buffer overflow
-      if(currentSizeResponse == internalBufferSize) {
+      // Avoid buffer overflow (keep the last byte for the end of string)
+      if(currentSizeResponse == internalBufferSize - 1) {
         if(enableDebug) debugStream->println(F("SIM800L : Received maximum buffer size"));
-        break;
+        complete = true;
       }
     }
+    if(ring != NULL) {
+      ring->consume(used);
+    }
+    if(complete) {
+      break;
+    }
 
     // If timeout, abord the reading
     if(millis() - timerStart > timeout) {
       if(enableDebug) debugStream->println(F("SIM800L : Receive timeout"));
+      if(timeoutClass != TIMEOUT_NONE) {
+        recordLatency(timeoutClass, 0, false);
+      }
       // Timeout, return false to parent function
       return false;
     }
   }
 
+  if(timeoutClass != TIMEOUT_NONE) {
+    recordLatency(timeoutClass, millis() - armedTimeoutStart, true);
+  }
+  lastActivity = millis();
+
   if(enableDebug) {
     debugStream->print(F("SIM800L : Receive \""));
     debugStream->print(internalBuffer);
@@ -32,12 +32,130 @@
 #define _SIM800L_H_
 
 #include <Arduino.h>
+#include "SIM800LRing.h"
 
 #define DEFAULT_TIMEOUT 5000
 #define RESET_PIN_NOT_USED -1
+#define DTR_PIN_NOT_USED -1
+#define SIM800L_TIMEOUT_MIN 1000           // Minimum timeout derived from the latency (millisec)
+#define SIM800L_TIMEOUT_MIN_SAMPLES 4      // Number of answers measured before deriving the timeout
+#define SIM800L_READ_TIMEOUT 1000          // Timeout of the data read by spans of the ring buffer (millisec)
+#define SIM800L_CACHE_VALIDATOR_SIZE 48    // Maximum size of the ETag and Last-Modified validators (with the NUL)
+#define SIM800L_FS_CHUNK_SIZE 512          // Maximum size of the chunks appended to a file of the module (bytes)
+#define SIM800L_BEARER_COUNT 3             // Number of bearer profiles of the module (CID 1 to 3)
+#define SIM800L_RESET_PULSE 120            // Duration of the reset pulse, 105 ms minimum (millisec)
+#define SIM800L_BOOT_POLL 250              // Maximum wait for the module between two polls during the boot (millisec)
+#define SIM800L_FS_INPUT_TIME 10           // Time given to the module to receive a chunk of a file (sec)
+#define SIM800L_SLEEP_IDLE_DELAY 5000      // Idle time of the serial line before the module sleeps by itself with AT+CSCLK=2 (millisec)
 
 enum PowerMode {MINIMUM, NORMAL, POW_UNKNOWN, SLEEP, POW_ERROR};
 enum NetworkRegistration {NOT_REGISTERED, REGISTERED_HOME, SEARCHING, DENIED, NET_UNKNOWN, REGISTERED_ROAMING, NET_ERROR};
+enum TimeoutClass {TIMEOUT_COMMAND, TIMEOUT_NETWORK, TIMEOUT_SERVER, TIMEOUT_SMS, TIMEOUT_NONE};
+enum ErrorStage {STAGE_NONE, STAGE_INIT, STAGE_WRITE, STAGE_ACTION, STAGE_SERVER, STAGE_READ, STAGE_TERMINATE};
+
+// Destination of the data received through a streamed transfer (flash, SD card, file...)
+class SIM800LSink {
+  public:
+    // Store the chunk of data located at the offset of the resource
+    // Returns true if the data is committed (it will not be requested again)
+    virtual bool write(uint32_t offset, const uint8_t* data, uint16_t length) = 0;
+};
+
+// Origin of the data sent through a streamed transfer (flash, SD card, file...)
+class SIM800LSource {
+  public:
+    // Fill the buffer with the next chunk of data (up to maxLength bytes)
+    // Returns the number of bytes provided, 0 at the end of the data
+    virtual uint16_t read(uint8_t* buffer, uint16_t maxLength) = 0;
+};
+
+// Body of a HTTP POST written straight to the module (binary data, encoder...)
+class SIM800LPayload {
+  public:
+    // Content type of the body
+    virtual const char* getContentType() = 0;
+    // Length of the body in bytes
+    virtual uint16_t getLength() = 0;
+    // Write the body to the module (called again when the request is retried)
+    virtual void writeTo(Print* output) = 0;
+};
+
+// Storage of the answers of the HTTP GET keyed by URL (EEPROM, SD card, file...)
+// The body of a new answer is written through the sink interface
+class SIM800LCache : public SIM800LSink {
+  public:
+    // Load the validators (ETag and Last-Modified, empty if not provided by the server) of the answer cached for the URL
+    // Returns false if the URL is not cached
+    virtual bool lookup(const char* url, char* etag, uint8_t etagSize, char* lastModified, uint8_t lastModifiedSize) = 0;
+    // Start replacing the answer cached for the URL, the body follows through write()
+    // Returns false to not cache the answer
+    virtual bool begin(const char* url, const char* etag, const char* lastModified) = 0;
+    // End of the body: keep the answer if complete, discard it elsewhere
+    virtual void end(bool complete) = 0;
+    // Read the chunk of the body cached for the URL located at the offset
+    // Returns the number of bytes read, 0 at the end of the body
+    virtual uint16_t read(const char* url, uint32_t offset, uint8_t* buffer, uint16_t maxLength) = 0;
+};
+
+// State of a resumable download, keep it between calls to resume the transfer
+struct SIM800LDownload {
+  uint32_t offset = 0;     // Number of bytes committed to the sink
+  uint32_t totalSize = 0;  // Total size of the resource (0 if not known yet)
+  uint32_t crc32 = 0;      // CRC32 of the bytes committed to the sink
+};
+
+// Latency measured for a class of command (local command, network, server, SMS)
+struct SIM800LLatency {
+  uint32_t average = 0;    // Average latency in millisec (EWMA)
+  uint32_t variation = 0;  // Average variation of the latency in millisec
+  uint16_t samples = 0;    // Number of answers measured
+  uint8_t backoff = 0;     // Number of timeouts since the last answer
+  uint16_t overrideMs = 0; // Timeout forced by the user (0 if not defined)
+};
+
+// Last error of an HTTP call
+struct SIM800LError {
+  ErrorStage stage = STAGE_NONE; // Stage of the call which failed (STAGE_NONE if successful)
+  uint16_t code = 0;       // Code returned (error code of the driver or HTTP status)
+  int16_t cmeCode = -1;    // Extended error of the module (+CME ERROR), -1 if not reported
+  uint16_t httpStatus = 0; // HTTP status of the server (0 if not received)
+  bool transient = false;  // True if the same call may succeed later (network, busy module or server)
+};
+
+// Health of a bearer profile of the module
+struct SIM800LBearerStats {
+  bool configured = false;         // Parameters of the bearer sent to the module
+  uint32_t requests = 0;           // Number of HTTP attempts on the bearer
+  uint32_t failures = 0;           // Number of attempts stalled (timeout, network or DNS errors)
+  uint8_t consecutiveFailures = 0; // Stalls since the last success
+  uint32_t latencyMs = 0;          // Average duration of the successful attempts (EWMA)
+};
+
+// Milestones of the boot of the module (millisec since the start of begin(), 0 if not reached)
+struct SIM800LBootStats {
+  uint32_t responsiveMs = 0;   // Module answering (RDY or AT)
+  uint32_t configuredMs = 0;   // Configuration of the module and of the bearer applied
+  uint32_t registeredMs = 0;   // Registration on the network
+  uint32_t firstRequestMs = 0; // Bearer opened, time to the first request
+  uint16_t commands = 0;       // Number of commands sent during the boot
+};
+
+// SMS read from the storage of the module
+// The content points to the reception buffer and is valid until the next command
+struct SIM800LSMS {
+  uint16_t index;          // Index of the message in the storage
+  char sender[22];         // Phone number of the sender
+  char timestamp[18];      // Time stamp of the service center (yy/MM/dd,hh:mm:ss)
+  const uint8_t* data;     // Content: text (NUL terminated) or binary data
+  uint8_t length;          // Size of the content
+  bool binary;             // True if the content is binary (8 bits or UCS2 coding)
+  uint8_t partReference;   // Concatenated messages: reference, number of parts and
+  uint8_t partCount;       // number of the part (partCount is 0 for single messages)
+  uint8_t partNumber;
+};
+
+// Called for each SMS read from the storage
+typedef void (*SIM800LSMSCallback)(SIM800LSMS* sms, void* context);
 
 class SIM800L {
   public:
@@ -49,12 +167,21 @@ class SIM800L {
     //                        (including URL and maximum payload to send through POST method)
     //  _recvBufferSize (optional) : size in bytes of the reception buffer (max data to receive from GET or POST)
     //  _debugStream (optional) : Stream opened to the debug console (Software of Hardware)
-    SIM800L(Stream* _stream, uint8_t _pinRst = RESET_PIN_NOT_USED, uint16_t _internalBufferSize = 128, uint16_t _recvBufferSize = 256, Stream* _debugStream = NULL);
+    SIM800L(Stream* _stream, int8_t _pinRst = RESET_PIN_NOT_USED, uint16_t _internalBufferSize = 128, uint16_t _recvBufferSize = 256, Stream* _debugStream = NULL);
+    // Initialize the driver with a ring buffer between the serial link and the driver (see SIM800LRing)
+    SIM800L(SIM800LRing* _ring, int8_t _pinRst = RESET_PIN_NOT_USED, uint16_t _internalBufferSize = 128, uint16_t _recvBufferSize = 256, Stream* _debugStream = NULL);
     ~SIM800L();
 
     // Force a reset of the module
     void reset();
 
+    // Fast cold start: wait for the module (RDY or AT) without fixed delays, apply the configuration and the
+    // parameters of the active bearer in one command line while the module registers on the network, then
+    // open the bearer as soon as registered. Returns true when ready for the first request.
+    // The module is not reset again (already done by the constructor with the reset pin, see reset()).
+    bool begin(const char* apn, const char* user = NULL, const char* password = NULL, uint32_t timeoutMs = 60000);
+    SIM800LBootStats getBootStats();
+
     // Status functions
     bool isReady();
     uint8_t getSignal();
@@ -71,22 +198,125 @@ class SIM800L {
 
     // Define PIN code to activate SIM card
     bool setPinCode(const char *pin);
+    bool setPinCode(const __FlashStringHelper* pin);
 
     // Define the power mode (for parameter: see PowerMode enum)
     bool setPowerMode(PowerMode powerMode);
 
+    // Sleep with the slow clock between transmissions (wake up by DTR if the pin is defined, by the serial line elsewhere)
+    // The module is woken up automatically before the next command
+    bool enableSleep(int8_t _pinDTR = DTR_PIN_NOT_USED);
+    bool disableSleep();
+    void sleep();
+    void wakeUp();
+    bool isSleeping();
+
+    // Energy accounting: time awake and sleeping (millisec), data transferred (bytes)
+    // and estimated charge (uAh) based on the average currents of the module (uA)
+    void setPowerProfile(uint32_t _awakeCurrent, uint32_t _sleepCurrent);
+    uint32_t getTimeAwake();
+    uint32_t getTimeSleeping();
+    uint32_t getDataTransferred();
+    uint32_t getEstimatedCharge();
+    void resetPowerStats();
+
     // Enable/disable GPRS
     bool setupGPRS(const char *apn);
     bool setupGPRS(const char *apn, const char *user, const char *password);
+    bool setupGPRS(const __FlashStringHelper* apn);
+    bool setupGPRS(const __FlashStringHelper* apn, const __FlashStringHelper* user, const __FlashStringHelper* password);
     bool connectGPRS();
     bool isConnectedGPRS();
     bool disconnectGPRS();
 
+    // Bearer profiles (CID 1 to 3), configured once and used by HTTP, FTP and the GPRS methods above when active
+    // With the failover enabled, the active bearer is replaced by the healthiest other profile configured after
+    // maxFailures consecutive stalls, without sending its parameters again (0 to disable)
+    bool setupBearer(uint8_t cid, const char* apn, const char* user = NULL, const char* password = NULL);
+    bool connectBearer(uint8_t cid);
+    bool isConnectedBearer(uint8_t cid);
+    bool disconnectBearer(uint8_t cid);
+    bool setActiveBearer(uint8_t cid);
+    uint8_t getActiveBearer();
+    SIM800LBearerStats* getBearerStats(uint8_t cid);
+    void enableBearerFailover(uint8_t maxFailures);
+
     // HTTP methods
     uint16_t doGet(const char* url, uint16_t serverReadTimeoutMs);
     uint16_t doGet(const char* url, const char* headers, uint16_t serverReadTimeoutMs);
     uint16_t doPost(const char* url, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
     uint16_t doPost(const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+    uint16_t doPost(const char* url, const char* headers, const char* contentType, const uint8_t* payload, uint16_t length, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+    uint16_t doPost(const char* url, const char* headers, SIM800LPayload* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+
+    // HTTP methods with the URL, headers, content type and payload in PROGMEM (F() macro), sent directly from the flash
+    uint16_t doGet(const __FlashStringHelper* url, uint16_t serverReadTimeoutMs);
+    uint16_t doGet(const __FlashStringHelper* url, const __FlashStringHelper* headers, uint16_t serverReadTimeoutMs);
+    uint16_t doPost(const __FlashStringHelper* url, const __FlashStringHelper* contentType, const __FlashStringHelper* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+    uint16_t doPost(const __FlashStringHelper* url, const __FlashStringHelper* headers, const __FlashStringHelper* contentType, const __FlashStringHelper* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+
+    // Asynchronous HTTP methods: start the action, wait until the answer of the server is available
+    // (isHTTPAnswerAvailable() skips the unsolicited messages of the module) and read the result
+    uint16_t startGet(const char* url, const char* headers);
+    uint16_t startPost(const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs);
+    bool isAnswerAvailable();
+    bool isHTTPAnswerAvailable();
+    uint16_t finishHTTP(uint16_t serverReadTimeoutMs);
+
+    // Cache of the answers of doGet() keyed by URL (URL in RAM only): the request is conditional (If-None-Match
+    // and If-Modified-Since) and the cached body is served if the answer is not modified (304 returned as 200)
+    bool setResponseCache(SIM800LCache* cache);
+    bool isAnswerFromCache();
+
+    // Errors of the HTTP calls: extended errors of the module (+CME ERROR), details of the last error
+    // and number of attempts on transient errors (retried from the stage which failed)
+    bool enableExtendedErrors();
+    SIM800LError getLastError();
+    void setRetryPolicy(uint8_t maxAttempts, uint16_t initialDelayMs = 1000, uint16_t maxDelayMs = 30000);
+
+    // Stream the body of the HTTP answers to a sink (JSON scanner, file...) instead of the reception buffer
+    void setResponseSink(SIM800LSink* sink);
+
+    // Resumable HTTP download to a sink, by windows of windowSize bytes (limited to the reception buffer)
+    // The download is complete when download->offset reaches download->totalSize
+    uint16_t doDownload(const char* url, SIM800LSink* sink, SIM800LDownload* download, uint16_t windowSize, uint16_t serverReadTimeoutMs);
+
+    // FTP methods (chunks are limited to the reception buffer)
+    // Return 0 if OK, the FTP error code of the module (61-86) or the error code of the driver (70x)
+    bool setupFTP(const char* server, uint16_t port, const char* user, const char* password);
+    uint16_t ftpGet(const char* path, const char* filename, SIM800LSink* sink, uint16_t chunkSize, uint16_t serverTimeoutMs);
+    uint16_t ftpPut(const char* path, const char* filename, SIM800LSource* source, uint16_t chunkSize, bool append, uint16_t serverTimeoutMs);
+
+    // Files on the flash of the module (in C:\User\): records are staged over time, then uploaded in one FTP session
+    bool createFile(const char* filename);
+    bool appendFile(const char* filename, const uint8_t* data, uint16_t length);
+    int32_t getFileSize(const char* filename);
+    bool deleteFile(const char* filename);
+    uint16_t ftpPutFile(const char* path, const char* filename, const char* localFile, bool append, uint16_t serverTimeoutMs);
+
+    // SMS methods (PDU mode, long messages are sent in concatenated parts)
+    bool setupSMS();
+    bool sendSMS(const char* number, const char* text);
+    bool sendBinarySMS(const char* number, const uint8_t* data, uint16_t length);
+    int16_t readAllSMS(SIM800LSMSCallback callback, void* context, bool deleteAfterRead);
+    int16_t checkNewSMS();
+    bool deleteSMS(uint16_t index);
+    bool deleteAllSMS();
+
+    // Statistics of the last streamed transfer (size in bytes, duration in millisec and throughput in bytes/sec)
+    uint32_t getLastTransferSize();
+    uint32_t getLastTransferDuration();
+    uint32_t getLastTransferThroughput();
+
+    // Timeouts derived from the latency measured for each class of command (clamped to the maximum of the specifications)
+    // The timeout of a class can be forced (0 to go back to the default)
+    void enableAdaptiveTimeouts(bool enable);
+    void setTimeoutOverride(TimeoutClass timeoutClass, uint16_t timeoutMs);
+    uint32_t getAverageLatency(TimeoutClass timeoutClass);
+
+    // Number of commands sent to the module (round trips) since the last reset
+    uint32_t getCommandCount();
+    void resetCommandCount();
 
     // Obtain results after HTTP successful connections (size and buffer)
     uint16_t getDataSizeReceived();
@@ -99,8 +329,14 @@ class SIM800L {
     void sendCommand_P(const char* command);
     // Send command with parameter within quotes (template : command"parameter")
     void sendCommand(const char* command, const char* parameter);
-    // Send command with parameter within quotes from PROGMEM (template : command"parameter")
-    void sendCommand_P(const char* command, const char* parameter);
+    // Send command with parameter (in RAM or in PROGMEM) within quotes from PROGMEM (template : command"parameter")
+    void sendCommand_P(const char* command, const char* parameter, bool parameterInFlash = false);
+    // Send command with an optional parameter, the strings in PROGMEM are sent directly from the flash
+    void sendCommand(const char* command, bool commandInFlash, const char* parameter, bool parameterInFlash);
+
+    // Write a string to the module or to the debug console (from RAM or PROGMEM)
+    void writeString(const char* str, bool inFlash);
+    void printString(const char* str, bool inFlash);
 
     // Read from module (timeout in millisec)
     bool readResponse(uint16_t timeout, uint8_t crlfToWait = 2);
@@ -110,9 +346,16 @@ class SIM800L {
     // Purge the serial
     void purgeSerial();
 
+    // Read data from the module (by spans of the ring buffer if defined)
+    size_t readData(char* buffer, size_t length);
+
     // Find string in another string
     int16_t strIndex(const char* str, const char* findStr, uint16_t startIdx = 0);
 
+    // Extract a value from the internal buffer to the reception buffer
+    int16_t skipEcho(const char* command);
+    char* extractValue(int16_t idx, char endChar);
+
     // Manage internal buffer
     void initInternalBuffer();
     void initRecvBuffer();
@@ -120,16 +363,70 @@ class SIM800L {
     // Manage HTTP/S connection
     uint16_t initiateHTTP(const char* url, const char* headers);
     uint16_t readHTTP(uint16_t serverReadTimeoutMs);
+    uint16_t readHTTPAction(uint16_t serverReadTimeoutMs, uint16_t* httpRC, uint32_t* length);
+    bool readHTTPAnswer(uint16_t timeout, bool wait);
+    uint16_t writeHTTPPayload(const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs);
+    uint16_t startHTTPAction(bool post);
+    uint16_t readHTTPBody(uint32_t length, uint32_t* offset);
+    uint16_t terminateHTTP();
+    uint16_t readDownload(SIM800LSink* sink, SIM800LDownload* download, uint16_t windowSize, uint16_t serverReadTimeoutMs, uint16_t* httpRC);
+
+    // Manage the cache of the HTTP answers
+    const char* buildConditionalHeaders(const char* headers);
+    uint16_t readHTTPValidators();
+    uint16_t serveCachedAnswer(const char* url);
+
+    // Run the HTTP call by stages and retry the transient errors from the stage which failed
+    uint16_t doHTTP(bool post, const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs);
+    void recordError(ErrorStage stage, uint16_t code, uint16_t httpStatus);
+    bool isTransientError(uint16_t code, int16_t cmeCode);
+
+    // Manage the boot of the module
+    bool readBootEvents(uint16_t timeout, const char* expectedAnswer);
+    bool applyBootConfiguration(const char* apn, const char* user, const char* password);
+
+    // Manage the bearer profiles
+    void sendBearerCommand(const char* command, uint8_t cid, const char* parameter = NULL, bool parameterInFlash = false);
+    bool isBearerStall(uint16_t code, int16_t cmeCode, uint16_t httpStatus);
+    bool recordBearerResult(bool stalled, uint32_t durationMs);
+
+    // Manage FTP sessions
+    bool parseFTPAnswer_P(const char* answer, uint16_t* mode, uint16_t* status, uint16_t* length);
+    uint16_t closeFTP(uint16_t errorCode);
+    bool defineFTPUpload(const char* path, const char* filename, bool append);
+    bool prepareFileCommand(const char* format, const char* filename, uint16_t length);
+
+    // Manage SMS in PDU mode
+    bool sendSMSPart(const char* number, const uint8_t* data, uint8_t length, bool binary, uint8_t partCount, uint8_t partNumber);
+    bool decodeSMS(uint16_t pduLength, SIM800LSMS* sms);
+    void unpackSeptets(const uint8_t* src, uint8_t* dst, uint16_t count);
+    uint8_t toGSM7(char c);
+    char fromGSM7(uint8_t c);
+    uint16_t readHexLine(uint8_t* buffer, uint16_t maxLength, uint16_t timeout);
+    bool waitPrompt(uint16_t timeout);
+    void writeHex(uint8_t value);
+
+    // Measure the latency of the next answer and derive the timeouts
+    void armTimeout(TimeoutClass timeoutClass);
+    uint16_t computeTimeout(TimeoutClass timeoutClass, uint16_t maxTimeout);
+    void recordLatency(TimeoutClass timeoutClass, uint32_t latencyMs, bool answered);
+
+    // Add the time elapsed since the last change to the current power state
+    void updatePowerStats();
+
+    // Update a CRC32 with a new chunk of data
+    uint32_t updateCRC32(uint32_t crc, const uint8_t* data, uint16_t length);
 
   private:
-    // Serial line with SIM800L
+    // Serial line with SIM800L and ring buffer (NULL if not used)
     Stream* stream = NULL;
+    SIM800LRing* ring = NULL;
 
     // Serial console for the debug
     Stream* debugStream = NULL;
 
     // Details about the circuit: pins
-    uint8_t pinReset = 0;
+    int8_t pinReset = RESET_PIN_NOT_USED;
 
     // Internal memory for the shared buffer
     // Used for all reception of message from the module
@@ -141,6 +438,77 @@ class SIM800L {
     uint16_t recvBufferSize = 0;
     uint16_t dataSize = 0;
 
+    // Parameters of the current call located in PROGMEM (FLASH_xxx flags)
+    uint8_t flashParameters = 0;
+
+    // Body of the current POST written by the caller (NULL for the payload string)
+    SIM800LPayload* payloadWriter = NULL;
+
+    // Destination of the body of the HTTP answers (NULL for the reception buffer)
+    SIM800LSink* responseSink = NULL;
+
+    // Cache of the HTTP answers, validators of the current answer (ETag then Last-Modified) and state of the call
+    SIM800LCache* responseCache = NULL;
+    char* cacheValidators = NULL;
+    bool conditionalGet = false;
+    bool cacheStoring = false;
+    bool answerFromCache = false;
+
+    // Answer of the server (+HTTPACTION) already read in the internal buffer by isHTTPAnswerAvailable()
+    bool httpAnswerReceived = false;
+
+    // Last error of an HTTP call, last extended error of the module and retry policy
+    SIM800LError lastError;
+    int16_t lastCMECode = -1;
+    uint8_t retryAttempts = 1;
+    uint16_t retryInitialDelay = 1000;
+    uint16_t retryMaxDelay = 30000;
+
+    // Statistics of the last streamed transfer
+    uint32_t lastTransferSize = 0;
+    uint32_t lastTransferDuration = 0;
+
+    // Number of commands sent to the module
+    uint32_t commandCount = 0;
+
+    // Latency of each class of command and class of the next answer to measure
+    SIM800LLatency latency[TIMEOUT_NONE];
+    TimeoutClass armedTimeoutClass = TIMEOUT_NONE;
+    uint32_t armedTimeoutStart = 0;
+    bool adaptiveTimeouts = false;
+
+    // Power management: last power mode set, slow clock mode (0 disabled, 1 DTR, 2 automatic), pin DTR
+    // and time of the last activity on the serial line (the module sleeps by itself when idle in mode 2)
+    PowerMode currentPowerMode = POW_UNKNOWN;
+    uint8_t slowClockMode = 0;
+    int8_t pinDTR = DTR_PIN_NOT_USED;
+    bool sleeping = false;
+    uint32_t lastActivity = 0;
+
+    // Energy accounting (time in millisec, currents in uA)
+    uint32_t timeAwake = 0;
+    uint32_t timeSleeping = 0;
+    uint32_t lastPowerStateChange = 0;
+    uint32_t dataTransferred = 0;
+    uint32_t awakeCurrent = 25000;
+    uint32_t sleepCurrent = 1000;
+
+    // Boot of the module (BOOT_xxx events seen and milestones of the last begin())
+    uint8_t bootEvents = 0;
+    SIM800LBootStats bootStats;
+
+    // Bearer profiles, the active one is used by HTTP, FTP and the GPRS methods
+    SIM800LBearerStats bearerStats[SIM800L_BEARER_COUNT];
+    uint8_t activeBearer = 1;
+    uint8_t bearerMaxFailures = 0;
+
+    // Reference of the last concatenated SMS sent
+    uint8_t smsReference = 0;
+
+    // Capacity of the storage of the SMS and indexes of the messages given to the callback of readAllSMS() (one bit per index)
+    uint16_t smsCapacity = 0;
+    uint8_t* smsDelivered = NULL;
+
     // Enable debug mode
     bool enableDebug = false;
 };
@@ -0,0 +1,327 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM800LCbor.h"
+
+// Major types of CBOR
+#define CBOR_UNSIGNED 0
+#define CBOR_NEGATIVE 1
+#define CBOR_BYTES 2
+#define CBOR_TEXT 3
+#define CBOR_ARRAY 4
+#define CBOR_MAP 5
+#define CBOR_SIMPLE 7
+
+// Simple values and floats
+#define CBOR_FALSE 0xF4
+#define CBOR_TRUE 0xF5
+#define CBOR_NULL 0xF6
+#define CBOR_HALF 0xF9
+#define CBOR_SINGLE 0xFA
+
+/**
+ * Constructor; encode in the buffer of the caller
+ */
+SIM800LCborEncoder::SIM800LCborEncoder(uint8_t* _buffer, uint16_t _size) {
+  buffer = _buffer;
+  size = _size;
+}
+
+/**
+ * Constructor; encode straight to an output
+ */
+SIM800LCborEncoder::SIM800LCborEncoder(Print* _output) {
+  output = _output;
+}
+
+/**
+ * Constructor; only count the length of the document
+ */
+SIM800LCborEncoder::SIM800LCborEncoder() {
+}
+
+/**
+ * Restart the document from the beginning
+ */
+void SIM800LCborEncoder::reset() {
+  length = 0;
+  error = false;
+}
+
+/**
+ * Write an unsigned integer
+ */
+void SIM800LCborEncoder::writeUInt(uint32_t value) {
+  writeHead(CBOR_UNSIGNED, value);
+}
+
+/**
+ * Write a signed integer (negative values are encoded as -1 - argument)
+ */
+void SIM800LCborEncoder::writeInt(int32_t value) {
+  if(value < 0) {
+    writeHead(CBOR_NEGATIVE, (uint32_t)(-1 - value));
+  } else {
+    writeHead(CBOR_UNSIGNED, value);
+  }
+}
+
+/**
+ * Write a float, in half precision if the value is exact on 2 bytes
+ */
+void SIM800LCborEncoder::writeFloat(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, 4);
+
+  uint16_t sign = (bits >> 16) & 0x8000;
+  uint8_t exponent = (bits >> 23) & 0xFF;
+  uint32_t mantissa = bits & 0x7FFFFF;
+
+  bool exact = true;
+  uint16_t half = sign;
+  if(exponent == 0xFF) {
+    // Infinity or NaN
+    half |= 0x7C00 | (mantissa != 0 ? 0x0200 : 0);
+  } else if(exponent != 0 || mantissa != 0) {
+    // Normal value of the half precision without loss (exponent -14 to 15, 10 bits of mantissa)
+    exact = exponent >= 127 - 14 && exponent <= 127 + 15 && (mantissa & 0x1FFF) == 0;
+    if(exact) {
+      half |= ((uint16_t)(exponent - 127 + 15) << 10) | (mantissa >> 13);
+    }
+  }
+
+  if(exact) {
+    writeByte(CBOR_HALF);
+    writeByte(half >> 8);
+    writeByte(half & 0xFF);
+  } else {
+    writeByte(CBOR_SINGLE);
+    writeByte(bits >> 24);
+    writeByte((bits >> 16) & 0xFF);
+    writeByte((bits >> 8) & 0xFF);
+    writeByte(bits & 0xFF);
+  }
+}
+
+/**
+ * Write a boolean
+ */
+void SIM800LCborEncoder::writeBool(bool value) {
+  writeByte(value ? CBOR_TRUE : CBOR_FALSE);
+}
+
+/**
+ * Write null
+ */
+void SIM800LCborEncoder::writeNull() {
+  writeByte(CBOR_NULL);
+}
+
+/**
+ * Write a text string (UTF-8)
+ */
+void SIM800LCborEncoder::writeString(const char* value) {
+  uint16_t valueLength = strlen(value);
+  writeHead(CBOR_TEXT, valueLength);
+  writeData((const uint8_t*)value, valueLength, false);
+}
+
+/**
+ * Write a text string located in PROGMEM (F() macro)
+ */
+void SIM800LCborEncoder::writeString(const __FlashStringHelper* value) {
+  uint16_t valueLength = strlen_P((const char*)value);
+  writeHead(CBOR_TEXT, valueLength);
+  writeData((const uint8_t*)value, valueLength, true);
+}
+
+/**
+ * Write a byte string
+ */
+void SIM800LCborEncoder::writeBytes(const uint8_t* data, uint16_t dataLength) {
+  writeHead(CBOR_BYTES, dataLength);
+  writeData(data, dataLength, false);
+}
+
+/**
+ * Start an array of count items
+ */
+void SIM800LCborEncoder::beginArray(uint16_t count) {
+  writeHead(CBOR_ARRAY, count);
+}
+
+/**
+ * Start a map of count pairs (key and value)
+ */
+void SIM800LCborEncoder::beginMap(uint16_t count) {
+  writeHead(CBOR_MAP, count);
+}
+
+/**
+ * Write a pair of a map with an unsigned integer
+ */
+void SIM800LCborEncoder::addUInt(const char* key, uint32_t value) {
+  writeString(key);
+  writeUInt(value);
+}
+
+/**
+ * Write a pair of a map with a signed integer
+ */
+void SIM800LCborEncoder::addInt(const char* key, int32_t value) {
+  writeString(key);
+  writeInt(value);
+}
+
+/**
+ * Write a pair of a map with a float
+ */
+void SIM800LCborEncoder::addFloat(const char* key, float value) {
+  writeString(key);
+  writeFloat(value);
+}
+
+/**
+ * Write a pair of a map with a boolean
+ */
+void SIM800LCborEncoder::addBool(const char* key, bool value) {
+  writeString(key);
+  writeBool(value);
+}
+
+/**
+ * Write a pair of a map with a text string
+ */
+void SIM800LCborEncoder::addString(const char* key, const char* value) {
+  writeString(key);
+  writeString(value);
+}
+
+/**
+ * Return the length of the document (the length required if the buffer is too small)
+ */
+uint16_t SIM800LCborEncoder::getLength() {
+  return length;
+}
+
+/**
+ * Check if the document doesn't fit in the buffer
+ */
+bool SIM800LCborEncoder::hasError() {
+  return error;
+}
+
+/**
+ * Constructor; the document is encoded by the callback
+ */
+SIM800LCborPayload::SIM800LCborPayload(SIM800LCborCallback _callback, void* _context) {
+  callback = _callback;
+  context = _context;
+}
+
+/**
+ * Return the content type of CBOR documents
+ */
+const char* SIM800LCborPayload::getContentType() {
+  return SIM800L_CBOR_CONTENT_TYPE;
+}
+
+/**
+ * Count the length of the document
+ */
+uint16_t SIM800LCborPayload::getLength() {
+  SIM800LCborEncoder counter;
+  callback(&counter, context);
+  return counter.getLength();
+}
+
+/**
+ * Encode the document straight to the module
+ */
+void SIM800LCborPayload::writeTo(Print* output) {
+  SIM800LCborEncoder encoder(output);
+  callback(&encoder, context);
+}
+
+/*****************************************************************************************
+ * HELPERS
+ *****************************************************************************************/
+/**
+ * Write the head of an item with the argument on 0, 1, 2 or 4 bytes
+ */
+void SIM800LCborEncoder::writeHead(uint8_t major, uint32_t argument) {
+  major <<= 5;
+  if(argument < 24) {
+    writeByte(major | argument);
+  } else if(argument <= 0xFF) {
+    writeByte(major | 24);
+    writeByte(argument);
+  } else if(argument <= 0xFFFF) {
+    writeByte(major | 25);
+    writeByte(argument >> 8);
+    writeByte(argument & 0xFF);
+  } else {
+    writeByte(major | 26);
+    writeByte(argument >> 24);
+    writeByte((argument >> 16) & 0xFF);
+    writeByte((argument >> 8) & 0xFF);
+    writeByte(argument & 0xFF);
+  }
+}
+
+/**
+ * Write a byte to the buffer or to the output
+ */
+void SIM800LCborEncoder::writeByte(uint8_t value) {
+  if(buffer != NULL) {
+    if(length < size) {
+      buffer[length] = value;
+    } else {
+      error = true;
+    }
+  } else if(output != NULL) {
+    output->write(value);
+  }
+  length++;
+}
+
+/**
+ * Write the content of a string, from the RAM or from the PROGMEM
+ */
+void SIM800LCborEncoder::writeData(const uint8_t* data, uint16_t dataLength, bool inFlash) {
+  if(buffer == NULL && output != NULL && !inFlash) {
+    output->write(data, dataLength);
+    length += dataLength;
+    return;
+  }
+  for(uint16_t i = 0; i < dataLength; i++) {
+    writeByte(inFlash ? pgm_read_byte(data + i) : data[i]);
+  }
+}
@@ -0,0 +1,112 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM800L_CBOR_H_
+#define _SIM800L_CBOR_H_
+
+#include <Arduino.h>
+#include "SIM800L.h"
+
+#define SIM800L_CBOR_CONTENT_TYPE "application/cbor"
+
+// Encoder of CBOR documents (RFC 8949) without allocation. The items are written either
+// in the buffer of the caller, straight to an output (the module through SIM800LCborPayload)
+// or only counted to know the length of the document. Arrays and maps have a definite
+// length (number of items, or of pairs for a map). Floats are written on 2 bytes when
+// the value is exact in half precision, on 4 bytes elsewhere.
+class SIM800LCborEncoder {
+  public:
+    // Encode in the buffer of the caller
+    SIM800LCborEncoder(uint8_t* _buffer, uint16_t _size);
+    // Encode straight to an output
+    SIM800LCborEncoder(Print* _output);
+    // Only count the length of the document
+    SIM800LCborEncoder();
+
+    // Restart the document from the beginning
+    void reset();
+
+    // Items
+    void writeUInt(uint32_t value);
+    void writeInt(int32_t value);
+    void writeFloat(float value);
+    void writeBool(bool value);
+    void writeNull();
+    void writeString(const char* value);
+    void writeString(const __FlashStringHelper* value);
+    void writeBytes(const uint8_t* data, uint16_t length);
+    void beginArray(uint16_t count);
+    void beginMap(uint16_t count);
+
+    // Pairs of a map with a text key
+    void addUInt(const char* key, uint32_t value);
+    void addInt(const char* key, int32_t value);
+    void addFloat(const char* key, float value);
+    void addBool(const char* key, bool value);
+    void addString(const char* key, const char* value);
+
+    // Length of the document (the length required if the buffer is too small)
+    uint16_t getLength();
+    // True if the document doesn't fit in the buffer
+    bool hasError();
+
+  protected:
+    // Head of an item: major type and argument on the shortest form
+    void writeHead(uint8_t major, uint32_t argument);
+    void writeByte(uint8_t value);
+    void writeData(const uint8_t* data, uint16_t length, bool inFlash);
+
+  private:
+    uint8_t* buffer = NULL;
+    uint16_t size = 0;
+    Print* output = NULL;
+    uint16_t length = 0;
+    bool error = false;
+};
+
+// Callback encoding the document, called once to count its length and once to write it
+typedef void (*SIM800LCborCallback)(SIM800LCborEncoder* encoder, void* context);
+
+// CBOR body of a HTTP POST encoded straight to the module, without buffer
+class SIM800LCborPayload : public SIM800LPayload {
+  public:
+    SIM800LCborPayload(SIM800LCborCallback _callback, void* _context = NULL);
+
+    // Payload interface
+    const char* getContentType();
+    uint16_t getLength();
+    void writeTo(Print* output);
+
+  private:
+    SIM800LCborCallback callback;
+    void* context;
+};
+
+#endif // _SIM800L_CBOR_H_
@@ -0,0 +1,424 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM800LJson.h"
+
+// States of the parser
+#define JSON_VALUE 0      // Expecting a value
+#define JSON_KEY 1        // Expecting a key (or the end of the object)
+#define JSON_COLON 2      // Expecting the colon after a key
+#define JSON_NEXT 3       // Expecting a comma or the end of the container
+#define JSON_STRING 4     // In a string (key or value)
+#define JSON_ESCAPE 5     // After a backslash in a string
+#define JSON_UNICODE 6    // In an escaped unicode character (\uXXXX)
+#define JSON_LITERAL 7    // In a number or a literal (true, false, null)
+#define JSON_DONE 8       // End of the document
+
+/**
+ * Define a path to extract ("key.subkey" or "array.2.key")
+ * Returns the index of the slot, -1 if no more slot available
+ */
+int8_t SIM800LJsonScanner::addPath(const char* path, char* value, uint8_t size) {
+  if(slotCount >= SIM800L_JSON_MAX_PATHS || size == 0) {
+    return -1;
+  }
+
+  slots[slotCount].path = path;
+  slots[slotCount].value = value;
+  slots[slotCount].size = size;
+  slots[slotCount].found = false;
+  value[0] = '\0';
+  return slotCount++;
+}
+
+/**
+ * Restart the scanner for a new document, the values are cleared
+ */
+void SIM800LJsonScanner::reset() {
+  for(uint8_t i = 0; i < slotCount; i++) {
+    slots[i].value[0] = '\0';
+    slots[i].found = false;
+  }
+  depth = 0;
+  state = JSON_VALUE;
+  matching = 0;
+  capturing = 0;
+  inKey = false;
+  error = false;
+}
+
+/**
+ * Return true if the value of the slot has been found
+ */
+bool SIM800LJsonScanner::isFound(uint8_t index) {
+  return index < slotCount && slots[index].found;
+}
+
+/**
+ * Return true if the end of the document has been reached
+ */
+bool SIM800LJsonScanner::isComplete() {
+  return state == JSON_DONE;
+}
+
+/**
+ * Return true if the document is not valid JSON
+ */
+bool SIM800LJsonScanner::hasError() {
+  return error;
+}
+
+/**
+ * Parse the next chunk of the document (a new document starts at offset 0)
+ */
+bool SIM800LJsonScanner::write(uint32_t offset, const uint8_t* data, uint16_t length) {
+  if(offset == 0) {
+    reset();
+  }
+
+  for(uint16_t i = 0; i < length && !error; i++) {
+    error = !parse(data[i]);
+  }
+  return !error;
+}
+
+/**
+ * Parse the next character of the document
+ * Returns false if the character is not expected
+ */
+bool SIM800LJsonScanner::parse(char c) {
+  // Content of the strings and literals
+  switch(state) {
+    case JSON_STRING :
+      if(c == '"') {
+        if(inKey) {
+          matchKeyEnd();
+          state = JSON_COLON;
+        } else {
+          endValue();
+        }
+      } else if(c == '\\') {
+        state = JSON_ESCAPE;
+      } else {
+        append(c);
+      }
+      return true;
+
+    case JSON_ESCAPE :
+      switch(c) {
+        case 'b' : c = '\b'; break;
+        case 'f' : c = '\f'; break;
+        case 'n' : c = '\n'; break;
+        case 'r' : c = '\r'; break;
+        case 't' : c = '\t'; break;
+        case '"' : break;
+        case '\\' : break;
+        case '/' : break;
+        case 'u' :
+          unicode = 0;
+          unicodeDigits = 0;
+          state = JSON_UNICODE;
+          return true;
+        default :
+          return false;
+      }
+      append(c);
+      state = JSON_STRING;
+      return true;
+
+    case JSON_UNICODE :
+      if(!isxdigit(c)) {
+        return false;
+      }
+      unicode = (unicode << 4) | (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+      if(++unicodeDigits < 4) {
+        return true;
+      }
+
+      // Encode the character in UTF-8
+      if(unicode < 0x80) {
+        append(unicode);
+      } else if(unicode < 0x800) {
+        append(0xC0 | (unicode >> 6));
+        append(0x80 | (unicode & 0x3F));
+      } else {
+        append(0xE0 | (unicode >> 12));
+        append(0x80 | ((unicode >> 6) & 0x3F));
+        append(0x80 | (unicode & 0x3F));
+      }
+      state = JSON_STRING;
+      return true;
+
+    case JSON_LITERAL :
+      if(isalnum(c) || c == '.' || c == '+' || c == '-') {
+        capture(c);
+        return true;
+      }
+      // End of the literal, the character is part of the structure
+      endValue();
+      break;
+  }
+
+  // Structure of the document
+  if(c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+    return true;
+  }
+
+  switch(state) {
+    case JSON_VALUE :
+      // Empty array
+      if(c == ']' && depth > 0 && isArray[depth - 1]) {
+        depth--;
+        endValue();
+        return true;
+      }
+      return startValue(c);
+
+    case JSON_KEY :
+      if(c == '"') {
+        inKey = true;
+        keyLength = 0;
+        matching = candidates[depth - 1];
+        state = JSON_STRING;
+        return true;
+      }
+      // Empty object
+      if(c == '}') {
+        depth--;
+        endValue();
+        return true;
+      }
+      return false;
+
+    case JSON_COLON :
+      if(c == ':') {
+        inKey = false;
+        state = JSON_VALUE;
+        return true;
+      }
+      return false;
+
+    case JSON_NEXT :
+      if(c == ',') {
+        if(isArray[depth - 1]) {
+          arrayIndex[depth - 1]++;
+          matchIndex();
+          state = JSON_VALUE;
+        } else {
+          state = JSON_KEY;
+        }
+        return true;
+      }
+      if(c == (isArray[depth - 1] ? ']' : '}')) {
+        depth--;
+        endValue();
+        return true;
+      }
+      return false;
+  }
+
+  // Nothing expected after the end of the document
+  return false;
+}
+
+/**
+ * Start a value: the paths ending on this value capture it,
+ * the others continue in the container
+ */
+bool SIM800LJsonScanner::startValue(char c) {
+  uint16_t ending = 0;
+  uint16_t continuing = 0;
+  if(depth == 0) {
+    continuing = (1 << slotCount) - 1;
+  } else {
+    for(uint8_t i = 0; i < slotCount; i++) {
+      uint8_t length = 0;
+      const char* segment = getSegment(i, depth - 1, &length);
+      if((matching & (1 << i)) && segment != NULL) {
+        if(segment[length] == '\0') {
+          ending |= 1 << i;
+        } else {
+          continuing |= 1 << i;
+        }
+      }
+    }
+  }
+
+  // Containers: only the paths continuing are followed (a path ending on a container is found but empty)
+  if(c == '{' || c == '[') {
+    if(depth >= SIM800L_JSON_MAX_DEPTH) {
+      return false;
+    }
+    for(uint8_t i = 0; i < slotCount; i++) {
+      if(ending & (1 << i)) {
+        slots[i].found = true;
+      }
+    }
+
+    isArray[depth] = c == '[';
+    arrayIndex[depth] = 0;
+    candidates[depth] = continuing;
+    depth++;
+    if(c == '[') {
+      matchIndex();
+      state = JSON_VALUE;
+    } else {
+      state = JSON_KEY;
+    }
+    return true;
+  }
+
+  // Strings and literals
+  capturing = ending;
+  valueLength = 0;
+  if(c == '"') {
+    inKey = false;
+    state = JSON_STRING;
+    return true;
+  }
+  if(isalnum(c) || c == '-') {
+    state = JSON_LITERAL;
+    capture(c);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * End of a value (string, literal or container)
+ */
+void SIM800LJsonScanner::endValue() {
+  for(uint8_t i = 0; i < slotCount; i++) {
+    if(capturing & (1 << i)) {
+      slots[i].found = true;
+    }
+  }
+  capturing = 0;
+  state = depth == 0 ? JSON_DONE : JSON_NEXT;
+}
+
+/**
+ * Find the paths matching the current index of the array
+ */
+void SIM800LJsonScanner::matchIndex() {
+  matching = 0;
+  for(uint8_t i = 0; i < slotCount; i++) {
+    uint8_t length = 0;
+    const char* segment = getSegment(i, depth - 1, &length);
+    if(!(candidates[depth - 1] & (1 << i)) || segment == NULL || length == 0) {
+      continue;
+    }
+
+    uint16_t index = 0;
+    uint8_t j = 0;
+    for(; j < length && isdigit(segment[j]); j++) {
+      index = index * 10 + segment[j] - '0';
+    }
+    if(j == length && index == arrayIndex[depth - 1]) {
+      matching |= 1 << i;
+    }
+  }
+}
+
+/**
+ * Compare the next character of the key with the paths still matching
+ */
+void SIM800LJsonScanner::matchKeyChar(char c) {
+  for(uint8_t i = 0; i < slotCount; i++) {
+    uint8_t length = 0;
+    const char* segment = getSegment(i, depth - 1, &length);
+    if(segment == NULL || keyLength >= length || segment[keyLength] != c) {
+      matching &= ~(1 << i);
+    }
+  }
+  if(keyLength < 255) {
+    keyLength++;
+  }
+}
+
+/**
+ * Keep only the paths matching the whole key
+ */
+void SIM800LJsonScanner::matchKeyEnd() {
+  for(uint8_t i = 0; i < slotCount; i++) {
+    uint8_t length = 0;
+    const char* segment = getSegment(i, depth - 1, &length);
+    if(segment == NULL || keyLength != length) {
+      matching &= ~(1 << i);
+    }
+  }
+}
+
+/**
+ * Find the segment of a path at a specific depth (segments are separated by dots)
+ * Returns NULL if the path is shorter
+ */
+const char* SIM800LJsonScanner::getSegment(uint8_t index, uint8_t segmentDepth, uint8_t* length) {
+  const char* segment = slots[index].path;
+  for(uint8_t i = 0; i < segmentDepth; i++) {
+    segment = strchr(segment, '.');
+    if(segment == NULL) {
+      return NULL;
+    }
+    segment++;
+  }
+  *length = strcspn(segment, ".");
+  return segment;
+}
+
+/**
+ * Add a character of a string to the key or to the value
+ */
+void SIM800LJsonScanner::append(char c) {
+  if(inKey) {
+    matchKeyChar(c);
+  } else {
+    capture(c);
+  }
+}
+
+/**
+ * Append a character to the values captured (truncated to the size of the slot)
+ */
+void SIM800LJsonScanner::capture(char c) {
+  if(capturing == 0) {
+    return;
+  }
+
+  for(uint8_t i = 0; i < slotCount; i++) {
+    if((capturing & (1 << i)) && valueLength < slots[i].size - 1) {
+      slots[i].value[valueLength] = c;
+      slots[i].value[valueLength + 1] = '\0';
+    }
+  }
+  if(valueLength < 255) {
+    valueLength++;
+  }
+}
@@ -0,0 +1,113 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM800L_JSON_H_
+#define _SIM800L_JSON_H_
+
+#include <Arduino.h>
+#include "SIM800L.h"
+
+#define SIM800L_JSON_MAX_PATHS 8     // Maximum number of paths extracted (16 max)
+#define SIM800L_JSON_MAX_DEPTH 8     // Maximum nesting of objects and arrays
+
+// Value extracted from the JSON document
+struct SIM800LJsonSlot {
+  const char* path;   // Path of the value ("data.items.0.id": keys and indexes separated by dots)
+  char* value;        // Destination of the value (NUL terminated, truncated to the size)
+  uint8_t size;       // Size of the destination
+  bool found;         // True if the value has been found in the document
+};
+
+// Streaming JSON scanner: the document is parsed as it arrives and only the values
+// of the paths defined are kept, so the document is never stored in memory.
+// Strings are unescaped, numbers and literals (true, false, null) are kept as text.
+// The scanner is reset when the first chunk of a new document is written (offset 0).
+class SIM800LJsonScanner : public SIM800LSink {
+  public:
+    // Define a path to extract, returns the index of the slot (-1 if no more slot available)
+    int8_t addPath(const char* path, char* value, uint8_t size);
+
+    // Restart the scanner for a new document (the values are cleared)
+    void reset();
+
+    // Results of the scan
+    bool isFound(uint8_t index);
+    bool isComplete();
+    bool hasError();
+
+    // Sink interface: parse the next chunk of the document
+    // Returns false if the document is not valid JSON
+    bool write(uint32_t offset, const uint8_t* data, uint16_t length);
+
+  protected:
+    // Parse the next character of the document
+    bool parse(char c);
+
+    // Start and end of a value
+    bool startValue(char c);
+    void endValue();
+
+    // Paths matching the current key or the current index of an array
+    void matchIndex();
+    void matchKeyChar(char c);
+    void matchKeyEnd();
+
+    // Find the segment of a path at a specific depth (NULL if the path is shorter)
+    const char* getSegment(uint8_t index, uint8_t segmentDepth, uint8_t* length);
+
+    // Add a character of a string to the key or to the value
+    void append(char c);
+    // Append a character to the values captured
+    void capture(char c);
+
+  private:
+    // Paths to extract
+    SIM800LJsonSlot slots[SIM800L_JSON_MAX_PATHS];
+    uint8_t slotCount = 0;
+
+    // Stack of containers (arrays and objects) with the paths matching the container
+    bool isArray[SIM800L_JSON_MAX_DEPTH];
+    uint16_t arrayIndex[SIM800L_JSON_MAX_DEPTH];
+    uint16_t candidates[SIM800L_JSON_MAX_DEPTH];
+    uint8_t depth = 0;
+
+    // State of the parser
+    uint8_t state = 0;
+    uint16_t matching = 0;         // Paths matching the current key or index
+    uint16_t capturing = 0;        // Paths capturing the current value
+    uint8_t keyLength = 0;
+    uint8_t valueLength = 0;
+    bool inKey = false;
+    uint8_t unicodeDigits = 0;
+    uint16_t unicode = 0;
+    bool error = false;
+};
+
+#endif // _SIM800L_JSON_H_
@@ -0,0 +1,315 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM800LPool.h"
+
+/**
+ * Add a module to the pool
+ * Returns false if the pool is full
+ */
+bool SIM800LPool::addModem(SIM800L* modem) {
+  if(modemCount >= SIM800L_POOL_MAX_MODEMS) {
+    return false;
+  }
+
+  modems[modemCount] = modem;
+  stats[modemCount] = SIM800LModemStats();
+  busy[modemCount] = false;
+  modemCount++;
+  return true;
+}
+
+/**
+ * Queue a HTTP/S GET request
+ * Returns false if the queue is full
+ */
+bool SIM800LPool::enqueueGet(const char* url, const char* headers, uint16_t serverReadTimeoutMs, SIM800LPoolCallback callback, void* context) {
+  SIM800LPoolRequest request = {url, headers, NULL, NULL, 0, serverReadTimeoutMs, callback, context, 0, 0};
+  return enqueue(&request);
+}
+
+/**
+ * Queue a HTTP/S POST request
+ * Returns false if the queue is full
+ */
+bool SIM800LPool::enqueuePost(const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs, SIM800LPoolCallback callback, void* context) {
+  SIM800LPoolRequest request = {url, headers, contentType, payload, clientWriteTimeoutMs, serverReadTimeoutMs, callback, context, 0, 0};
+  return enqueue(&request);
+}
+
+/**
+ * Collect the answers of the running requests and dispatch the queued
+ * requests on the idle modules. The modules wait for the servers in parallel.
+ * A request failed by a module or the network (timeout included) is moved to
+ * another module, up to SIM800L_POOL_MAX_ATTEMPTS (a POST is sent again).
+ */
+void SIM800LPool::loop() {
+  // Collect the answers (or the timeouts) of the running requests
+  for(uint8_t i = 0; i < modemCount; i++) {
+    if(!busy[i]) {
+      continue;
+    }
+
+    uint32_t elapsed = millis() - startTime[i];
+    if(modems[i]->isHTTPAnswerAvailable() || elapsed >= running[i].serverReadTimeoutMs) {
+      uint16_t remaining = elapsed < running[i].serverReadTimeoutMs ? running[i].serverReadTimeoutMs - elapsed : 1;
+      complete(i, modems[i]->finishHTTP(remaining));
+    }
+  }
+
+  // Dispatch the queued requests (a module which fails to start is not selected again in this pass,
+  // the modules which already failed a request are used for it only if no other one is idle)
+  uint8_t failedModems = 0;
+  while(queueCount > 0) {
+    SIM800LPoolRequest* request = &queue[queueHead];
+    int8_t index = selectModem(failedModems | request->failedModems);
+    if(index < 0) {
+      index = selectModem(failedModems);
+    }
+    if(index < 0) {
+      break;
+    }
+
+    request->attempts++;
+
+    uint32_t start = millis();
+    uint16_t startRC;
+    if(request->payload == NULL) {
+      startRC = modems[index]->startGet(request->url, request->headers);
+    } else {
+      startRC = modems[index]->startPost(request->url, request->headers, request->contentType, request->payload, request->clientWriteTimeoutMs);
+    }
+
+    if(startRC == 0) {
+      // The module is waiting for the server
+      running[index] = *request;
+      busy[index] = true;
+      startTime[index] = start;
+      if(runningCount == 0) {
+        activeSince = start;
+      }
+      runningCount++;
+      dequeue();
+    } else {
+      // The module is not able to start the request, try another one
+      failedModems |= 1 << index;
+      request->failedModems |= 1 << index;
+      recordResult(index, startRC, millis() - start, 0);
+      if(request->attempts >= SIM800L_POOL_MAX_ATTEMPTS) {
+        SIM800LPoolRequest failed = *request;
+        dequeue();
+        if(failed.callback != NULL) {
+          failed.callback(modems[index], startRC, failed.context);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Check if there is no request queued or running
+ */
+bool SIM800LPool::isIdle() {
+  return queueCount == 0 && runningCount == 0;
+}
+
+/**
+ * Return the number of requests waiting for a module
+ */
+uint8_t SIM800LPool::getQueueSize() {
+  return queueCount;
+}
+
+/**
+ * Return the number of modules in the pool
+ */
+uint8_t SIM800LPool::getModemCount() {
+  return modemCount;
+}
+
+/**
+ * Check if a module is degraded (too many consecutive failures)
+ */
+bool SIM800LPool::isDegraded(uint8_t index) {
+  return index < modemCount && stats[index].degradedSince != 0;
+}
+
+/**
+ * Return the statistics of a module (NULL if the index is invalid)
+ */
+SIM800LModemStats* SIM800LPool::getStats(uint8_t index) {
+  if(index >= modemCount) {
+    return NULL;
+  }
+  return &stats[index];
+}
+
+/**
+ * Return the aggregate throughput of the pool in bytes per second,
+ * measured on the time spent with at least one request running
+ */
+uint32_t SIM800LPool::getThroughput() {
+  uint32_t elapsed = activeTime;
+  if(runningCount > 0) {
+    elapsed += millis() - activeSince;
+  }
+  if(elapsed == 0) {
+    return 0;
+  }
+  return (uint64_t)totalBytes * 1000 / elapsed;
+}
+
+/*****************************************************************************************
+ * HELPERS
+ *****************************************************************************************/
+/**
+ * Select the idle module with the least consecutive failures, then the lowest latency
+ * Degraded modules are skipped until the degradation delay is over, as well as the
+ * modules in the excluded mask (bit i for the module i)
+ */
+int8_t SIM800LPool::selectModem(uint8_t excluded) {
+  int8_t best = -1;
+  for(uint8_t i = 0; i < modemCount; i++) {
+    if(busy[i] || (excluded & (1 << i))) {
+      continue;
+    }
+    if(stats[i].degradedSince != 0 && millis() - stats[i].degradedSince < SIM800L_POOL_DEGRADED_DELAY) {
+      continue;
+    }
+    if(best < 0
+      || stats[i].consecutiveFailures < stats[best].consecutiveFailures
+      || (stats[i].consecutiveFailures == stats[best].consecutiveFailures && stats[i].latencyMs < stats[best].latencyMs)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+/**
+ * Release the module at the end of a request and notify the caller, or put
+ * the request back at the head of the queue if the module or the network failed
+ */
+void SIM800LPool::complete(uint8_t index, uint16_t httpRC) {
+  busy[index] = false;
+  runningCount--;
+  if(runningCount == 0) {
+    activeTime += millis() - activeSince;
+  }
+
+  uint32_t bytes = 0;
+  if(running[index].payload != NULL) {
+    bytes += strlen(running[index].payload);
+  }
+  if(httpRC == 200) {
+    bytes += modems[index]->getDataSizeReceived();
+  }
+  recordResult(index, httpRC, millis() - startTime[index], bytes);
+
+  if(isFailure(httpRC) && running[index].attempts < SIM800L_POOL_MAX_ATTEMPTS) {
+    running[index].failedModems |= 1 << index;
+    if(requeue(&running[index])) {
+      return;
+    }
+  }
+
+  if(running[index].callback != NULL) {
+    running[index].callback(modems[index], httpRC, running[index].context);
+  }
+}
+
+/**
+ * Check if a result is a failure of the module or the network
+ * HTTP status codes come from the server: only timeouts and module errors (6xx/7xx) are failures
+ */
+bool SIM800LPool::isFailure(uint16_t httpRC) {
+  return httpRC == 408 || httpRC >= 600;
+}
+
+/**
+ * Update the health and the latency of a module
+ */
+void SIM800LPool::recordResult(uint8_t index, uint16_t httpRC, uint32_t latencyMs, uint32_t bytes) {
+  SIM800LModemStats* modemStats = &stats[index];
+  modemStats->requests++;
+  modemStats->bytes += bytes;
+  totalBytes += bytes;
+
+  if(isFailure(httpRC)) {
+    modemStats->failures++;
+    if(modemStats->consecutiveFailures < 255) {
+      modemStats->consecutiveFailures++;
+    }
+    if(modemStats->consecutiveFailures >= SIM800L_POOL_MAX_FAILURES) {
+      // Never 0 to keep the module flagged as degraded
+      modemStats->degradedSince = millis() | 1;
+    }
+  } else {
+    modemStats->consecutiveFailures = 0;
+    modemStats->degradedSince = 0;
+    if(modemStats->latencyMs == 0) {
+      modemStats->latencyMs = latencyMs;
+    } else {
+      modemStats->latencyMs = (modemStats->latencyMs * 7 + latencyMs) / 8;
+    }
+  }
+}
+
+/**
+ * Add a request at the end of the queue
+ */
+bool SIM800LPool::enqueue(SIM800LPoolRequest* request) {
+  if(queueCount >= SIM800L_POOL_QUEUE_SIZE) {
+    return false;
+  }
+  queue[(queueHead + queueCount) % SIM800L_POOL_QUEUE_SIZE] = *request;
+  queueCount++;
+  return true;
+}
+
+/**
+ * Put a request back at the head of the queue
+ */
+bool SIM800LPool::requeue(SIM800LPoolRequest* request) {
+  if(queueCount >= SIM800L_POOL_QUEUE_SIZE) {
+    return false;
+  }
+  queueHead = (queueHead + SIM800L_POOL_QUEUE_SIZE - 1) % SIM800L_POOL_QUEUE_SIZE;
+  queue[queueHead] = *request;
+  queueCount++;
+  return true;
+}
+
+/**
+ * Remove the request at the head of the queue
+ */
+void SIM800LPool::dequeue() {
+  queueHead = (queueHead + 1) % SIM800L_POOL_QUEUE_SIZE;
+  queueCount--;
+}
@@ -0,0 +1,127 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM800L_POOL_H_
+#define _SIM800L_POOL_H_
+
+#include <Arduino.h>
+#include "SIM800L.h"
+
+#define SIM800L_POOL_MAX_MODEMS 4           // Maximum number of modules in the pool
+#define SIM800L_POOL_QUEUE_SIZE 8           // Maximum number of requests waiting for a module
+#define SIM800L_POOL_MAX_ATTEMPTS 3         // Number of modules tried before giving up a request
+#define SIM800L_POOL_MAX_FAILURES 3         // Consecutive failures before a module is degraded
+#define SIM800L_POOL_DEGRADED_DELAY 60000   // Time in millisec before a degraded module is tried again
+
+// Called when a request is finished (the data received is available through the modem)
+typedef void (*SIM800LPoolCallback)(SIM800L* modem, uint16_t httpRC, void* context);
+
+// Request waiting in the pool (the strings must stay valid until the callback)
+struct SIM800LPoolRequest {
+  const char* url;
+  const char* headers;
+  const char* contentType;      // NULL for GET
+  const char* payload;          // NULL for GET
+  uint16_t clientWriteTimeoutMs;
+  uint16_t serverReadTimeoutMs;
+  SIM800LPoolCallback callback;
+  void* context;
+  uint8_t attempts;
+  uint8_t failedModems;         // Modules which failed the request (bit i for the module i)
+};
+
+// Health and latency of a module of the pool
+struct SIM800LModemStats {
+  uint32_t requests = 0;           // Number of requests handled
+  uint32_t failures = 0;           // Number of requests failed because of the module or the network
+  uint8_t consecutiveFailures = 0; // Failures since the last success
+  uint32_t latencyMs = 0;          // Average latency of the requests (EWMA)
+  uint32_t bytes = 0;              // Number of bytes sent and received
+  uint32_t degradedSince = 0;      // Time of the degradation (0 if healthy)
+};
+
+class SIM800LPool {
+  public:
+    // Add a module to the pool (each module should have its own hardware serial)
+    bool addModem(SIM800L* modem);
+
+    // Queue a request, it will be sent by the best idle module
+    bool enqueueGet(const char* url, const char* headers, uint16_t serverReadTimeoutMs, SIM800LPoolCallback callback, void* context = NULL);
+    bool enqueuePost(const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs, SIM800LPoolCallback callback, void* context = NULL);
+
+    // Dispatch the queued requests and collect the answers, to call as often as possible
+    void loop();
+
+    // Status of the pool
+    bool isIdle();
+    uint8_t getQueueSize();
+    uint8_t getModemCount();
+    bool isDegraded(uint8_t index);
+    SIM800LModemStats* getStats(uint8_t index);
+
+    // Aggregate throughput of the pool in bytes per second (time spent with at least one request running)
+    uint32_t getThroughput();
+
+  protected:
+    // Select the best idle module for the next request, excluding a mask of modules (-1 if none)
+    int8_t selectModem(uint8_t excluded = 0);
+
+    // Manage the result of a request (failed requests are moved to another module)
+    void complete(uint8_t index, uint16_t httpRC);
+    bool isFailure(uint16_t httpRC);
+    void recordResult(uint8_t index, uint16_t httpRC, uint32_t latencyMs, uint32_t bytes);
+
+    // Manage the queue
+    bool enqueue(SIM800LPoolRequest* request);
+    bool requeue(SIM800LPoolRequest* request);
+    void dequeue();
+
+  private:
+    // Modules of the pool and their running request
+    SIM800L* modems[SIM800L_POOL_MAX_MODEMS];
+    SIM800LModemStats stats[SIM800L_POOL_MAX_MODEMS];
+    SIM800LPoolRequest running[SIM800L_POOL_MAX_MODEMS];
+    bool busy[SIM800L_POOL_MAX_MODEMS];
+    uint32_t startTime[SIM800L_POOL_MAX_MODEMS];
+    uint8_t modemCount = 0;
+
+    // Circular queue of requests
+    SIM800LPoolRequest queue[SIM800L_POOL_QUEUE_SIZE];
+    uint8_t queueHead = 0;
+    uint8_t queueCount = 0;
+
+    // Throughput measurement
+    uint32_t totalBytes = 0;
+    uint32_t activeTime = 0;
+    uint32_t activeSince = 0;
+    uint8_t runningCount = 0;
+};
+
+#endif // _SIM800L_POOL_H_
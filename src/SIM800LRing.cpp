@@ -0,0 +1,244 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM800LRing.h"
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+/**
+ * Constructor; allocate the ring buffer
+ */
+SIM800LRing::SIM800LRing(Stream* _stream, uint16_t _size) : head(0), tail(0) {
+  stream = _stream;
+  buffer = (uint8_t*) malloc(_size);
+  size = buffer != NULL ? _size : 0;
+}
+
+/**
+ * Destructor; cleanup the memory allocated
+ */
+SIM800LRing::~SIM800LRing() {
+  free(buffer);
+}
+
+/**
+ * Store a byte received at the head of the buffer (called by the single producer:
+ * the interrupt of the UART, a task or pump()). The byte is published with the head
+ */
+bool SIM800LRing::push(uint8_t c) {
+  // Only the producer writes the head, it is read without protection
+  uint16_t currentHead = head;
+  uint16_t next = currentHead + 1 < size ? currentHead + 1 : 0;
+  if(size == 0 || next == loadIndex(tail)) {
+    overflowCount = overflowCount + 1;
+    return false;
+  }
+  buffer[currentHead] = c;
+  storeIndex(head, next);
+  return true;
+}
+
+/**
+ * Enable or disable the push mode (bytes stored by the sketch with push() only)
+ */
+void SIM800LRing::setPushMode(bool enable) {
+  pushMode = enable;
+}
+
+/**
+ * Move the bytes available on the serial link while there is room in the buffer
+ * (nothing in push mode, another producer stores the bytes)
+ */
+uint16_t SIM800LRing::pump() {
+  if(pushMode) {
+    return 0;
+  }
+
+  uint16_t moved = 0;
+  while(stream->available() > 0) {
+    // Keep the bytes on the serial link if the buffer is full
+    uint16_t currentHead = head;
+    if((currentHead + 1 < size ? currentHead + 1 : 0) == loadIndex(tail)) {
+      break;
+    }
+    push(stream->read());
+    moved++;
+  }
+  return moved;
+}
+
+/**
+ * Return the number of contiguous bytes available from the read position
+ * (up to the end of the buffer) and a pointer to the first one
+ */
+uint16_t SIM800LRing::span(const uint8_t** data) {
+  pump();
+
+  // Only the driver writes the tail, it is read without protection
+  uint16_t currentHead = loadIndex(head);
+  uint16_t currentTail = tail;
+  *data = buffer + currentTail;
+  return currentHead >= currentTail ? currentHead - currentTail : size - currentTail;
+}
+
+/**
+ * Release the bytes processed from the read position
+ */
+void SIM800LRing::consume(uint16_t length) {
+  uint16_t next = tail + length;
+  if(next >= size) {
+    next -= size;
+  }
+  storeIndex(tail, next);
+}
+
+/**
+ * Read up to length bytes by spans, wait for the bytes missing until the timeout
+ */
+uint16_t SIM800LRing::read(uint8_t* data, uint16_t length, uint16_t timeout) {
+  uint16_t count = 0;
+  uint32_t timerStart = millis();
+  while(count < length) {
+    const uint8_t* chunk;
+    uint16_t chunkSize = span(&chunk);
+    if(chunkSize > 0) {
+      if(chunkSize > length - count) {
+        chunkSize = length - count;
+      }
+      memcpy(data + count, chunk, chunkSize);
+      consume(chunkSize);
+      count += chunkSize;
+      timerStart = millis();
+    } else if(millis() - timerStart > timeout) {
+      break;
+    }
+  }
+  return count;
+}
+
+/**
+ * Return the number of bytes lost because the buffer was full
+ */
+uint32_t SIM800LRing::getOverflowCount() {
+  return overflowCount;
+}
+
+/**
+ * Number of bytes available in the buffer
+ */
+int SIM800LRing::available() {
+  pump();
+
+  uint16_t currentHead = loadIndex(head);
+  uint16_t currentTail = tail;
+  return currentHead >= currentTail ? currentHead - currentTail : size - currentTail + currentHead;
+}
+
+/**
+ * Read a byte from the buffer
+ */
+int SIM800LRing::read() {
+  const uint8_t* data;
+  if(span(&data) == 0) {
+    return -1;
+  }
+  uint8_t c = *data;
+  consume(1);
+  return c;
+}
+
+/**
+ * Look at the next byte of the buffer without removing it
+ */
+int SIM800LRing::peek() {
+  const uint8_t* data;
+  if(span(&data) == 0) {
+    return -1;
+  }
+  return *data;
+}
+
+/**
+ * Wait for the end of the transmission to the module
+ */
+void SIM800LRing::flush() {
+  stream->flush();
+}
+
+/**
+ * Send a byte to the module
+ */
+size_t SIM800LRing::write(uint8_t c) {
+  return stream->write(c);
+}
+
+/**
+ * Send a block of bytes to the module
+ */
+size_t SIM800LRing::write(const uint8_t* data, size_t length) {
+  return stream->write(data, length);
+}
+
+/*****************************************************************************************
+ * HELPERS
+ *****************************************************************************************/
+/**
+ * Read an index written by the other side (the bytes before it are visible)
+ */
+uint16_t SIM800LRing::loadIndex(const SIM800LRingIndex& index) {
+#if defined(__AVR__)
+  // 16 bits read in two instructions: protected from the interrupts (the state of the
+  // interrupts is restored, push() can be called from an interrupt)
+  uint16_t value;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    value = index;
+  }
+  return value;
+#else
+  return index.load(std::memory_order_acquire);
+#endif
+}
+
+/**
+ * Write an index read by the other side (the bytes before it are published first)
+ */
+void SIM800LRing::storeIndex(SIM800LRingIndex& index, uint16_t value) {
+#if defined(__AVR__)
+  // The bytes of the buffer are written before the index (compiler barrier)
+  __asm__ __volatile__("" ::: "memory");
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    index = value;
+  }
+#else
+  index.store(value, std::memory_order_release);
+#endif
+}
@@ -0,0 +1,112 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM800L_RING_H_
+#define _SIM800L_RING_H_
+
+#include <Arduino.h>
+
+// The indexes are shared between the producer and the driver: on AVR (single core), their
+// 16 bits accesses are protected from the interrupts, elsewhere (ESP32, host) they are
+// atomic with acquire/release ordering so that the bytes are visible before the index
+#if defined(__AVR__)
+typedef volatile uint16_t SIM800LRingIndex;
+#else
+#include <atomic>
+typedef std::atomic<uint16_t> SIM800LRingIndex;
+#endif
+
+// Reception buffer between the serial link and the driver. The bytes received are stored
+// in a ring buffer of a configurable size, either moved from the serial link with pump()
+// (default, each time the driver looks for data), or stored with push() by a single other
+// producer: the interrupt of the UART, or the task/thread which receives the bytes
+// (setPushMode() to disable pump()). The driver consumes the contiguous spans of the buffer
+// instead of one byte per call. The bytes sent are forwarded to the serial link.
+class SIM800LRing : public Stream {
+  public:
+    // Initialize the ring buffer
+    // Parameters:
+    //  _stream : Stream opened to the SIM800L module (used for the bytes sent and by pump())
+    //  _size (optional) : size in bytes of the ring buffer
+    SIM800LRing(Stream* _stream, uint16_t _size = 256);
+    ~SIM800LRing();
+
+    // Store a byte received (interrupt safe, one producer only: enable the push mode first)
+    // Returns false if the buffer is full (the byte is lost)
+    bool push(uint8_t c);
+
+    // Enable/disable the push mode: the bytes are stored by push() only and pump() does
+    // nothing, so that the producer of the sketch is the only one
+    void setPushMode(bool enable);
+
+    // Move the bytes available on the serial link to the ring buffer (not in push mode)
+    // Returns the number of bytes moved
+    uint16_t pump();
+
+    // Contiguous bytes available from the read position (without copy) and release of
+    // the bytes processed
+    uint16_t span(const uint8_t** data);
+    void consume(uint16_t length);
+
+    // Read up to length bytes by spans (timeout in millisec)
+    // Returns the number of bytes read
+    uint16_t read(uint8_t* data, uint16_t length, uint16_t timeout);
+
+    // Number of bytes lost because the buffer was full
+    uint32_t getOverflowCount();
+
+    // Stream interface
+    int available();
+    int read();
+    int peek();
+    void flush();
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* data, size_t length);
+    using Print::write;
+
+  protected:
+    // Access to the indexes shared with the producer
+    uint16_t loadIndex(const SIM800LRingIndex& index);
+    void storeIndex(SIM800LRingIndex& index, uint16_t value);
+
+  private:
+    // Serial line with SIM800L
+    Stream* stream = NULL;
+
+    // Ring buffer: written at head by the producer, read at tail by the driver
+    uint8_t* buffer = NULL;
+    uint16_t size = 0;
+    SIM800LRingIndex head;
+    SIM800LRingIndex tail;
+    volatile uint32_t overflowCount = 0;
+    volatile bool pushMode = false;
+};
+
+#endif // _SIM800L_RING_H_
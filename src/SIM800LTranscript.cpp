@@ -0,0 +1,152 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM800LTranscript.h"
+
+#define TRANSCRIPT_TX 1
+#define TRANSCRIPT_RX 2
+
+/**
+ * Constructor
+ */
+SIM800LTranscript::SIM800LTranscript(Stream* _stream, Print* _log) {
+  stream = _stream;
+  log = _log;
+}
+
+/**
+ * Enable or disable the capture, the current record is closed
+ */
+void SIM800LTranscript::setCapture(bool enable) {
+  endRecord();
+  capture = enable;
+}
+
+/**
+ * Return the number of bytes sent to the module
+ */
+uint32_t SIM800LTranscript::getBytesSent() {
+  return bytesSent;
+}
+
+/**
+ * Return the number of bytes received from the module
+ */
+uint32_t SIM800LTranscript::getBytesReceived() {
+  return bytesReceived;
+}
+
+/**
+ * Number of bytes available from the module
+ */
+int SIM800LTranscript::available() {
+  return stream->available();
+}
+
+/**
+ * Read a byte from the module and log it
+ */
+int SIM800LTranscript::read() {
+  int c = stream->read();
+  if(c >= 0) {
+    bytesReceived++;
+    logByte(TRANSCRIPT_RX, c);
+  }
+  return c;
+}
+
+/**
+ * Next byte from the module (not logged, it will be when read)
+ */
+int SIM800LTranscript::peek() {
+  return stream->peek();
+}
+
+/**
+ * Wait for the end of the transmission to the module
+ */
+void SIM800LTranscript::flush() {
+  stream->flush();
+}
+
+/**
+ * Send a byte to the module and log it
+ */
+size_t SIM800LTranscript::write(uint8_t c) {
+  bytesSent++;
+  logByte(TRANSCRIPT_TX, c);
+  return stream->write(c);
+}
+
+/**
+ * Log a byte, starting a new record on each change of direction and each end of line
+ */
+void SIM800LTranscript::logByte(uint8_t _direction, uint8_t c) {
+  if(!capture) {
+    return;
+  }
+
+  if(_direction != direction || endOfLine) {
+    endRecord();
+    log->print(millis());
+    log->print(_direction == TRANSCRIPT_TX ? F(" TX \"") : F(" RX \""));
+    direction = _direction;
+  }
+
+  // Escape the non printable bytes
+  if(c == '\r') {
+    log->print(F("\\r"));
+  } else if(c == '\n') {
+    log->print(F("\\n"));
+  } else if(c == '"' || c == '\\') {
+    log->print('\\');
+    log->print((char)c);
+  } else if(c < 0x20 || c > 0x7E) {
+    const char digits[] = "0123456789ABCDEF";
+    log->print(F("\\x"));
+    log->print(digits[c >> 4]);
+    log->print(digits[c & 0x0F]);
+  } else {
+    log->print((char)c);
+  }
+
+  endOfLine = c == '\n';
+}
+
+/**
+ * Close the current record
+ */
+void SIM800LTranscript::endRecord() {
+  if(direction != 0) {
+    log->println('"');
+  }
+  direction = 0;
+  endOfLine = false;
+}
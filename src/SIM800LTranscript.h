@@ -0,0 +1,93 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM800L_TRANSCRIPT_H_
+#define _SIM800L_TRANSCRIPT_H_
+
+#include <Arduino.h>
+
+// Capture of the conversation with the module, to replay it on a host or to investigate
+// a firmware variation. Placed between the driver and the serial link, all the bytes
+// exchanged are forwarded and logged with a timestamp. A record is closed at each change
+// of direction and at each end of line, so a multi-line answer gives one record per line:
+//   <millis> TX "AT+CSQ\r\n"
+//   <millis> RX "\r\n"
+//   <millis> RX "+CSQ: 18,0\r\n"
+//   <millis> RX "\r\n"
+//   <millis> RX "OK\r\n"
+// Non printable bytes are escaped (\r, \n, \", \\ and \xHH). The timestamp is the time of
+// the first byte of the record (written or read by the driver). The transcripts are
+// replayed on a host by extras/test/replay.
+class SIM800LTranscript : public Stream {
+  public:
+    // Initialize the capture
+    // Parameters:
+    //  _stream : Stream opened to the SIM800L module
+    //  _log : destination of the transcript (Serial, SD card file...)
+    SIM800LTranscript(Stream* _stream, Print* _log);
+
+    // Enable/disable the capture (the bytes are always forwarded)
+    void setCapture(bool enable);
+
+    // Number of bytes sent to and received from the module
+    uint32_t getBytesSent();
+    uint32_t getBytesReceived();
+
+    // Stream interface
+    int available();
+    int read();
+    int peek();
+    void flush();
+    size_t write(uint8_t c);
+
+  protected:
+    // Log a byte, starting a new record on each change of direction and each end of line
+    void logByte(uint8_t direction, uint8_t c);
+    // Close the current record
+    void endRecord();
+
+  private:
+    // Serial line with SIM800L
+    Stream* stream = NULL;
+
+    // Destination of the transcript
+    Print* log = NULL;
+    bool capture = true;
+
+    // Current record (0 none, 1 TX, 2 RX)
+    uint8_t direction = 0;
+    bool endOfLine = false;
+
+    // Statistics
+    uint32_t bytesSent = 0;
+    uint32_t bytesReceived = 0;
+};
+
+#endif // _SIM800L_TRANSCRIPT_H_
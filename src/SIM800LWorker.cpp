@@ -0,0 +1,328 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#include "SIM800LWorker.h"
+
+#if defined(ESP32) || defined(SIM800L_WORKER_STD_THREAD)
+
+/**
+ * Constructor; the module should not be used directly once the worker is started
+ */
+SIM800LWorker::SIM800LWorker(SIM800L* _modem) {
+  modem = _modem;
+#if defined(ESP32)
+  lock = xSemaphoreCreateMutex();
+  pending = xSemaphoreCreateCounting(PRIORITY_NONE * SIM800L_WORKER_QUEUE_SIZE + 1, 0);
+  stopped = xSemaphoreCreateBinary();
+#endif
+}
+
+/**
+ * Destructor; stop the worker task
+ */
+SIM800LWorker::~SIM800LWorker() {
+  end();
+#if defined(ESP32)
+  vSemaphoreDelete(lock);
+  vSemaphoreDelete(pending);
+  vSemaphoreDelete(stopped);
+#endif
+}
+
+/**
+ * Start the worker task
+ * Returns false if the task can't be created
+ */
+bool SIM800LWorker::begin(uint8_t taskPriority) {
+  if(running) {
+    return true;
+  }
+  running = true;
+
+#if defined(ESP32)
+  if(lock == NULL || pending == NULL || stopped == NULL
+    || xTaskCreate(runTask, "SIM800L", SIM800L_WORKER_STACK_SIZE, this, taskPriority, &task) != pdPASS) {
+    running = false;
+    return false;
+  }
+#else
+  (void)taskPriority;
+  task = std::thread(&SIM800LWorker::run, this);
+#endif
+  return true;
+}
+
+/**
+ * Stop the worker task after the running request
+ */
+void SIM800LWorker::end() {
+  if(!running) {
+    return;
+  }
+
+#if defined(ESP32)
+  running = false;
+  xSemaphoreGive(pending);
+  xSemaphoreTake(stopped, portMAX_DELAY);
+  task = NULL;
+#else
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    running = false;
+  }
+  pending.notify_one();
+  task.join();
+#endif
+}
+
+/**
+ * Queue a HTTP/S GET request
+ * Returns false if the priority lane is full
+ */
+bool SIM800LWorker::submitGet(const char* url, const char* headers, uint16_t serverReadTimeoutMs, WorkerPriority priority, SIM800LFuture* future, SIM800LWorkerCallback callback, void* context) {
+  SIM800LWorkerRequest request = {url, headers, NULL, NULL, 0, serverReadTimeoutMs, NULL, callback, context, future};
+  return enqueue(&request, priority);
+}
+
+/**
+ * Queue a HTTP/S POST request
+ * Returns false if the priority lane is full
+ */
+bool SIM800LWorker::submitPost(const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs, WorkerPriority priority, SIM800LFuture* future, SIM800LWorkerCallback callback, void* context) {
+  SIM800LWorkerRequest request = {url, headers, contentType, payload, clientWriteTimeoutMs, serverReadTimeoutMs, NULL, callback, context, future};
+  return enqueue(&request, priority);
+}
+
+/**
+ * Queue a command using the module (status, SMS...)
+ * Returns false if the priority lane is full
+ */
+bool SIM800LWorker::submitCommand(SIM800LWorkerCommand command, void* context, WorkerPriority priority, SIM800LFuture* future, SIM800LWorkerCallback callback) {
+  SIM800LWorkerRequest request = {NULL, NULL, NULL, NULL, 0, 0, command, callback, context, future};
+  return enqueue(&request, priority);
+}
+
+/**
+ * Wait for the completion of a request
+ * Returns false on timeout
+ */
+bool SIM800LWorker::wait(SIM800LFuture* future, uint32_t timeoutMs) {
+#if defined(ESP32)
+  uint32_t start = millis();
+  bool signaled = false;
+  while(true) {
+    // The completion is read under the lock which published it (memory barrier), the
+    // semaphore is given back for the other tasks waiting for the same request
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool done = future->done;
+    SemaphoreHandle_t completion = future->completion;
+    if(done && signaled) {
+      xSemaphoreGive(completion);
+    }
+    xSemaphoreGive(lock);
+    if(done) {
+      return true;
+    }
+
+    // Block until the completion (a signal left by a previous use of the future is consumed)
+    uint32_t elapsed = millis() - start;
+    if(completion == NULL || elapsed >= timeoutMs) {
+      return false;
+    }
+    signaled = xSemaphoreTake(completion, pdMS_TO_TICKS(timeoutMs - elapsed)) == pdTRUE;
+    if(!signaled) {
+      return false;
+    }
+  }
+#else
+  std::unique_lock<std::mutex> guard(lock);
+  return completed.wait_for(guard, std::chrono::milliseconds(timeoutMs), [future] { return future->done; });
+#endif
+}
+
+/**
+ * Return the number of requests waiting in a priority lane
+ */
+uint8_t SIM800LWorker::getQueueSize(WorkerPriority priority) {
+  if(priority >= PRIORITY_NONE) {
+    return 0;
+  }
+
+#if defined(ESP32)
+  xSemaphoreTake(lock, portMAX_DELAY);
+  uint8_t count = queueCount[priority];
+  xSemaphoreGive(lock);
+#else
+  std::lock_guard<std::mutex> guard(lock);
+  uint8_t count = queueCount[priority];
+#endif
+  return count;
+}
+
+/*****************************************************************************************
+ * HELPERS
+ *****************************************************************************************/
+/**
+ * Add a request at the end of a priority lane and wake up the worker
+ */
+bool SIM800LWorker::enqueue(SIM800LWorkerRequest* request, WorkerPriority priority) {
+  if(priority >= PRIORITY_NONE) {
+    return false;
+  }
+
+#if defined(ESP32)
+  xSemaphoreTake(lock, portMAX_DELAY);
+#else
+  std::unique_lock<std::mutex> guard(lock);
+#endif
+
+  // The future is reset under the lock, like its completion (other tasks may be waiting for it)
+  if(request->future != NULL) {
+    request->future->done = false;
+    request->future->result = 0;
+#if defined(ESP32)
+    request->future->completion = xSemaphoreCreateBinaryStatic(&request->future->completionBuffer);
+#endif
+  }
+
+  bool queued = queueCount[priority] < SIM800L_WORKER_QUEUE_SIZE;
+  if(queued) {
+    queue[priority][(queueHead[priority] + queueCount[priority]) % SIM800L_WORKER_QUEUE_SIZE] = *request;
+    queueCount[priority]++;
+  }
+
+#if defined(ESP32)
+  xSemaphoreGive(lock);
+  if(queued) {
+    xSemaphoreGive(pending);
+  }
+#else
+  guard.unlock();
+  if(queued) {
+    pending.notify_one();
+  }
+#endif
+  return queued;
+}
+
+/**
+ * Wait for the next request, from the highest priority lane not empty
+ * Returns false when the worker is stopped
+ */
+bool SIM800LWorker::dequeue(SIM800LWorkerRequest* request) {
+#if defined(ESP32)
+  xSemaphoreTake(pending, portMAX_DELAY);
+  if(!running) {
+    return false;
+  }
+  xSemaphoreTake(lock, portMAX_DELAY);
+#else
+  std::unique_lock<std::mutex> guard(lock);
+  pending.wait(guard, [this] {
+    return !running || queueCount[PRIORITY_HIGH] + queueCount[PRIORITY_NORMAL] + queueCount[PRIORITY_LOW] > 0;
+  });
+  if(!running) {
+    return false;
+  }
+#endif
+
+  for(uint8_t priority = 0; priority < PRIORITY_NONE; priority++) {
+    if(queueCount[priority] > 0) {
+      *request = queue[priority][queueHead[priority]];
+      queueHead[priority] = (queueHead[priority] + 1) % SIM800L_WORKER_QUEUE_SIZE;
+      queueCount[priority]--;
+      break;
+    }
+  }
+
+#if defined(ESP32)
+  xSemaphoreGive(lock);
+#endif
+  return true;
+}
+
+/**
+ * Loop of the worker task: execute the requests until the worker is stopped
+ */
+void SIM800LWorker::run() {
+  SIM800LWorkerRequest request;
+  while(dequeue(&request)) {
+    execute(&request);
+  }
+}
+
+/**
+ * Execute a request with the module and complete it (callback then future)
+ */
+void SIM800LWorker::execute(SIM800LWorkerRequest* request) {
+  uint16_t result;
+  if(request->command != NULL) {
+    result = request->command(modem, request->context);
+  } else if(request->payload == NULL) {
+    result = modem->doGet(request->url, request->headers, request->serverReadTimeoutMs);
+  } else {
+    result = modem->doPost(request->url, request->headers, request->contentType, request->payload, request->clientWriteTimeoutMs, request->serverReadTimeoutMs);
+  }
+
+  if(request->callback != NULL) {
+    request->callback(modem, result, request->context);
+  }
+
+  if(request->future != NULL) {
+#if defined(ESP32)
+    xSemaphoreTake(lock, portMAX_DELAY);
+    request->future->result = result;
+    request->future->done = true;
+    // Given under the lock: the future may be released as soon as it is seen completed
+    xSemaphoreGive(request->future->completion);
+    xSemaphoreGive(lock);
+#else
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      request->future->result = result;
+      request->future->done = true;
+    }
+    completed.notify_all();
+#endif
+  }
+}
+
+#if defined(ESP32)
+/**
+ * Entry point of the worker task
+ */
+void SIM800LWorker::runTask(void* worker) {
+  ((SIM800LWorker*)worker)->run();
+  xSemaphoreGive(((SIM800LWorker*)worker)->stopped);
+  vTaskDelete(NULL);
+}
+#endif
+
+#endif // ESP32 || SIM800L_WORKER_STD_THREAD
@@ -0,0 +1,153 @@
+/********************************************************************************
+ * Arduino-SIM800L-driver                                                       *
+ * ----------------------                                                       *
+ * Arduino driver for GSM/GPRS module SIMCom SIM800L to make HTTP/S connections *
+ * with GET and POST methods                                                    *
+ * Author: Olivier Staquet                                                      *
+ * Last version available on https://github.com/ostaquet/Arduino-SIM800L-driver *
+ ********************************************************************************
+ * MIT License
+ *
+ * Copyright (c) 2019 Olivier Staquet
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *******************************************************************************/
+#ifndef _SIM800L_WORKER_H_
+#define _SIM800L_WORKER_H_
+
+#include <Arduino.h>
+#include "SIM800L.h"
+
+// The worker needs a multitasking environment: FreeRTOS on ESP32, std::thread on a host
+// (define SIM800L_WORKER_STD_THREAD to build it with the emulator)
+#if defined(ESP32) || defined(SIM800L_WORKER_STD_THREAD)
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#define SIM800L_WORKER_QUEUE_SIZE 4         // Maximum number of requests waiting in each priority lane
+#define SIM800L_WORKER_STACK_SIZE 8192      // Size of the stack of the worker task (ESP32)
+
+enum WorkerPriority {PRIORITY_HIGH, PRIORITY_NORMAL, PRIORITY_LOW, PRIORITY_NONE};
+
+// Command run by the worker with the exclusive access to the module (status, SMS...)
+typedef uint16_t (*SIM800LWorkerCommand)(SIM800L* modem, void* context);
+
+// Called by the worker when a request is finished, with the exclusive access to the module
+// (the data received is available through the modem until the return)
+typedef void (*SIM800LWorkerCallback)(SIM800L* modem, uint16_t result, void* context);
+
+// Result of a request, completed by the worker under the lock of the queues (must stay
+// valid until the completion, read it after wait())
+struct SIM800LFuture {
+  volatile bool done = false;
+  volatile uint16_t result = 0;
+#if defined(ESP32)
+  // Given by the worker at the completion (created without allocation when submitted)
+  SemaphoreHandle_t completion = NULL;
+  StaticSemaphore_t completionBuffer;
+#endif
+};
+
+// Request waiting in a priority lane (the strings must stay valid until the completion)
+struct SIM800LWorkerRequest {
+  const char* url;
+  const char* headers;
+  const char* contentType;      // NULL for GET
+  const char* payload;          // NULL for GET
+  uint16_t clientWriteTimeoutMs;
+  uint16_t serverReadTimeoutMs;
+  SIM800LWorkerCommand command; // NULL for HTTP requests
+  SIM800LWorkerCallback callback;
+  void* context;
+  SIM800LFuture* future;
+};
+
+// Front end sharing a module between several tasks. The requests are queued in priority
+// lanes and executed one by one by a worker task which is the only one to use the module.
+// The high priority requests are executed first (the running request is not interrupted).
+class SIM800LWorker {
+  public:
+    SIM800LWorker(SIM800L* _modem);
+    ~SIM800LWorker();
+
+    // Start/stop the worker task (the requests still queued are not executed)
+    bool begin(uint8_t taskPriority = 1);
+    void end();
+
+    // Queue a request (future and callback are optional)
+    // Returns false if the priority lane is full
+    bool submitGet(const char* url, const char* headers, uint16_t serverReadTimeoutMs, WorkerPriority priority, SIM800LFuture* future, SIM800LWorkerCallback callback = NULL, void* context = NULL);
+    bool submitPost(const char* url, const char* headers, const char* contentType, const char* payload, uint16_t clientWriteTimeoutMs, uint16_t serverReadTimeoutMs, WorkerPriority priority, SIM800LFuture* future, SIM800LWorkerCallback callback = NULL, void* context = NULL);
+    bool submitCommand(SIM800LWorkerCommand command, void* context, WorkerPriority priority, SIM800LFuture* future, SIM800LWorkerCallback callback = NULL);
+
+    // Wait for the completion of a request (timeout in millisec)
+    // Returns false on timeout
+    bool wait(SIM800LFuture* future, uint32_t timeoutMs);
+
+    // Number of requests waiting in a priority lane
+    uint8_t getQueueSize(WorkerPriority priority);
+
+  protected:
+    // Manage the priority lanes
+    bool enqueue(SIM800LWorkerRequest* request, WorkerPriority priority);
+    bool dequeue(SIM800LWorkerRequest* request);
+
+    // Loop of the worker task and execution of a request
+    void run();
+    void execute(SIM800LWorkerRequest* request);
+
+#if defined(ESP32)
+    static void runTask(void* worker);
+#endif
+
+  private:
+    // Module owned by the worker
+    SIM800L* modem = NULL;
+
+    // Circular queue of each priority lane
+    SIM800LWorkerRequest queue[PRIORITY_NONE][SIM800L_WORKER_QUEUE_SIZE];
+    uint8_t queueHead[PRIORITY_NONE] = {0};
+    uint8_t queueCount[PRIORITY_NONE] = {0};
+
+    // Worker task and synchronization (lock of the queues, requests pending, requests completed)
+    volatile bool running = false;
+#if defined(ESP32)
+    SemaphoreHandle_t lock = NULL;
+    SemaphoreHandle_t pending = NULL;
+    SemaphoreHandle_t stopped = NULL;
+    TaskHandle_t task = NULL;
+#else
+    std::mutex lock;
+    std::condition_variable pending;
+    std::condition_variable completed;
+    std::thread task;
+#endif
+};
+
+#endif // ESP32 || SIM800L_WORKER_STD_THREAD
+
+#endif // _SIM800L_WORKER_H_